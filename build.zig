@@ -28,16 +28,22 @@ pub fn buildExe(
     const sources = [_][]const u8{
         "args.cc",
         "bytecode.cc",
+        "cache.cc",
         "input.cc",
+        "layout.cc",
         "main.cc",
+        "minify.cc",
+        "perflint.cc",
         "reflection.cc",
         "spirv.cc",
         "spirvcross.cc",
         "util.cc",
+        "varyings.cc",
         "generators/bare.cc",
         "generators/generate.cc",
         "generators/generator.cc",
         "generators/sokolc.cc",
+        "generators/sokolcpp.cc",
         "generators/sokold.cc",
         "generators/sokolnim.cc",
         "generators/sokolodin.cc",
@@ -83,16 +89,49 @@ pub fn buildExe(
     exe.linkLibrary(libSpirvtools(b, target, mode, prefix_path));
     exe.linkLibrary(libGlslang(b, target, mode, prefix_path));
     exe.linkLibrary(libTint(b, target, mode, prefix_path));
+    if (exe.rootModuleTarget().os.tag == .windows) {
+        // sockets for the HTTP compile cache backend
+        exe.linkSystemLibrary("ws2_32");
+    }
     inline for (incl_dirs) |incl_dir| {
         exe.addIncludePath(b.path(prefix_path ++ incl_dir));
     }
+    // the compile cache build id is only passed to cache.cc, so that a changed
+    // build id doesn't recompile everything
+    const cache_flags = if (buildId(b, prefix_path)) |build_id|
+        std.mem.concat(b.allocator, []const u8, &.{ &flags, &.{b.fmt("-DSOKOL_SHDC_BUILD_ID=\"{s}\"", .{build_id})} }) catch @panic("OOM")
+    else
+        &flags;
     inline for (sources) |src| {
-        exe.addCSourceFile(.{ .file = b.path(dir ++ src), .flags = &flags });
+        const is_cache = comptime std.mem.eql(u8, src, "cache.cc");
+        exe.addCSourceFile(.{ .file = b.path(dir ++ src), .flags = if (is_cache) cache_flags else &flags });
     }
     b.installArtifact(exe);
     return exe;
 }
 
+// build id for the compile cache keys (see cache.cc and src/shdc/build_id.cmake):
+// the commit of the sokol-tools checkout (with a '-dirty' suffix for local changes)
+// and the commits of the ext/ submodules, null if this isn't a git checkout
+fn buildId(b: *Build, comptime prefix_path: []const u8) ?[]const u8 {
+    const root_dir = b.pathFromRoot(if (prefix_path.len == 0) "." else prefix_path);
+    var code: u8 = undefined;
+    const commit = b.runAllowFail(&.{ "git", "-C", root_dir, "rev-parse", "HEAD" }, &code, .Ignore) catch return null;
+    var build_id = std.mem.trim(u8, commit, " \r\n");
+    // also catches checked out submodule commits which differ from the recorded ones
+    const status = b.runAllowFail(&.{ "git", "-C", root_dir, "status", "--porcelain", "--untracked-files=no" }, &code, .Ignore) catch "";
+    if (std.mem.trim(u8, status, " \r\n").len > 0) {
+        build_id = b.fmt("{s}-dirty", .{build_id});
+    }
+    const exts = [_][]const u8{ "fmt", "getopt", "glslang", "pystring", "SPIRV-Cross", "SPIRV-Headers", "SPIRV-Tools", "tint-extract" };
+    for (exts) |ext| {
+        const ext_dir = b.pathJoin(&.{ root_dir, "ext", ext });
+        const ext_commit = b.runAllowFail(&.{ "git", "-C", ext_dir, "rev-parse", "HEAD" }, &code, .Ignore) catch "";
+        build_id = b.fmt("{s} {s}={s}", .{ build_id, ext, std.mem.trim(u8, ext_commit, " \r\n") });
+    }
+    return build_id;
+}
+
 fn libGetopt(
     b: *Build,
     target: Build.ResolvedTarget,
@@ -0,0 +1,50 @@
+'''
+    Minimal stand-in HTTP server for the sokol-shdc compile cache
+    (--cache=http://host:port/path), for local testing only.
+
+    Entries are stored in memory, 'GET [path]/[key]' returns an entry
+    or 404, 'PUT [path]/[key]' stores an entry.
+
+    Usage:
+
+    python3 cache-server.py [port]
+
+    NOTE: run with python3
+'''
+import sys
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+entries = {}
+lock = threading.Lock()
+
+class CacheHandler(BaseHTTPRequestHandler):
+    def do_GET(self):
+        with lock:
+            data = entries.get(self.path)
+        if data is None:
+            self.send_response(404)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+        else:
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/octet-stream')
+            self.send_header('Content-Length', str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+    def do_PUT(self):
+        length = int(self.headers.get('Content-Length', 0))
+        data = self.rfile.read(length)
+        with lock:
+            entries[self.path] = data
+        self.send_response(201)
+        self.send_header('Content-Length', '0')
+        self.end_headers()
+
+    def log_message(self, format, *args):
+        sys.stderr.write('%s %s\n' % (self.command, self.path))
+
+port = int(sys.argv[1]) if len(sys.argv) > 1 else 8090
+print('sokol-shdc cache server listening on port %d' % port)
+ThreadingHTTPServer(('127.0.0.1', port), CacheHandler).serve_forever()
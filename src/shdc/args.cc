@@ -30,6 +30,20 @@ enum {
     OPTION_SAVE_INTERMEDIATE_SPIRV,
     OPTION_NO_LOG_CMDLINE,
     OPTION_DEPENDENCY_FILE,
+    OPTION_OPT_LEVEL,
+    OPTION_MINIFY,
+    OPTION_LAYOUT_REPORT,
+    OPTION_CPP_UNIFORMS,
+    OPTION_SBUF_PACKERS,
+    OPTION_MAX_COST,
+    OPTION_PERF_LINT,
+    OPTION_CS_LIMITS,
+    OPTION_PACK_VARYINGS,
+    OPTION_SPEC,
+    OPTION_CACHE,
+    OPTION_SPLIT_OUTPUT,
+    OPTION_SPLIT_BACKENDS,
+    OPTION_EMBED_FILES,
 };
 
 static const getopt_option_t option_list[] = {
@@ -38,10 +52,11 @@ static const getopt_option_t option_list[] = {
     { "output",             'o', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OUTPUT,       "output source file", "C header" },
     { "slang",              'l', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_SLANG,        "output shader language(s), see above for list", "glsl430:glsl300es..." },
     { "defines",            0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_DEFINES,      "optional preprocessor defines", "define1:define2..." },
+    { "spec",               0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_SPEC,         "bake values into specialization constants", "name1=value1:name2=value2..." },
     { "module",             'm', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_MODULE,       "optional @module name override" },
     { "reflection",         'r', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_REFLECTION,   "generate runtime reflection functions" },
     { "bytecode",           'b', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_BYTECODE,     "output bytecode (HLSL and Metal)"},
-    { "format",             'f', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_FORMAT,       "output format (default: sokol)", "[sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_d|sokol_jai|sokol_c2|sokol_c3|bare|bare_yaml]" },
+    { "format",             'f', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_FORMAT,       "output format (default: sokol)", "[sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_d|sokol_jai|sokol_c2|sokol_c3|sokol_cpp|bare|bare_yaml]" },
     { "errfmt",             'e', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_ERRFMT,       "error message format (default: gcc)", "[gcc|msvc]"},
     { "dump",               'd', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_DUMP,         "dump debugging information to stderr"},
     { "genver",             'g', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_GENVER,       "version-stamp for code-generation", "[int]"},
@@ -51,6 +66,19 @@ static const getopt_option_t option_list[] = {
     { "save-intermediate-spirv", 0, GETOPT_OPTION_TYPE_NO_ARG,  0, OPTION_SAVE_INTERMEDIATE_SPIRV, "save intermediate SPIRV bytecode (for debug inspection)"},
     { "no-log-cmdline",     0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_NO_LOG_CMDLINE, "don't log the cmdline to the code-generated output file"},
     { "dependency-file",    0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_DEPENDENCY_FILE, "generate a Clang/GCC style dep-file for use with build systems", "[deps file]" },
+    { "opt-level",          0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OPT_LEVEL,    "SPIRV optimization level (default: 1)", "[0|s|1|2]" },
+    { "minify",             0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_MINIFY,       "minify generated shader source code (strip comments and whitespace, rename locals)"},
+    { "layout-report",      0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_LAYOUT_REPORT, "print uniform block and storage buffer padding report to stderr"},
+    { "cpp-uniforms",       0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_CPP_UNIFORMS, "generate C++ uniform block structs with typed members and dirty-range tracking (sokol and sokol_impl formats)"},
+    { "sbuf-packers",       0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_SBUF_PACKERS, "generate storage buffer struct pack/unpack functions for structure-of-arrays data (sokol and sokol_impl formats)"},
+    { "max-cost",           0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_MAX_COST,     "fail if the estimated cost of a shader exceeds a budget, either for all stages or per stage", "[N|vs=N:fs=N:cs=N]"},
+    { "perf-lint",          0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_PERF_LINT,    "warn about common GPU performance pitfalls in the shader source"},
+    { "cs-limits",          0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_CS_LIMITS,    "compute shader limits for the occupancy estimate (sizes in bytes or with 'k' suffix)", "shared=N:invocations=N:cu_shared=N:cu_invocations=N:cu_workgroups=N"},
+    { "pack-varyings",      0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_PACK_VARYINGS, "remove vertex shader outputs which are not read by the fragment shader and pack the remaining varyings"},
+    { "split-output",       0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_SPLIT_OUTPUT, "write one header per program plus a common header and an index header (sokol, sokol_impl and sokol_cpp formats)"},
+    { "split-backends",     0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_SPLIT_BACKENDS, "write the shader code of each shader language into a separate C file with a dispatching _shader_desc() in the header (sokol_impl format)"},
+    { "embed-files",        0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_EMBED_FILES,  "write shader code and bytecode into binary files referenced via C23 #embed/.incbin or the language's file embedding (all sokol formats except sokol_c2 and sokol_c3)"},
+    { "cache",              0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_CACHE,        "share compiled SPIRV, cross-compiled sources and bytecode through a cache directory or HTTP cache server", "[dir|file://dir|http://host:port/path]"},
     GETOPT_OPTIONS_END
 };
 
@@ -87,10 +115,11 @@ static void print_help_string(getopt_context_t& ctx) {
         "  - sokol_jai      Jai module file\n"
         "  - sokol_c2       C2 module file\n"
         "  - sokol_c3       C3 module file\n"
+        "  - sokol_cpp      C++20 header with constexpr reflection data\n"
         "  - bare           raw output of SPIRV-Cross compiler, in text or binary format\n"
         "  - bare_yaml      like bare, but with reflection file in YAML format\n\n"
         "Options:\n\n");
-    char buf[4096];
+    char buf[8192];
     fmt::print(stderr, "{}", getopt_create_help_string(&ctx, buf, sizeof(buf)));
 }
 
@@ -135,6 +164,114 @@ static bool parse_slang(Args& args, const char* str) {
     return true;
 }
 
+/* parse string of format 'N' or 'vs=N:fs=N:cs=N' into args.max_cost */
+static bool parse_max_cost(Args& args, const char* str) {
+
+    const auto parse_budget = [](const std::string& s, int& out_budget) {
+        if (s.empty() || (s.find_first_not_of("0123456789") != std::string::npos)) {
+            return false;
+        }
+        out_budget = atoi(s.c_str());
+        return true;
+    };
+
+    std::vector<std::string> splits;
+    pystring::split(str, splits, ":");
+    for (const auto& item : splits) {
+        std::vector<std::string> tokens;
+        pystring::split(item, tokens, "=");
+        bool item_valid = false;
+        if (tokens.size() == 1) {
+            int budget = 0;
+            if (parse_budget(tokens[0], budget)) {
+                args.max_cost[0] = args.max_cost[1] = args.max_cost[2] = budget;
+                item_valid = true;
+            }
+        } else if (tokens.size() == 2) {
+            int stage_index = -1;
+            if (tokens[0] == "vs") {
+                stage_index = 0;
+            } else if (tokens[0] == "fs") {
+                stage_index = 1;
+            } else if (tokens[0] == "cs") {
+                stage_index = 2;
+            }
+            if (stage_index != -1) {
+                item_valid = parse_budget(tokens[1], args.max_cost[stage_index]);
+            }
+        }
+        if (!item_valid) {
+            fmt::print(stderr, "sokol-shdc: invalid cost budget '{}' (must be N or vs=N:fs=N:cs=N)\n", item);
+            args.valid = false;
+            args.exit_code = 10;
+            return false;
+        }
+    }
+    return true;
+}
+
+/* parse string of format 'key=N:key=N...' into args.cs_limits */
+static bool parse_cs_limits(Args& args, const char* str) {
+
+    const auto parse_value = [](std::string s, int& out_value) {
+        int scale = 1;
+        if (!s.empty() && ((s.back() == 'k') || (s.back() == 'K'))) {
+            scale = 1024;
+            s.pop_back();
+        }
+        if (s.empty() || (s.find_first_not_of("0123456789") != std::string::npos)) {
+            return false;
+        }
+        out_value = atoi(s.c_str()) * scale;
+        return out_value > 0;
+    };
+
+    std::vector<std::string> splits;
+    pystring::split(str, splits, ":");
+    for (const auto& item : splits) {
+        std::vector<std::string> tokens;
+        pystring::split(item, tokens, "=");
+        int* value = nullptr;
+        if (tokens.size() == 2) {
+            if (tokens[0] == "shared") {
+                value = &args.cs_limits.max_shared_memory;
+            } else if (tokens[0] == "invocations") {
+                value = &args.cs_limits.max_invocations;
+            } else if (tokens[0] == "cu_shared") {
+                value = &args.cs_limits.cu_shared_memory;
+            } else if (tokens[0] == "cu_invocations") {
+                value = &args.cs_limits.cu_max_invocations;
+            } else if (tokens[0] == "cu_workgroups") {
+                value = &args.cs_limits.cu_max_workgroups;
+            }
+        }
+        if (!value || !parse_value(tokens[1], *value)) {
+            fmt::print(stderr, "sokol-shdc: invalid compute limit '{}' (valid keys: shared, invocations, cu_shared, cu_invocations, cu_workgroups)\n", item);
+            args.valid = false;
+            args.exit_code = 10;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_spec_constants(Args& args, const char* str) {
+    std::vector<std::string> splits;
+    pystring::split(str, splits, ":");
+    for (const auto& item : splits) {
+        std::vector<std::string> tokens;
+        pystring::split(item, tokens, "=");
+        if ((tokens.size() != 2) || tokens[0].empty() || tokens[1].empty()) {
+            fmt::print(stderr, "sokol-shdc: invalid specialization constant '{}' (expected name=value)\n", item);
+            args.valid = false;
+            args.exit_code = 10;
+            return false;
+        }
+        args.spec_constants[tokens[0]] = tokens[1];
+    }
+    return true;
+}
+
 static void validate(Args& args) {
     bool err = false;
     if (args.input.empty()) {
@@ -149,6 +286,22 @@ static void validate(Args& args) {
         fmt::print(stderr, "sokol-shdc: no shader languages (--slang ...)\n");
         err = true;
     }
+    if (args.split_output && (args.output_format != Format::SOKOL) && (args.output_format != Format::SOKOL_IMPL) && (args.output_format != Format::SOKOL_CPP)) {
+        fmt::print(stderr, "sokol-shdc: --split-output is only supported for the sokol, sokol_impl and sokol_cpp output formats\n");
+        err = true;
+    }
+    if (args.split_backends && (args.output_format != Format::SOKOL_IMPL)) {
+        fmt::print(stderr, "sokol-shdc: --split-backends is only supported for the sokol_impl output format\n");
+        err = true;
+    }
+    if (args.split_backends && args.split_output) {
+        fmt::print(stderr, "sokol-shdc: --split-backends can't be combined with --split-output\n");
+        err = true;
+    }
+    if (args.embed_files && ((args.output_format == Format::SOKOL_C2) || (args.output_format == Format::SOKOL_C3) || (args.output_format == Format::BARE) || (args.output_format == Format::BARE_YAML))) {
+        fmt::print(stderr, "sokol-shdc: --embed-files is not supported for the {} output format\n", Format::to_str(args.output_format));
+        err = true;
+    }
     if (args.tmpdir.empty()) {
         std::string tail;
         pystring::os::path::split(args.tmpdir, tail, args.output);
@@ -213,6 +366,12 @@ Args Args::parse(int argc, const char** argv) {
                 case OPTION_DEFINES:
                     pystring::split(ctx.current_opt_arg, args.defines, ":");
                     break;
+                case OPTION_SPEC:
+                    if (!parse_spec_constants(args, ctx.current_opt_arg)) {
+                        /* error details have been filled by parse_spec_constants() */
+                        return args;
+                    }
+                    break;
                 case OPTION_MODULE:
                     args.module = ctx.current_opt_arg;
                     break;
@@ -222,7 +381,7 @@ Args Args::parse(int argc, const char** argv) {
                 case OPTION_FORMAT:
                     args.output_format = Format::from_str(ctx.current_opt_arg);
                     if (args.output_format == Format::INVALID) {
-                        fmt::print(stderr, "sokol-shdc: unknown output format {}, must be [sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_jai|sokol_c2|sokol_c3|bare|base_yaml]\n", ctx.current_opt_arg);
+                        fmt::print(stderr, "sokol-shdc: unknown output format {}, must be [sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_jai|sokol_c2|sokol_c3|sokol_cpp|bare|bare_yaml]\n", ctx.current_opt_arg);
                         args.valid = false;
                         args.exit_code = 10;
                         return args;
@@ -268,6 +427,58 @@ Args Args::parse(int argc, const char** argv) {
                 case OPTION_DEPENDENCY_FILE:
                     args.dependency_file = ctx.current_opt_arg;
                     break;
+                case OPTION_OPT_LEVEL:
+                    args.opt_level = OptLevel::from_str(ctx.current_opt_arg);
+                    if (args.opt_level == OptLevel::INVALID) {
+                        fmt::print(stderr, "sokol-shdc: unknown optimization level {}, must be [0|s|1|2]\n", ctx.current_opt_arg);
+                        args.valid = false;
+                        args.exit_code = 10;
+                        return args;
+                    }
+                    break;
+                case OPTION_MINIFY:
+                    args.minify = true;
+                    break;
+                case OPTION_LAYOUT_REPORT:
+                    args.layout_report = true;
+                    break;
+                case OPTION_CPP_UNIFORMS:
+                    args.cpp_uniforms = true;
+                    break;
+                case OPTION_SBUF_PACKERS:
+                    args.sbuf_packers = true;
+                    break;
+                case OPTION_MAX_COST:
+                    if (!parse_max_cost(args, ctx.current_opt_arg)) {
+                        /* error details have been filled by parse_max_cost() */
+                        return args;
+                    }
+                    break;
+                case OPTION_PERF_LINT:
+                    args.perf_lint = true;
+                    break;
+                case OPTION_CS_LIMITS:
+                    if (!parse_cs_limits(args, ctx.current_opt_arg)) {
+                        /* error details have been filled by parse_cs_limits() */
+                        return args;
+                    }
+                    args.warn_occupancy = true;
+                    break;
+                case OPTION_PACK_VARYINGS:
+                    args.pack_varyings = true;
+                    break;
+                case OPTION_SPLIT_OUTPUT:
+                    args.split_output = true;
+                    break;
+                case OPTION_SPLIT_BACKENDS:
+                    args.split_backends = true;
+                    break;
+                case OPTION_EMBED_FILES:
+                    args.embed_files = true;
+                    break;
+                case OPTION_CACHE:
+                    args.cache = ctx.current_opt_arg;
+                    break;
                 case OPTION_HELP:
                     print_help_string(ctx);
                     args.valid = false;
@@ -293,7 +504,27 @@ void Args::dump_debug() const {
     fmt::print(stderr, "  byte_code: {}\n", byte_code);
     fmt::print(stderr, "  module: '{}'\n", module);
     fmt::print(stderr, "  defines: '{}'\n", pystring::join(":", defines));
+    fmt::print(stderr, "  spec_constants:");
+    for (const auto& item: spec_constants) {
+        fmt::print(stderr, " {}={}", item.first, item.second);
+    }
+    fmt::print(stderr, "\n");
     fmt::print(stderr, "  output_format: '{}'\n", Format::to_str(output_format));
+    fmt::print(stderr, "  split_output: {}\n", split_output);
+    fmt::print(stderr, "  split_backends: {}\n", split_backends);
+    fmt::print(stderr, "  embed_files: {}\n", embed_files);
+    fmt::print(stderr, "  opt_level: '{}'\n", OptLevel::to_str(opt_level));
+    fmt::print(stderr, "  minify: {}\n", minify);
+    fmt::print(stderr, "  layout_report: {}\n", layout_report);
+    fmt::print(stderr, "  cpp_uniforms: {}\n", cpp_uniforms);
+    fmt::print(stderr, "  sbuf_packers: {}\n", sbuf_packers);
+    fmt::print(stderr, "  pack_varyings: {}\n", pack_varyings);
+    fmt::print(stderr, "  cache: '{}'\n", cache);
+    fmt::print(stderr, "  perf_lint: {}\n", perf_lint);
+    fmt::print(stderr, "  max_cost: vs={} fs={} cs={}\n", max_cost[0], max_cost[1], max_cost[2]);
+    fmt::print(stderr, "  cs_limits: shared={} invocations={} cu_shared={} cu_invocations={} cu_workgroups={}\n",
+        cs_limits.max_shared_memory, cs_limits.max_invocations, cs_limits.cu_shared_memory, cs_limits.cu_max_invocations, cs_limits.cu_max_workgroups);
+    fmt::print(stderr, "  warn_occupancy: {}\n", warn_occupancy);
     fmt::print(stderr, "  debug_dump: {}\n", debug_dump);
     fmt::print(stderr, "  ifdef: {}\n", ifdef);
     fmt::print(stderr, "  gen_version: {}\n", gen_version);
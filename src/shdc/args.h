@@ -1,9 +1,12 @@
 #pragma once
 #include <stdint.h>
+#include <map>
 #include <string>
 #include <vector>
 #include "types/errmsg.h"
 #include "types/format.h"
+#include "types/opt_level.h"
+#include "types/compute_limits.h"
 
 namespace shdc {
 
@@ -17,11 +20,26 @@ struct Args {
     std::string tmpdir;                 // directory for temporary files
     std::string dependency_file;        // optional dependency file to generate
     std::string module;                 // optional @module name override
+    std::string cache;                  // optional compile cache directory or url
     std::vector<std::string> defines;   // additional preprocessor defines
+    std::map<std::string, std::string> spec_constants;  // specialization constant values baked into the shaders
     uint32_t slang = 0;                 // combined Slang bits
     bool byte_code = false;             // output byte code (for HLSL and MetalSL)
     bool reflection = false;            // if true, generate runtime reflection functions
     Format::Enum output_format = Format::SOKOL; // output format
+    bool split_output = false;          // write one output file per program plus common and index files (sokol, sokol_impl and sokol_cpp)
+    bool embed_files = false;           // write shader code and bytecode into binary files referenced via #embed/.incbin or the language's file embedding
+    bool split_backends = false;        // write the shader code and shader descs of each shader language into a separate C file (sokol_impl)
+    OptLevel::Enum opt_level = OptLevel::O1;    // SPIRV optimization level
+    bool minify = false;                // minify generated shader source code
+    bool layout_report = false;         // print uniform block and storage buffer padding report
+    bool sbuf_packers = false;          // generate storage buffer SoA <=> AoS pack/unpack functions (sokol and sokol_impl)
+    bool cpp_uniforms = false;          // also generate C++ uniform block structs with dirty-range tracking (sokol and sokol_impl)
+    bool pack_varyings = false;         // remove unused varyings and pack the remaining varyings into fewer locations
+    bool perf_lint = false;             // warn about common GPU performance pitfalls
+    int max_cost[3] = { 0, 0, 0 };      // per-stage estimated cost budgets indexed by ShaderStage (0: no budget)
+    ComputeLimits cs_limits;            // compute shader limits for the occupancy estimate
+    bool warn_occupancy = false;        // warn about low estimated compute shader occupancy (set by --cs-limits)
     bool debug_dump = false;            // print debug-dump info
     bool ifdef = false;                 // wrap backend specific shaders into #ifdefs (SOKOL_D3D11 etc...)
     bool save_intermediate_spirv = false;   // save intermediate SPIRV bytecode (glslangvalidator output)
@@ -0,0 +1,37 @@
+#
+# Generates build_id.h with the build id of sokol-shdc which is part of the
+# compile cache keys (see cache.cc): the commit of the sokol-tools checkout
+# (with a '-dirty' suffix for local changes) and the commits of the ext/
+# submodules. Runs on each build, but only rewrites build_id.h when the
+# build id has changed.
+#
+# cmake -DGIT_EXECUTABLE=[git] -DROOT_DIR=[sokol-tools dir] -DOUT_FILE=[build_id.h] -P build_id.cmake
+#
+execute_process(COMMAND ${GIT_EXECUTABLE} rev-parse HEAD
+    WORKING_DIRECTORY ${ROOT_DIR}
+    OUTPUT_VARIABLE build_id
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    RESULT_VARIABLE result
+    ERROR_QUIET)
+if (NOT result EQUAL 0)
+    file(CONFIGURE OUTPUT ${OUT_FILE} CONTENT "// not a git checkout, cache.cc falls back to the build time\n")
+    return()
+endif()
+# also catches checked out submodule commits which differ from the recorded ones
+execute_process(COMMAND ${GIT_EXECUTABLE} status --porcelain --untracked-files=no
+    WORKING_DIRECTORY ${ROOT_DIR}
+    OUTPUT_VARIABLE status
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET)
+if (status)
+    string(APPEND build_id "-dirty")
+endif()
+foreach (ext fmt getopt glslang pystring SPIRV-Cross SPIRV-Headers SPIRV-Tools tint-extract)
+    execute_process(COMMAND ${GIT_EXECUTABLE} rev-parse HEAD
+        WORKING_DIRECTORY ${ROOT_DIR}/ext/${ext}
+        OUTPUT_VARIABLE ext_commit
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET)
+    string(APPEND build_id " ${ext}=${ext_commit}")
+endforeach()
+file(CONFIGURE OUTPUT ${OUT_FILE} CONTENT "// generated by build_id.cmake\n#define SOKOL_SHDC_BUILD_ID \"${build_id}\"\n")
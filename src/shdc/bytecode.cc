@@ -34,6 +34,44 @@ const BytecodeBlob* Bytecode::find_blob_by_snippet_index(int snippet_index) cons
     return nullptr;
 }
 
+/* run a per-snippet bytecode compile function concurrently for all snippets,
+    and merge the results back in snippet order, the merged result ends
+    with the first snippet where compile_snippet() returned false, blobs
+    are looked up in and published to the compile cache
+*/
+static Bytecode compile_snippets(const Spirvcross& spirvcross, Slang::Enum slang, const Cache& cache, const std::function<bool(const SpirvcrossSource&, Bytecode&)>& compile_snippet) {
+    const int num_sources = (int)spirvcross.sources.size();
+    std::vector<Bytecode> results(num_sources);
+    std::vector<uint8_t> succeeded(num_sources, 0);
+    util::parallel_for(num_sources, [&](int i) {
+        const SpirvcrossSource& src = spirvcross.sources[i];
+        BytecodeBlob cached_blob;
+        if (cache.load_bytecode(slang, src.snippet_index, cached_blob)) {
+            results[i].blobs.push_back(std::move(cached_blob));
+            succeeded[i] = 1;
+            return;
+        }
+        succeeded[i] = compile_snippet(src, results[i]) ? 1 : 0;
+        // only store clean results, so that a cache hit doesn't swallow warnings
+        if (succeeded[i] && results[i].errors.empty() && (results[i].blobs.size() == 1)) {
+            cache.store_bytecode(slang, results[i].blobs[0]);
+        }
+    });
+    Bytecode bytecode;
+    for (int i = 0; i < num_sources; i++) {
+        for (ErrMsg& err: results[i].errors) {
+            bytecode.errors.push_back(std::move(err));
+        }
+        for (BytecodeBlob& blob: results[i].blobs) {
+            bytecode.blobs.push_back(std::move(blob));
+        }
+        if (!succeeded[i]) {
+            break;
+        }
+    }
+    return bytecode;
+}
+
 // MacOS/Metal specific stuff...
 #if defined(__APPLE__)
 
@@ -171,53 +209,57 @@ static bool mtl_link(const std::string& lib_path, const std::string& bin_path, S
     return 0 == xcrun(cmdline, dummy_output, slang);
 }
 
-static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
-    Bytecode bytecode;
+// compile a single Metal source, called from multiple threads, each
+// running its own xcrun subprocesses
+static bool mtl_compile_snippet(const Input& inp, const std::string& base_path, const SpirvcrossSource& src, Slang::Enum slang, Bytecode& bytecode) {
+    std::string output;
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    const std::string src_path = fmt::format("{}{}.metal", base_path, snippet.name);
+    const std::string dia_path = fmt::format("{}{}.dia", base_path, snippet.name);
+    const std::string air_path = fmt::format("{}{}.air", base_path, snippet.name);
+    const std::string bin_path = fmt::format("{}{}.metallib", base_path, snippet.name);
+    // write metal source code to temp file
+    if (!write_source(src.source_code, src_path)) {
+        bytecode.errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to write intermediate file '{}'!", src_path)));
+        return false;
+    }
+    // compiler, link, load generated bytecode
+    if (!mtl_cc(src_path, dia_path, air_path, slang, output)) {
+        mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
+        return false;
+    }
+    if (!mtl_link(air_path, bin_path, slang)) {
+        mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    if (!read_binary(bin_path, data)) {
+        mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
+        return false;
+    }
+    // if hard error happened there may still have been warnings
+    if (!output.empty()) {
+        mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
+    }
+
+    BytecodeBlob blob;
+    blob.valid = true;
+    blob.snippet_index = src.snippet_index;
+    blob.data = std::move(data);
+    bytecode.blobs.push_back(std::move(blob));
+    return true;
+}
+
+static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang, const Cache& cache) {
     std::string base_dir;
     std::string base_filename;
     pystring::os::path::split(base_dir, base_filename, inp.base_path);
-    std::string base_path = fmt::format("{}{}_{}_", args.tmpdir, base_filename, Slang::to_str(slang));
-    std::string src_path, dia_path, air_path, lib_path, bin_path;
+    const std::string base_path = fmt::format("{}{}_{}_", args.tmpdir, base_filename, Slang::to_str(slang));
 
     // for each vertex/fragment shader source generated by SPIRV-Cross:
-    for (const SpirvcrossSource& src: spirvcross.sources) {
-        std::string output;
-        const Snippet& snippet = inp.snippets[src.snippet_index];
-        src_path = fmt::format("{}{}.metal", base_path, snippet.name);
-        dia_path = fmt::format("{}{}.dia", base_path, snippet.name);
-        air_path = fmt::format("{}{}.air", base_path, snippet.name);
-        bin_path = fmt::format("{}{}.metallib", base_path, snippet.name);
-        // write metal source code to temp file
-        if (!write_source(src.source_code, src_path)) {
-            bytecode.errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to write intermediate file '{}'!", src_path)));
-            break;
-        }
-        // compiler, link, load generated bytecode
-        if (!mtl_cc(src_path, dia_path, air_path, slang, output)) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
-            break;
-        }
-        if (!mtl_link(air_path, bin_path, slang)) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
-            break;
-        }
-        std::vector<uint8_t> data;
-        if (!read_binary(bin_path, data)) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
-            break;
-        }
-        // if hard error happened there may still have been warnings
-        if (!output.empty()) {
-            mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
-        }
-
-        BytecodeBlob blob;
-        blob.valid = true;
-        blob.snippet_index = src.snippet_index;
-        blob.data = std::move(data);
-        bytecode.blobs.push_back(std::move(blob));
-    }
-    return bytecode;
+    return compile_snippets(spirvcross, slang, cache, [&](const SpirvcrossSource& src, Bytecode& bytecode) {
+        return mtl_compile_snippet(inp, base_path, src, slang, bytecode);
+    });
 }
 #endif
 
@@ -283,166 +325,197 @@ static void d3d_parse_errors(const std::string& output, const Input& inp, int sn
     }
 }
 
-static Bytecode d3d_compile(const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+// compile a single HLSL source, called from multiple threads
+static bool d3d_compile_snippet(const Input& inp, const SpirvcrossSource& src, Slang::Enum slang, Bytecode& bytecode) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    ID3DBlob* output = NULL;
+    ID3DBlob* errors = NULL;
+    const char* compile_target = nullptr;
+    if (slang == Slang::HLSL4) {
+        switch (snippet.type) {
+            case Snippet::VS: compile_target = "vs_4_0"; break;
+            case Snippet::FS: compile_target = "ps_4_0"; break;
+            case Snippet::CS: compile_target = "cs_4_0"; break;
+            default: compile_target = "UNKNOWN"; break;
+        }
+    } else {
+        switch (snippet.type) {
+            case Snippet::VS: compile_target = "vs_5_0"; break;
+            case Snippet::FS: compile_target = "ps_5_0"; break;
+            case Snippet::CS: compile_target = "cs_5_0"; break;
+            default: compile_target = "UNKNOWN"; break;
+        }
+    }
+    d3dcompile_func(
+        src.source_code.c_str(),        // pSrcData
+        src.source_code.length(),       // SrcDataSize
+        NULL,                           // pSourceName
+        NULL,                           // pDefines
+        NULL,                           // pInclude
+        src.stage_refl.entry_point.c_str(), // entryPoint
+        compile_target,                 // pTarget
+        D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_OPTIMIZATION_LEVEL3, // Flags1
+        0,                              // Flags2
+        &output,                        // ppCode
+        &errors);                       // ppErrorMsgs
+    if (errors) {
+        std::string err_str((const char*)errors->GetBufferPointer());
+        d3d_parse_errors(err_str, inp, src.snippet_index, bytecode.errors);
+    }
+    if (output && (output->GetBufferSize() > 0)) {
+        std::vector<uint8_t> data(output->GetBufferSize());
+        memcpy(data.data(), output->GetBufferPointer(), output->GetBufferSize());
+        BytecodeBlob blob;
+        blob.valid = true;
+        blob.snippet_index = src.snippet_index;
+        blob.data = std::move(data);
+        bytecode.blobs.push_back(std::move(blob));
+    }
+    if (errors) {
+        errors->Release();
+    }
+    if (output) {
+        output->Release();
+    }
+    return true;
+}
+
+static Bytecode d3d_compile(const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang, const Cache& cache) {
     Bytecode bytecode;
     if (!load_d3dcompiler_dll()) {
         bytecode.errors.push_back(ErrMsg::warning(inp.base_path, 0, fmt::format("failed to load d3dcompiler_47.dll!")));
         return bytecode;
     }
-    for (const SpirvcrossSource& src: spirvcross.sources) {
-        const Snippet& snippet = inp.snippets[src.snippet_index];
-        ID3DBlob* output = NULL;
-        ID3DBlob* errors = NULL;
-        const char* compile_target = nullptr;
-        if (slang == Slang::HLSL4) {
-            switch (snippet.type) {
-                case Snippet::VS: compile_target = "vs_4_0"; break;
-                case Snippet::FS: compile_target = "ps_4_0"; break;
-                case Snippet::CS: compile_target = "cs_4_0"; break;
-                default: compile_target = "UNKNOWN"; break;
-            }
-        } else {
-            switch (snippet.type) {
-                case Snippet::VS: compile_target = "vs_5_0"; break;
-                case Snippet::FS: compile_target = "ps_5_0"; break;
-                case Snippet::CS: compile_target = "cs_5_0"; break;
-                default: compile_target = "UNKNOWN"; break;
-            }
-        }
-        d3dcompile_func(
-            src.source_code.c_str(),        // pSrcData
-            src.source_code.length(),       // SrcDataSize
-            NULL,                           // pSourceName
-            NULL,                           // pDefines
-            NULL,                           // pInclude
-            src.stage_refl.entry_point.c_str(), // entryPoint
-            compile_target,                 // pTarget
-            D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_OPTIMIZATION_LEVEL3, // Flags1
-            0,                              // Flags2
-            &output,                        // ppCode
-            &errors);                       // ppErrorMsgs
-        if (errors) {
-            std::string err_str((const char*)errors->GetBufferPointer());
-            d3d_parse_errors(err_str, inp, src.snippet_index, bytecode.errors);
-        }
-        if (output && (output->GetBufferSize() > 0)) {
-            std::vector<uint8_t> data(output->GetBufferSize());
-            memcpy(data.data(), output->GetBufferPointer(), output->GetBufferSize());
-            BytecodeBlob blob;
-            blob.valid = true;
-            blob.snippet_index = src.snippet_index;
-            blob.data = std::move(data);
-            bytecode.blobs.push_back(std::move(blob));
-        }
-        if (errors) {
-            errors->Release();
-        }
-        if (output) {
-            output->Release();
-        }
-    }
-    return bytecode;
+    return compile_snippets(spirvcross, slang, cache, [&](const SpirvcrossSource& src, Bytecode& out_bytecode) {
+        return d3d_compile_snippet(inp, src, slang, out_bytecode);
+    });
 }
 #endif
 
-static Bytecode spirv_compile(const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
-    Bytecode bytecode;
-    for (const SpirvcrossSource& src: spirvcross.sources) {
-        const Snippet& snippet = inp.snippets[src.snippet_index];
-
-        const char* sources[1] = { src.source_code.c_str() };
-        const int sourcesLen[1] = { (int) src.source_code.length() };
-        const char* sourcesNames[1] = { inp.base_path.c_str() };
-        const int linenr_offset = 0;
-
-        EShLanguage stage;
-        if (Snippet::is_vs(snippet.type)) {
-            stage = EShLangVertex;
-        } else if (Snippet::is_fs(snippet.type)) {
-            stage = EShLangFragment;
-        } else {
-            stage = EShLangCompute;
-        }
-
-        glslang::TShader shader(stage);
-        shader.setStringsWithLengthsAndNames(sources, sourcesLen, sourcesNames, 1);
-        shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
-        shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
-        shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_4);
-        bool parse_success = shader.parse(GetDefaultResources(), 460, true, EShMsgDefault);
-        util::infolog_to_errors(shader.getInfoLog(), inp, src.snippet_index, linenr_offset, bytecode.errors);
-        util::infolog_to_errors(shader.getInfoDebugLog(), inp, src.snippet_index, linenr_offset, bytecode.errors);
-        if (!parse_success) {
-            bytecode.errors.push_back(ErrMsg::warning(inp.base_path, 0, fmt::format("failed to compile GLSL to SPIRV")));
-            return bytecode;
-        }
-
-        // "link" into a program
-        glslang::TProgram program;
-        program.addShader(&shader);
-        bool link_success = program.link(EShMsgDefault);
-        util::infolog_to_errors(program.getInfoLog(), inp, src.snippet_index, linenr_offset, bytecode.errors);
-        util::infolog_to_errors(program.getInfoDebugLog(), inp, src.snippet_index, linenr_offset, bytecode.errors);
-        if (!link_success) {
-            return bytecode;
-        }
-        bool map_success = program.mapIO();
-        util::infolog_to_errors(program.getInfoLog(), inp, src.snippet_index, linenr_offset, bytecode.errors);
-        util::infolog_to_errors(program.getInfoDebugLog(), inp, src.snippet_index, linenr_offset, bytecode.errors);
-        if (!map_success) {
-            return bytecode;
-        }
+// compile a single SPIRV-Cross GLSL source to SPIRV, called from multiple threads
+static bool spirv_compile_snippet(const Input& inp, const SpirvcrossSource& src, Bytecode& bytecode) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
 
-        // translate intermediate representation to SPIRV
-        std::vector<uint32_t> out_spirv;
-        const glslang::TIntermediate* im = program.getIntermediate(stage);
-        assert(im);
-        spv::SpvBuildLogger spv_logger;
-        glslang::SpvOptions spv_options;
-        // disable the optimizer passes, we'll run our own after the translation
-        spv_options.generateDebugInfo = false;
-        spv_options.stripDebugInfo = false; // NOTE: don't set this to true as the info is needed for reflection!
-        spv_options.disableOptimizer = true;
-        spv_options.optimizeSize = false;
-        spv_options.disassemble = false;
-        spv_options.validate = false;
-        spv_options.emitNonSemanticShaderDebugInfo = false;
-        spv_options.emitNonSemanticShaderDebugSource = false;
-        glslang::GlslangToSpv(*im, out_spirv, &spv_logger, &spv_options);
-        std::string spirv_log = spv_logger.getAllMessages();
-        if (!spirv_log.empty()) {
-            // FIXME: need to parse string for errors and translate to ErrMsg objects?
-            // haven't seen a case yet where this generates log messages
-            fmt::print(stderr, "{}", spirv_log);
+    // fast path: use the already optimized SPIRV with directly patched bind slots
+    if (!src.spirv.empty()) {
+        std::vector<uint32_t> out_spirv = src.spirv;
+        if (!Spirv::reduce_size(out_spirv)) {
+            bytecode.errors.push_back(inp.error(util::first_snippet_line_index_skipping_include_blocks(inp, snippet), fmt::format("failed to strip SPIRV bytecode of shader '{}'", snippet.name)));
+            return false;
         }
-
         const uint8_t* data_ptr = (const uint8_t*)out_spirv.data();
         const size_t data_len = out_spirv.size() * sizeof(uint32_t);
-
         BytecodeBlob blob;
         blob.valid = true;
         blob.snippet_index = src.snippet_index;
         blob.data = std::vector<uint8_t>(data_ptr, data_ptr + data_len);
         bytecode.blobs.push_back(std::move(blob));
+        return true;
     }
-    return bytecode;
+
+    // otherwise compile the SPIRVCross GLSL output back to SPIRV
+    const char* sources[1] = { src.source_code.c_str() };
+    const int sourcesLen[1] = { (int) src.source_code.length() };
+    const char* sourcesNames[1] = { inp.base_path.c_str() };
+    const bool line_per_string = false;
+
+    EShLanguage stage;
+    if (Snippet::is_vs(snippet.type)) {
+        stage = EShLangVertex;
+    } else if (Snippet::is_fs(snippet.type)) {
+        stage = EShLangFragment;
+    } else {
+        stage = EShLangCompute;
+    }
+
+    glslang::TShader shader(stage);
+    shader.setStringsWithLengthsAndNames(sources, sourcesLen, sourcesNames, 1);
+    shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+    shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_4);
+    bool parse_success = shader.parse(GetDefaultResources(), 460, true, EShMsgDefault);
+    util::infolog_to_errors(shader.getInfoLog(), inp, src.snippet_index, line_per_string, bytecode.errors);
+    util::infolog_to_errors(shader.getInfoDebugLog(), inp, src.snippet_index, line_per_string, bytecode.errors);
+    if (!parse_success) {
+        bytecode.errors.push_back(ErrMsg::warning(inp.base_path, 0, fmt::format("failed to compile GLSL to SPIRV")));
+        return false;
+    }
+
+    // "link" into a program
+    glslang::TProgram program;
+    program.addShader(&shader);
+    bool link_success = program.link(EShMsgDefault);
+    util::infolog_to_errors(program.getInfoLog(), inp, src.snippet_index, line_per_string, bytecode.errors);
+    util::infolog_to_errors(program.getInfoDebugLog(), inp, src.snippet_index, line_per_string, bytecode.errors);
+    if (!link_success) {
+        return false;
+    }
+    bool map_success = program.mapIO();
+    util::infolog_to_errors(program.getInfoLog(), inp, src.snippet_index, line_per_string, bytecode.errors);
+    util::infolog_to_errors(program.getInfoDebugLog(), inp, src.snippet_index, line_per_string, bytecode.errors);
+    if (!map_success) {
+        return false;
+    }
+
+    // translate intermediate representation to SPIRV
+    std::vector<uint32_t> out_spirv;
+    const glslang::TIntermediate* im = program.getIntermediate(stage);
+    assert(im);
+    spv::SpvBuildLogger spv_logger;
+    glslang::SpvOptions spv_options;
+    // disable the optimizer passes, we'll run our own after the translation
+    spv_options.generateDebugInfo = false;
+    spv_options.stripDebugInfo = false; // NOTE: don't set this to true as the info is needed for reflection!
+    spv_options.disableOptimizer = true;
+    spv_options.optimizeSize = false;
+    spv_options.disassemble = false;
+    spv_options.validate = false;
+    spv_options.emitNonSemanticShaderDebugInfo = false;
+    spv_options.emitNonSemanticShaderDebugSource = false;
+    glslang::GlslangToSpv(*im, out_spirv, &spv_logger, &spv_options);
+    std::string spirv_log = spv_logger.getAllMessages();
+    if (!spirv_log.empty()) {
+        // FIXME: need to parse string for errors and translate to ErrMsg objects?
+        // haven't seen a case yet where this generates log messages
+        fmt::print(stderr, "{}", spirv_log);
+    }
+    if (!Spirv::reduce_size(out_spirv)) {
+        bytecode.errors.push_back(inp.error(util::first_snippet_line_index_skipping_include_blocks(inp, snippet), fmt::format("failed to strip SPIRV bytecode of shader '{}'", snippet.name)));
+        return false;
+    }
+
+    const uint8_t* data_ptr = (const uint8_t*)out_spirv.data();
+    const size_t data_len = out_spirv.size() * sizeof(uint32_t);
+
+    BytecodeBlob blob;
+    blob.valid = true;
+    blob.snippet_index = src.snippet_index;
+    blob.data = std::vector<uint8_t>(data_ptr, data_ptr + data_len);
+    bytecode.blobs.push_back(std::move(blob));
+    return true;
+}
+
+static Bytecode spirv_compile(const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang, const Cache& cache) {
+    return compile_snippets(spirvcross, slang, cache, [&](const SpirvcrossSource& src, Bytecode& out_bytecode) {
+        return spirv_compile_snippet(inp, src, out_bytecode);
+    });
 }
 
-Bytecode Bytecode::compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+Bytecode Bytecode::compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang, const Cache& cache) {
     Bytecode bytecode;
     #if defined(__APPLE__)
     // NOTE: for the iOS simulator case, don't compile bytecode but use source code
     if ((slang == Slang::METAL_MACOS) || (slang == Slang::METAL_IOS)) {
-        bytecode = mtl_compile(args, inp, spirvcross, slang);
+        bytecode = mtl_compile(args, inp, spirvcross, slang, cache);
     }
     #endif
     #if defined(_WIN32)
     if (Slang::is_hlsl(slang)) {
-        bytecode = d3d_compile(inp, spirvcross, slang);
+        bytecode = d3d_compile(inp, spirvcross, slang, cache);
     }
     #endif
     if (Slang::is_spirv(slang)) {
-        bytecode = spirv_compile(inp, spirvcross, slang);
+        bytecode = spirv_compile(inp, spirvcross, slang, cache);
     }
     return bytecode;
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include "args.h"
+#include "cache.h"
 #include "input.h"
 #include "spirvcross.h"
 #include "types/bytecode_blob.h"
@@ -13,7 +14,7 @@ struct Bytecode {
     std::vector<ErrMsg> errors;
     std::vector<BytecodeBlob> blobs;
 
-    static Bytecode compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang);
+    static Bytecode compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang, const Cache& cache);
     const BytecodeBlob* find_blob_by_snippet_index(int snippet_index) const;
     void dump_debug() const;
 };
@@ -0,0 +1,806 @@
+/*
+    Compile cache for SPIRV, cross-compiled sources and bytecode with
+    pluggable storage backends (a shared directory or a HTTP server).
+*/
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include "cache.h"
+#include "fmt/format.h"
+#include "pystring.h"
+#include "glslang/Public/ShaderLang.h"
+#include "spirv-tools/libspirv.h"
+#if defined(SOKOL_SHDC_HAS_BUILD_ID_H)
+#include "build_id.h"
+#endif
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+namespace shdc {
+
+/* SHA-256 (FIPS 180-4), used for the cache keys */
+struct Sha256 {
+    uint32_t state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    uint8_t block[64];
+    size_t block_len = 0;
+    uint64_t total_len = 0;
+
+    void update(const void* data, size_t len);
+    void update(const std::string& str);
+    std::string finish();
+    void transform();
+};
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void Sha256::transform() {
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i*4] << 24) | ((uint32_t)block[i*4+1] << 16) | ((uint32_t)block[i*4+2] << 8) | (uint32_t)block[i*4+3];
+    }
+    for (int i = 16; i < 64; i++) {
+        const uint32_t s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+        const uint32_t s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        const uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        const uint32_t ch = (e & f) ^ (~e & g);
+        const uint32_t t1 = h + s1 + ch + k[i] + w[i];
+        const uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t t2 = s0 + maj;
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(const void* data, size_t len) {
+    const uint8_t* ptr = (const uint8_t*)data;
+    total_len += len;
+    while (len > 0) {
+        const size_t n = std::min(len, sizeof(block) - block_len);
+        memcpy(block + block_len, ptr, n);
+        block_len += n;
+        ptr += n;
+        len -= n;
+        if (block_len == sizeof(block)) {
+            transform();
+            block_len = 0;
+        }
+    }
+}
+
+// NOTE: strings are hashed with their length so that adjacent strings can't alias
+void Sha256::update(const std::string& str) {
+    const uint64_t len = str.length();
+    uint8_t len_bytes[8];
+    for (int i = 0; i < 8; i++) {
+        len_bytes[i] = (uint8_t)(len >> (i * 8));
+    }
+    update(len_bytes, sizeof(len_bytes));
+    update(str.data(), str.length());
+}
+
+std::string Sha256::finish() {
+    const uint64_t bit_len = total_len * 8;
+    const uint8_t pad = 0x80;
+    const uint8_t zero = 0;
+    update(&pad, 1);
+    while (block_len != 56) {
+        update(&zero, 1);
+    }
+    uint8_t len_bytes[8];
+    for (int i = 0; i < 8; i++) {
+        len_bytes[i] = (uint8_t)(bit_len >> (56 - i * 8));
+    }
+    update(len_bytes, sizeof(len_bytes));
+    std::string res;
+    for (int i = 0; i < 8; i++) {
+        res += fmt::format("{:08x}", state[i]);
+    }
+    return res;
+}
+
+/* little-endian serialization of cache entries */
+struct EntryWriter {
+    std::vector<uint8_t> data;
+
+    void u32(uint32_t val) {
+        for (int i = 0; i < 4; i++) {
+            data.push_back((uint8_t)(val >> (i * 8)));
+        }
+    }
+    void str(const std::string& val) {
+        u32((uint32_t)val.length());
+        data.insert(data.end(), val.begin(), val.end());
+    }
+    void bytes(const std::vector<uint8_t>& val) {
+        u32((uint32_t)val.size());
+        data.insert(data.end(), val.begin(), val.end());
+    }
+    void words(const std::vector<uint32_t>& val) {
+        u32((uint32_t)val.size());
+        for (uint32_t word: val) {
+            u32(word);
+        }
+    }
+};
+
+struct EntryReader {
+    const std::vector<uint8_t>& data;
+    size_t pos = 0;
+    bool valid = true;
+
+    EntryReader(const std::vector<uint8_t>& data): data(data) { };
+    bool check(size_t num_bytes) {
+        if (valid && ((data.size() - pos) < num_bytes)) {
+            valid = false;
+        }
+        return valid;
+    }
+    uint32_t u32() {
+        uint32_t val = 0;
+        if (check(4)) {
+            for (int i = 0; i < 4; i++) {
+                val |= ((uint32_t)data[pos++]) << (i * 8);
+            }
+        }
+        return val;
+    }
+    std::string str() {
+        const uint32_t len = u32();
+        std::string val;
+        if (check(len)) {
+            val.assign((const char*)&data[pos], len);
+            pos += len;
+        }
+        return val;
+    }
+    std::vector<uint8_t> bytes() {
+        const uint32_t len = u32();
+        std::vector<uint8_t> val;
+        if (check(len)) {
+            val.assign(data.begin() + pos, data.begin() + pos + len);
+            pos += len;
+        }
+        return val;
+    }
+    std::vector<uint32_t> words() {
+        const uint32_t len = u32();
+        std::vector<uint32_t> val;
+        if (check((size_t)len * 4)) {
+            val.reserve(len);
+            for (uint32_t i = 0; i < len; i++) {
+                val.push_back(u32());
+            }
+        }
+        return val;
+    }
+    // all entries start with the key they were stored under, this protects
+    // against corrupted or misplaced entries in a shared cache
+    bool begin(const std::string& key) {
+        return (u32() == Cache::FormatVersion) && (str() == key) && valid;
+    }
+    bool end() const {
+        return valid && (pos == data.size());
+    }
+};
+
+// print a warning once if storing cache entries fails (e.g. the cache server isn't reachable)
+static void warn_store_failed(const std::string& key) {
+    static std::atomic<bool> warned(false);
+    if (!warned.exchange(true)) {
+        fmt::print(stderr, "sokol-shdc: warning: failed to store compile cache entry '{}'\n", key);
+    }
+}
+
+//------------------------------------------------------------------------------
+FileCacheBackend::FileCacheBackend(const std::string& dir): dir(dir) { };
+
+// entries are spread over 256 subdirectories named after the first two key characters
+static std::filesystem::path file_entry_path(const std::string& dir, const std::string& key) {
+    return std::filesystem::path(dir) / key.substr(0, 2) / key;
+}
+
+bool FileCacheBackend::get(const std::string& key, std::vector<uint8_t>& out_data) {
+    const std::filesystem::path path = file_entry_path(dir, key);
+    FILE* f = fopen(path.string().c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    const long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool res = false;
+    if (file_size > 0) {
+        out_data.resize((size_t)file_size);
+        res = ((size_t)file_size == fread(out_data.data(), 1, (size_t)file_size, f));
+    }
+    fclose(f);
+    return res;
+}
+
+bool FileCacheBackend::put(const std::string& key, const std::vector<uint8_t>& data) {
+    const std::filesystem::path path = file_entry_path(dir, key);
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+    // write to a uniquely named temporary file in the same directory and atomically
+    // rename into place, concurrent readers either see no entry or a complete entry
+    static std::atomic<uint32_t> counter(0);
+    std::random_device rnd;
+    const std::filesystem::path tmp_path = fmt::format("{}.{:08x}{:08x}.{}.tmp", path.string(), rnd(), rnd(), counter++);
+    FILE* f = fopen(tmp_path.string().c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    const bool write_ok = (data.size() == fwrite(data.data(), 1, data.size(), f));
+    const bool close_ok = (0 == fclose(f));
+    if (write_ok && close_ok) {
+        std::filesystem::rename(tmp_path, path, ec);
+        if (!ec) {
+            return true;
+        }
+    }
+    // if another process published the same entry first that's fine too
+    std::filesystem::remove(tmp_path, ec);
+    return std::filesystem::exists(path, ec);
+}
+
+//------------------------------------------------------------------------------
+#if defined(_WIN32)
+typedef SOCKET socket_t;
+static const socket_t InvalidSocket = INVALID_SOCKET;
+static void close_socket(socket_t sock) { closesocket(sock); }
+#else
+typedef int socket_t;
+static const socket_t InvalidSocket = -1;
+static void close_socket(socket_t sock) { close(sock); }
+#endif
+#if defined(MSG_NOSIGNAL)
+static const int SendFlags = MSG_NOSIGNAL;
+#else
+static const int SendFlags = 0;
+#endif
+
+HttpCacheBackend::HttpCacheBackend(const std::string& host, const std::string& port, const std::string& path):
+    host(host),
+    port(port),
+    path(path)
+{
+    #if defined(_WIN32)
+    static std::once_flag wsa_init;
+    std::call_once(wsa_init, []() {
+        WSADATA wsa_data;
+        WSAStartup(MAKEWORD(2, 2), &wsa_data);
+    });
+    #endif
+};
+
+/* parse a numeric IPv4 or IPv6 address or 'localhost', host names are deliberately
+    not resolved since getaddrinfo() needs the NSS shared libraries at runtime,
+    which breaks the statically linked Linux executable
+*/
+static bool http_parse_addr(const std::string& host, const std::string& port, sockaddr_storage& out_addr, int& out_addr_len) {
+    const std::string ip = (host == "localhost") ? "127.0.0.1" : host;
+    const unsigned long port_nr = strtoul(port.c_str(), nullptr, 10);
+    if ((port_nr == 0) || (port_nr > 65535)) {
+        return false;
+    }
+    memset(&out_addr, 0, sizeof(out_addr));
+    sockaddr_in* addr4 = (sockaddr_in*)&out_addr;
+    sockaddr_in6* addr6 = (sockaddr_in6*)&out_addr;
+    if (1 == inet_pton(AF_INET, ip.c_str(), &addr4->sin_addr)) {
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons((uint16_t)port_nr);
+        out_addr_len = (int)sizeof(sockaddr_in);
+        return true;
+    } else if (1 == inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr)) {
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons((uint16_t)port_nr);
+        out_addr_len = (int)sizeof(sockaddr_in6);
+        return true;
+    }
+    return false;
+}
+
+static socket_t http_connect(const std::string& host, const std::string& port, int timeout_ms) {
+    sockaddr_storage addr;
+    int addr_len = 0;
+    if (!http_parse_addr(host, port, addr, addr_len)) {
+        return InvalidSocket;
+    }
+    socket_t sock = socket(addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == InvalidSocket) {
+        return InvalidSocket;
+    }
+    #if defined(_WIN32)
+    const DWORD timeout = (DWORD)timeout_ms;
+    #else
+    timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    #endif
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+    #if defined(SO_NOSIGPIPE)
+    const int no_sigpipe = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+    #endif
+    if (0 != connect(sock, (const sockaddr*)&addr, addr_len)) {
+        close_socket(sock);
+        return InvalidSocket;
+    }
+    return sock;
+}
+
+static bool http_send(socket_t sock, const char* data, size_t len) {
+    while (len > 0) {
+        const int n = (int)send(sock, data, (int)std::min(len, (size_t)(1<<20)), SendFlags);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// decode a 'Transfer-Encoding: chunked' response body
+static bool http_dechunk(const std::string& body, std::vector<uint8_t>& out_data) {
+    out_data.clear();
+    size_t pos = 0;
+    while (true) {
+        const size_t line_end = body.find("\r\n", pos);
+        if (line_end == std::string::npos) {
+            return false;
+        }
+        const size_t chunk_size = strtoul(body.substr(pos, line_end - pos).c_str(), nullptr, 16);
+        pos = line_end + 2;
+        if (chunk_size == 0) {
+            return true;
+        }
+        if ((body.size() - pos) < chunk_size) {
+            return false;
+        }
+        out_data.insert(out_data.end(), body.begin() + pos, body.begin() + pos + chunk_size);
+        pos += chunk_size + 2;
+    }
+}
+
+/* perform a single HTTP/1.1 request on a new connection, returns the
+    HTTP status code, or 0 if the request failed
+*/
+static int http_request(const HttpCacheBackend& backend, const char* method, const std::string& key, const std::vector<uint8_t>* body, std::vector<uint8_t>& out_body) {
+    const socket_t sock = http_connect(backend.host, backend.port, HttpCacheBackend::TimeoutMs);
+    if (sock == InvalidSocket) {
+        return 0;
+    }
+    std::string req = fmt::format("{} {}/{} HTTP/1.1\r\nHost: {}:{}\r\nConnection: close\r\n", method, backend.path, key, backend.host, backend.port);
+    if (body) {
+        req += fmt::format("Content-Type: application/octet-stream\r\nContent-Length: {}\r\n", body->size());
+    }
+    req += "\r\n";
+    bool ok = http_send(sock, req.data(), req.length());
+    if (ok && body) {
+        ok = http_send(sock, (const char*)body->data(), body->size());
+    }
+    std::string resp;
+    if (ok) {
+        char buf[16 * 1024];
+        int n;
+        while ((n = (int)recv(sock, buf, sizeof(buf), 0)) > 0) {
+            resp.append(buf, (size_t)n);
+        }
+        ok = (n == 0);
+    }
+    close_socket(sock);
+    if (!ok) {
+        return 0;
+    }
+
+    // parse status line and headers
+    const size_t header_end = resp.find("\r\n\r\n");
+    if ((header_end == std::string::npos) || !pystring::startswith(resp, "HTTP/1.")) {
+        return 0;
+    }
+    std::vector<std::string> header_lines;
+    pystring::split(resp.substr(0, header_end), header_lines, "\r\n");
+    std::vector<std::string> status_tokens;
+    pystring::split(header_lines[0], status_tokens, " ");
+    if (status_tokens.size() < 2) {
+        return 0;
+    }
+    const int status = atoi(status_tokens[1].c_str());
+    bool chunked = false;
+    long content_length = -1;
+    for (size_t i = 1; i < header_lines.size(); i++) {
+        const std::string line = pystring::lower(header_lines[i]);
+        if (pystring::startswith(line, "transfer-encoding:") && (line.find("chunked") != std::string::npos)) {
+            chunked = true;
+        } else if (pystring::startswith(line, "content-length:")) {
+            content_length = atol(line.substr(15).c_str());
+        }
+    }
+    const std::string resp_body = resp.substr(header_end + 4);
+    if (chunked) {
+        if (!http_dechunk(resp_body, out_body)) {
+            return 0;
+        }
+    } else if (content_length >= 0) {
+        if ((long)resp_body.size() < content_length) {
+            return 0;
+        }
+        out_body.assign(resp_body.begin(), resp_body.begin() + content_length);
+    } else {
+        out_body.assign(resp_body.begin(), resp_body.end());
+    }
+    return status;
+}
+
+bool HttpCacheBackend::get(const std::string& key, std::vector<uint8_t>& out_data) {
+    return 200 == http_request(*this, "GET", key, nullptr, out_data);
+}
+
+bool HttpCacheBackend::put(const std::string& key, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> resp_body;
+    const int status = http_request(*this, "PUT", key, &data, resp_body);
+    return (status >= 200) && (status < 300);
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<CacheBackend> Cache::create_backend(const std::string& url, std::string& out_error_msg) {
+    if (pystring::startswith(url, "http://")) {
+        // http://host[:port][/path]
+        const std::string rest = url.substr(7);
+        const size_t path_pos = rest.find('/');
+        const std::string host_port = rest.substr(0, path_pos);
+        std::string path = (path_pos == std::string::npos) ? "" : rest.substr(path_pos);
+        path = pystring::rstrip(path, "/");
+        std::string host = host_port;
+        std::string port = "80";
+        const size_t port_pos = host_port.rfind(':');
+        if ((port_pos != std::string::npos) && (host_port.find(']', port_pos) == std::string::npos)) {
+            host = host_port.substr(0, port_pos);
+            port = host_port.substr(port_pos + 1);
+        }
+        // strip brackets from IPv6 addresses
+        if (pystring::startswith(host, "[") && pystring::endswith(host, "]")) {
+            host = host.substr(1, host.length() - 2);
+        }
+        if (host.empty() || port.empty() || !pystring::isdigit(port)) {
+            out_error_msg = fmt::format("invalid cache url '{}' (expected http://host[:port][/path])", url);
+            return nullptr;
+        }
+        // NOTE: the backend constructor initializes WinSock, which must happen before http_parse_addr()
+        auto backend = std::make_shared<HttpCacheBackend>(host, port, path);
+        sockaddr_storage addr;
+        int addr_len = 0;
+        if (!http_parse_addr(host, port, addr, addr_len)) {
+            out_error_msg = fmt::format("invalid cache url '{}' (the host must be 'localhost' or a numeric IPv4 or IPv6 address)", url);
+            return nullptr;
+        }
+        return backend;
+    }
+    if (pystring::startswith(url, "https://")) {
+        out_error_msg = fmt::format("invalid cache url '{}' (https is not supported, use a http:// or file:// url)", url);
+        return nullptr;
+    }
+    std::string dir = url;
+    if (pystring::startswith(url, "file://")) {
+        dir = url.substr(7);
+    } else if (url.find("://") != std::string::npos) {
+        out_error_msg = fmt::format("invalid cache url '{}' (expected file://, http:// or a directory)", url);
+        return nullptr;
+    }
+    if (dir.empty()) {
+        out_error_msg = fmt::format("invalid cache url '{}' (empty directory)", url);
+        return nullptr;
+    }
+    return std::make_shared<FileCacheBackend>(dir);
+}
+
+// identifies the sokol-shdc build, generated at build time from the commits of the
+// sokol-tools checkout and the ext/ submodules (see build_id.cmake and build.zig),
+// builds without a git checkout fall back to the build time
+#ifndef SOKOL_SHDC_BUILD_ID
+#define SOKOL_SHDC_BUILD_ID_IS_BUILD_TIME
+#define SOKOL_SHDC_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+// cache entries can only be shared between builds of the same source code
+static bool build_id_identifies_source() {
+    #if defined(SOKOL_SHDC_BUILD_ID_IS_BUILD_TIME)
+    return false;
+    #else
+    return std::string(SOKOL_SHDC_BUILD_ID).find("-dirty") == std::string::npos;
+    #endif
+}
+
+// NOTE: HLSL and Metal bytecode is compiled with platform tools, so entries aren't shared between host platforms
+static const char* host_platform() {
+    #if defined(_WIN32)
+    return "windows";
+    #elif defined(__APPLE__)
+    return "macos";
+    #elif defined(__linux__)
+    return "linux";
+    #else
+    return "other";
+    #endif
+}
+
+std::string Cache::version_info() {
+    static const std::string info = [] {
+        const glslang::Version glslang_version = glslang::GetVersion();
+        return fmt::format("sokol-shdc {} ({}); glslang {}.{}.{}{}; {}; fmt {}",
+            SOKOL_SHDC_BUILD_ID,
+            host_platform(),
+            glslang_version.major, glslang_version.minor, glslang_version.patch, glslang_version.flavor,
+            spvSoftwareVersionDetailsString(),
+            FMT_VERSION);
+    }();
+    return info;
+}
+
+Cache Cache::open(const Args& args, const Input& inp) {
+    Cache cache;
+    if (args.cache.empty()) {
+        return cache;
+    }
+    if (!build_id_identifies_source()) {
+        cache.error = ErrMsg::warning(inp.base_path, 0, fmt::format("compile cache disabled, the build id '{}' of sokol-shdc doesn't identify its source code (built from a modified checkout or without git)", SOKOL_SHDC_BUILD_ID));
+        return cache;
+    }
+    std::string error_msg;
+    cache.backend = create_backend(args.cache, error_msg);
+    if (!cache.backend) {
+        cache.error = ErrMsg::error(inp.base_path, 0, error_msg);
+        return cache;
+    }
+    // NOTE: file paths are deliberately not part of the key, this allows to share
+    // entries between machines with different checkout locations
+    Sha256 sha;
+    sha.update(fmt::format("sokol-shdc cache v{}", FormatVersion));
+    sha.update(version_info());
+    sha.update(fmt::format("slang={} byte_code={} opt_level={} pack_varyings={} perf_lint={}",
+        args.slang, args.byte_code, OptLevel::to_str(args.opt_level), args.pack_varyings, args.perf_lint));
+    sha.update(args.module);
+    for (const std::string& define: args.defines) {
+        sha.update(define);
+    }
+    for (const auto& item: args.spec_constants) {
+        sha.update(item.first);
+        sha.update(item.second);
+    }
+    // the merged input source (base file with all @include files resolved)
+    for (const Line& line: inp.lines) {
+        sha.update(line.line.data(), line.line.length());
+        sha.update("\n", 1);
+    }
+    cache.base_key = sha.finish();
+    return cache;
+}
+
+bool Cache::enabled() const {
+    return backend != nullptr;
+}
+
+std::string Cache::key(const char* kind, Slang::Enum slang, int snippet_index) const {
+    Sha256 sha;
+    sha.update(base_key);
+    sha.update(fmt::format("{} {} {}", kind, Slang::to_str(slang), snippet_index));
+    return sha.finish();
+}
+
+bool Cache::load_spirv(const Input& inp, Slang::Enum slang, Spirv& out_spirv) const {
+    if (!enabled()) {
+        return false;
+    }
+    const std::string k = key("spirv", slang, -1);
+    std::vector<uint8_t> data;
+    if (!backend->get(k, data)) {
+        return false;
+    }
+    EntryReader rd(data);
+    if (!rd.begin(k)) {
+        return false;
+    }
+    Spirv spirv;
+    const uint32_t num_blobs = rd.u32();
+    for (uint32_t blob_index = 0; rd.valid && (blob_index < num_blobs); blob_index++) {
+        const int snippet_index = (int)rd.u32();
+        if (!rd.valid || (snippet_index < 0) || (snippet_index >= (int)inp.snippets.size())) {
+            return false;
+        }
+        SpirvBlob blob(snippet_index);
+        blob.preamble = rd.str();
+        blob.bytecode = rd.words();
+        const uint32_t num_bindslots = rd.u32();
+        for (uint32_t i = 0; rd.valid && (i < num_bindslots); i++) {
+            const int binding = (int)rd.u32();
+            const std::string name = rd.str();
+            const BindSlot::Type type = (BindSlot::Type)rd.u32();
+            const int qualifiers = (int)rd.u32();
+            std::string errmsg;
+            if (!rd.valid || !blob.bindings.add(BindSlot(binding, name, type, qualifiers), errmsg)) {
+                return false;
+            }
+        }
+        blob.bindings.allocate_backend_slots(ShaderStage::from_snippet_type(inp.snippets[snippet_index].type));
+        blob.stats = Spirv::compute_stats(blob.bytecode);
+        spirv.blobs.push_back(std::move(blob));
+    }
+    if (!rd.end()) {
+        return false;
+    }
+    out_spirv = std::move(spirv);
+    return true;
+}
+
+// NOTE: results with errors or warnings are never stored, so that a cache hit doesn't swallow diagnostics
+void Cache::store_spirv(Slang::Enum slang, const Spirv& spirv) const {
+    if (!enabled() || !spirv.errors.empty()) {
+        return;
+    }
+    const std::string k = key("spirv", slang, -1);
+    EntryWriter wr;
+    wr.u32(FormatVersion);
+    wr.str(k);
+    wr.u32((uint32_t)spirv.blobs.size());
+    for (const SpirvBlob& blob: spirv.blobs) {
+        wr.u32((uint32_t)blob.snippet_index);
+        wr.str(blob.preamble);
+        wr.words(blob.bytecode);
+        std::vector<const BindSlot*> bindslots;
+        for (const BindSlot& slot: blob.bindings.uniform_blocks) {
+            bindslots.push_back(&slot);
+        }
+        for (const BindSlot& slot: blob.bindings.views) {
+            bindslots.push_back(&slot);
+        }
+        for (const BindSlot& slot: blob.bindings.samplers) {
+            bindslots.push_back(&slot);
+        }
+        bindslots.erase(std::remove_if(bindslots.begin(), bindslots.end(), [](const BindSlot* slot) { return slot->empty(); }), bindslots.end());
+        wr.u32((uint32_t)bindslots.size());
+        for (const BindSlot* slot: bindslots) {
+            wr.u32((uint32_t)slot->binding);
+            wr.str(slot->name);
+            wr.u32((uint32_t)slot->type);
+            wr.u32((uint32_t)slot->qualifiers);
+        }
+    }
+    if (!backend->put(k, wr.data)) {
+        warn_store_failed(k);
+    }
+}
+
+// NOTE: the stage reflection isn't stored, it's cheap to rebuild from the SPIRV blob
+bool Cache::load_source(Slang::Enum slang, int snippet_index, SpirvcrossSource& out_src) const {
+    if (!enabled()) {
+        return false;
+    }
+    const std::string k = key("source", slang, snippet_index);
+    std::vector<uint8_t> data;
+    if (!backend->get(k, data)) {
+        return false;
+    }
+    EntryReader rd(data);
+    if (!rd.begin(k)) {
+        return false;
+    }
+    SpirvcrossSource src;
+    src.snippet_index = snippet_index;
+    src.source_code = rd.str();
+    src.spirv = rd.words();
+    if (!rd.end() || src.source_code.empty()) {
+        return false;
+    }
+    out_src = std::move(src);
+    return true;
+}
+
+void Cache::store_source(Slang::Enum slang, const SpirvcrossSource& src) const {
+    if (!enabled() || !src.valid) {
+        return;
+    }
+    const std::string k = key("source", slang, src.snippet_index);
+    EntryWriter wr;
+    wr.u32(FormatVersion);
+    wr.str(k);
+    wr.str(src.source_code);
+    wr.words(src.spirv);
+    if (!backend->put(k, wr.data)) {
+        warn_store_failed(k);
+    }
+}
+
+bool Cache::load_bytecode(Slang::Enum slang, int snippet_index, BytecodeBlob& out_blob) const {
+    if (!enabled()) {
+        return false;
+    }
+    const std::string k = key("bytecode", slang, snippet_index);
+    std::vector<uint8_t> data;
+    if (!backend->get(k, data)) {
+        return false;
+    }
+    EntryReader rd(data);
+    if (!rd.begin(k)) {
+        return false;
+    }
+    BytecodeBlob blob;
+    blob.valid = true;
+    blob.snippet_index = snippet_index;
+    blob.data = rd.bytes();
+    if (!rd.end() || blob.data.empty()) {
+        return false;
+    }
+    out_blob = std::move(blob);
+    return true;
+}
+
+void Cache::store_bytecode(Slang::Enum slang, const BytecodeBlob& blob) const {
+    if (!enabled() || !blob.valid) {
+        return;
+    }
+    const std::string k = key("bytecode", slang, blob.snippet_index);
+    EntryWriter wr;
+    wr.u32(FormatVersion);
+    wr.str(k);
+    wr.bytes(blob.data);
+    if (!backend->put(k, wr.data)) {
+        warn_store_failed(k);
+    }
+}
+
+void Cache::dump_debug() const {
+    fmt::print(stderr, "Cache:\n");
+    if (!enabled()) {
+        fmt::print(stderr, "  disabled\n\n");
+        return;
+    }
+    fmt::print(stderr, "  version_info: {}\n", version_info());
+    fmt::print(stderr, "  base_key: {}\n\n", base_key);
+}
+
+} // namespace shdc
@@ -0,0 +1,76 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "args.h"
+#include "input.h"
+#include "spirv.h"
+#include "types/bytecode_blob.h"
+#include "types/errmsg.h"
+#include "types/slang.h"
+#include "types/spirvcross_source.h"
+
+namespace shdc {
+
+// storage backend interface of the compile cache, get() and put() are called
+// from multiple threads and must be thread-safe
+struct CacheBackend {
+    virtual ~CacheBackend() {};
+    // load a cache entry, returns false on a cache miss or any error
+    virtual bool get(const std::string& key, std::vector<uint8_t>& out_data) = 0;
+    // publish a cache entry, returns false if the entry couldn't be stored
+    virtual bool put(const std::string& key, const std::vector<uint8_t>& data) = 0;
+};
+
+// a (shared) cache directory, entries are written to a temporary file
+// and atomically renamed into place
+struct FileCacheBackend: CacheBackend {
+    std::string dir;
+
+    FileCacheBackend(const std::string& dir);
+    bool get(const std::string& key, std::vector<uint8_t>& out_data) override;
+    bool put(const std::string& key, const std::vector<uint8_t>& data) override;
+};
+
+// a HTTP/1.1 cache server, entries are loaded with 'GET [path]/[key]' and
+// published with 'PUT [path]/[key]' (no TLS, intended for a local build farm network)
+struct HttpCacheBackend: CacheBackend {
+    static const int TimeoutMs = 5000;
+    std::string host;
+    std::string port;
+    std::string path;
+
+    HttpCacheBackend(const std::string& host, const std::string& port, const std::string& path);
+    bool get(const std::string& key, std::vector<uint8_t>& out_data) override;
+    bool put(const std::string& key, const std::vector<uint8_t>& data) override;
+};
+
+// compile cache for SPIRV, cross-compiled sources and bytecode, the keys are
+// derived from the merged input source, all output-relevant command line
+// args, and the versions of sokol-shdc and the compiler libraries
+struct Cache {
+    static const uint32_t FormatVersion = 1;   // bump when the entry layout changes
+    ErrMsg error;
+    std::shared_ptr<CacheBackend> backend;
+    std::string base_key;
+
+    // parse a cache url ('file://[dir]', 'http://[host]:[port]/[path]' or a plain directory)
+    static std::shared_ptr<CacheBackend> create_backend(const std::string& url, std::string& out_error_msg);
+    // open the cache for an input file (a disabled cache if args.cache is empty)
+    static Cache open(const Args& args, const Input& inp);
+    // version string of sokol-shdc and the compiler libraries which is part of all keys
+    static std::string version_info();
+    bool enabled() const;
+    std::string key(const char* kind, Slang::Enum slang, int snippet_index) const;
+
+    bool load_spirv(const Input& inp, Slang::Enum slang, Spirv& out_spirv) const;
+    void store_spirv(Slang::Enum slang, const Spirv& spirv) const;
+    bool load_source(Slang::Enum slang, int snippet_index, SpirvcrossSource& out_src) const;
+    void store_source(Slang::Enum slang, const SpirvcrossSource& src) const;
+    bool load_bytecode(Slang::Enum slang, int snippet_index, BytecodeBlob& out_blob) const;
+    void store_bytecode(Slang::Enum slang, const BytecodeBlob& blob) const;
+    void dump_debug() const;
+};
+
+} // namespace shdc
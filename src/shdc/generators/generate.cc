@@ -13,6 +13,7 @@
 #include "sokoljai.h"
 #include "sokolc2.h"
 #include "sokolc3.h"
+#include "sokolcpp.h"
 #include "yaml.h"
 #include <memory>
 
@@ -36,6 +37,8 @@ std::unique_ptr<Generator> make_generator(Format::Enum format) {
             return std::make_unique<SokolC2Generator>();
         case Format::SOKOL_C3:
             return std::make_unique<SokolC3Generator>();
+        case Format::SOKOL_CPP:
+            return std::make_unique<SokolCppGenerator>();
         case Format::BARE:
             return std::make_unique<BareGenerator>();
         case Format::BARE_YAML:
@@ -45,8 +48,11 @@ std::unique_ptr<Generator> make_generator(Format::Enum format) {
     }
 }
 
-ErrMsg generate(Format::Enum format, const GenInput& gen_input) {
-    return make_generator(format)->generate(gen_input);
+ErrMsg generate(Format::Enum format, const GenInput& gen_input, std::vector<std::string>& out_blob_file_paths) {
+    std::unique_ptr<Generator> generator = make_generator(format);
+    ErrMsg err = generator->generate(gen_input);
+    out_blob_file_paths = generator->blob_file_paths();
+    return err;
 }
 
 } // namespace
@@ -1,10 +1,12 @@
 #pragma once
+#include <string>
+#include <vector>
 #include "types/gen_input.h"
 #include "types/errmsg.h"
 #include "types/format.h"
 
 namespace shdc::gen {
 
-ErrMsg generate(Format::Enum format, const GenInput& gen_input);
+ErrMsg generate(Format::Enum format, const GenInput& gen_input, std::vector<std::string>& out_blob_file_paths);
 
 }
@@ -3,12 +3,16 @@
 */
 #include "generator.h"
 #include "pystring.h"
+#include "util.h"
 
 using namespace shdc::refl;
 
 namespace shdc::gen {
 
 ErrMsg Generator::generate(const GenInput& gen) {
+    if (gen.args.split_output) {
+        return generate_split(gen);
+    }
     ErrMsg err;
     err = begin(gen);
     if (err.valid()) {
@@ -18,6 +22,7 @@ ErrMsg Generator::generate(const GenInput& gen) {
     gen_header(gen);
     gen_prerequisites(gen);
     gen_vertex_attr_consts(gen);
+    gen_spec_constant_consts(gen);
     gen_bind_slot_consts(gen);
     gen_uniform_block_decls(gen);
     gen_storage_buffer_decls(gen);
@@ -30,6 +35,106 @@ ErrMsg Generator::generate(const GenInput& gen) {
     gen_epilog(gen);
     gen_stb_impl_end(gen);
     err = end(gen);
+    if (err.valid()) {
+        return err;
+    }
+    return write_blob_files(gen);
+}
+
+/* --split-output: write a common output with the module-wide declarations and
+    the shader code shared between programs, one output per program, and an
+    index output (at the regular output path) which includes all other outputs
+*/
+ErrMsg Generator::generate_split(const GenInput& gen) {
+    ErrMsg err = begin(gen);
+    if (err.valid()) {
+        return err;
+    }
+    std::vector<int> snippet_use_count(gen.inp.snippets.size(), 0);
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        if (prog.name == "common") {
+            return gen.inp.error(gen.inp.programs.at(prog.name).line_index, "program name 'common' clashes with the common output file of --split-output");
+        }
+        for (const StageReflection& stage: prog.stages) {
+            if (stage.stage != ShaderStage::Invalid) {
+                snippet_use_count[stage.snippet_index]++;
+            }
+        }
+    }
+    std::vector<std::string> paths;
+
+    // shader code which is used by more than one program goes into the common output
+    Reflection common_refl;
+    common_refl.bindings = gen.refl.bindings;
+    common_refl.sbuf_structs = gen.refl.sbuf_structs;
+    shader_array_mask.assign(gen.inp.snippets.size(), false);
+    for (size_t i = 0; i < snippet_use_count.size(); i++) {
+        shader_array_mask[i] = snippet_use_count[i] > 1;
+    }
+    common_output_path = util::split_output_path(gen.args.output, "common");
+    paths.push_back(common_output_path);
+    err = generate_split_part(gen, Part::Common, paths.back(), common_refl);
+    if (err.valid()) {
+        return err;
+    }
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        Reflection prog_refl;
+        prog_refl.progs.push_back(prog);
+        prog_refl.bindings = prog.bindings;
+        shader_array_mask.assign(gen.inp.snippets.size(), false);
+        for (const StageReflection& stage: prog.stages) {
+            if ((stage.stage != ShaderStage::Invalid) && (snippet_use_count[stage.snippet_index] == 1)) {
+                shader_array_mask[stage.snippet_index] = true;
+            }
+        }
+        paths.push_back(util::split_output_path(gen.args.output, prog.name));
+        err = generate_split_part(gen, Part::Program, paths.back(), prog_refl);
+        if (err.valid()) {
+            return err;
+        }
+    }
+    part = Part::Index;
+    content.clear();
+    gen_split_index(gen, paths);
+    err = end(gen);
+    part = Part::All;
+    if (err.valid()) {
+        return err;
+    }
+    return write_blob_files(gen);
+}
+
+// generate one common or per-program output of --split-output
+ErrMsg Generator::generate_split_part(const GenInput& gen, Part p, const std::string& path, const Reflection& part_refl) {
+    Args part_args = gen.args;
+    part_args.output = path;
+    const GenInput part_gen(part_args, gen.inp, gen.spirvcross, gen.bytecode, part_refl, gen.spv_vs, gen.spv_fs);
+    part = p;
+    content.clear();
+    gen_prolog(part_gen);
+    gen_header(part_gen);
+    gen_prerequisites(part_gen);
+    if (part == Part::Program) {
+        gen_vertex_attr_consts(part_gen);
+        gen_spec_constant_consts(part_gen);
+    }
+    gen_bind_slot_consts(part_gen);
+    if (part == Part::Common) {
+        gen_uniform_block_decls(part_gen);
+        gen_storage_buffer_decls(part_gen);
+    }
+    gen_stb_impl_start(part_gen);
+    gen_shader_arrays(part_gen);
+    if (part == Part::Program) {
+        gen_shader_desc_funcs(part_gen);
+        if (part_gen.args.reflection) {
+            gen_reflection_funcs(part_gen);
+        }
+        gen_epilog(part_gen);
+    }
+    gen_stb_impl_end(part_gen);
+    const ErrMsg err = end(part_gen);
+    part = Part::All;
     return err;
 }
 
@@ -52,6 +157,9 @@ Generator::ShaderStageArrayInfo Generator::shader_stage_array_info(const GenInpu
 // default behaviour of begin is to clear the generated content string, and check for error in GenInput
 ErrMsg Generator::begin(const GenInput& gen) {
     content.clear();
+    blob_files.clear();
+    std::string ext;
+    pystring::os::path::splitext(blob_path_root, ext, gen.args.output);
     return check_errors(gen);
 }
 
@@ -116,6 +224,13 @@ void Generator::gen_program_info(const GenInput& gen, const ProgramReflection& p
         }
         cbl_close();
     }
+    if (!prog.spec_constants.empty()) {
+        cbl_open("Specialization constants:\n");
+        for (const SpecConstant& sc: prog.spec_constants) {
+            cbl("{} => {} (default: {})\n", spec_constant_name(prog.name, sc), sc.constant_id, sc.default_value);
+        }
+        cbl_close();
+    }
 }
 
 void Generator::gen_bindings_info(const GenInput& gen) {
@@ -168,6 +283,14 @@ void Generator::gen_vertex_attr_consts(const GenInput& gen) {
     }
 }
 
+void Generator::gen_spec_constant_consts(const GenInput& gen) {
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        for (const SpecConstant& sc: prog.spec_constants) {
+            l("{}\n", spec_constant_definition(prog.name, sc));
+        }
+    }
+}
+
 void Generator::gen_bind_slot_consts(const GenInput& gen) {
     for (const UniformBlock& ub: gen.refl.bindings.uniform_blocks) {
         l("{}\n", uniform_block_bind_slot_definition(ub));
@@ -202,83 +325,85 @@ void Generator::gen_shader_arrays(const GenInput& gen) {
     for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
         Slang::Enum slang = Slang::from_index(slang_idx);
         if (gen.args.slang & Slang::bit(slang)) {
-            const Spirvcross& spirvcross = gen.spirvcross[slang];
-            const Bytecode& bytecode = gen.bytecode[slang];
-            for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
-                const Snippet& snippet = gen.inp.snippets[snippet_index];
-                if ((snippet.type != Snippet::VS) && (snippet.type != Snippet::FS) && (snippet.type != Snippet::CS)) {
-                    continue;
-                }
-                const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
-                assert(src);
-                const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(snippet_index);
-                std::vector<std::string> lines;
-                pystring::splitlines(src->source_code, lines);
-                // first write the source code in a comment block
-                cbl_start();
-                for (const std::string& line: lines) {
-                    cbl("{}\n", fix_shader_source_for_code_comment(line));
-                }
-                cbl_end();
-                if (blob) {
-                    const std::string array_name = shader_bytecode_array_name(snippet.name, slang);
-                    gen_shader_array_start(gen, array_name, blob->data.size(), slang);
-                    const size_t len = blob->data.size();
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        l("{:#04x},", blob->data[i]);
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
-                } else {
-                    // if no bytecode exists, write the source code, but also a byte array with a trailing 0
-                    const std::string array_name = shader_source_array_name(snippet.name, slang);
-                    const size_t len = src->source_code.length() + 1;
-                    gen_shader_array_start(gen, array_name, len, slang);
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        l("{:#04x},", (int)src->source_code[i]);
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
-                }
-            }
+            gen_shader_arrays_for_slang(gen, slang);
         }
     }
-    if (!gen.spv_vs.empty() && !gen.spv_fs.empty()) {
-        const auto& spv_vs = gen.spv_vs;
-        const auto& spv_fs = gen.spv_fs;
-        gen_shader_array_start(gen, gen.inp.module + "_glsl_spv_vs", spv_vs.size(), Slang::GLSL450);
-        for (size_t i = 0; i < spv_vs.size(); i++) {
-            if ((i & 15) == 0) {
-                l("    ");
-            }
-            l("{:#04x},", (int)spv_vs[i]);
-            if ((i & 15) == 15) {
-                l("\n");
-            }
+    if (!gen.spv_vs.empty() && !gen.spv_fs.empty() && (part != Part::Program)) {
+        gen_glsl_spv_arrays(gen);
+    }
+}
+
+void Generator::gen_shader_arrays_for_slang(const GenInput& gen, Slang::Enum slang) {
+    const Spirvcross& spirvcross = gen.spirvcross[slang];
+    const Bytecode& bytecode = gen.bytecode[slang];
+    for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
+        const Snippet& snippet = gen.inp.snippets[snippet_index];
+        if ((snippet.type != Snippet::VS) && (snippet.type != Snippet::FS) && (snippet.type != Snippet::CS)) {
+            continue;
         }
-        gen_shader_array_end(gen);
-        gen_shader_array_start(gen, gen.inp.module + "_glsl_spv_fs", spv_fs.size(), Slang::GLSL450);
-        for (size_t i = 0; i < spv_fs.size(); i++) {
-            if ((i & 15) == 0) {
-                l("    ");
-            }
-            l("{:#04x},", (int)spv_fs[i]);
-            if ((i & 15) == 15) {
-                l("\n");
-            }
+        if ((part != Part::All) && !shader_array_mask[snippet_index]) {
+            continue;
+        }
+        const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
+        assert(src);
+        const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(snippet_index);
+        std::vector<std::string> lines;
+        pystring::splitlines(src->source_code, lines);
+        // first write the source code in a comment block
+        cbl_start();
+        for (const std::string& line: lines) {
+            cbl("{}\n", fix_shader_source_for_code_comment(line));
+        }
+        cbl_end();
+        if (blob) {
+            gen_shader_array(gen, shader_bytecode_array_name(snippet.name, slang), blob->data.data(), blob->data.size(), slang);
+        } else {
+            // if no bytecode exists, write the source code, but also a byte array with a trailing 0
+            gen_shader_array(gen, shader_source_array_name(snippet.name, slang), (const uint8_t*)src->source_code.c_str(), src->source_code.length() + 1, slang);
+        }
+    }
+}
+
+void Generator::gen_glsl_spv_arrays(const GenInput& gen) {
+    gen_shader_array(gen, gen.inp.module + "_glsl_spv_vs", gen.spv_vs.data(), gen.spv_vs.size(), Slang::GLSL450);
+    gen_shader_array(gen, gen.inp.module + "_glsl_spv_fs", gen.spv_fs.data(), gen.spv_fs.size(), Slang::GLSL450);
+}
+
+// default behaviour is to write the bytes as hex initializers between gen_shader_array_start() and gen_shader_array_end()
+void Generator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    gen_shader_array_start(gen, array_name, num_bytes, slang);
+    gen_shader_array_bytes(bytes, num_bytes);
+    gen_shader_array_end(gen);
+}
+
+void Generator::gen_shader_array_bytes(const uint8_t* bytes, size_t num_bytes) {
+    for (size_t i = 0; i < num_bytes; i++) {
+        if ((i & 15) == 0) {
+            l("    ");
+        }
+        l("{:#04x},", bytes[i]);
+        if ((i & 15) == 15) {
+            l("\n");
+        }
+    }
+}
+
+// record a shader array for --embed-files, returns the path of the file which is written by write_blob_files()
+std::string Generator::add_blob_file(const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    // the same array may be generated several times (e.g. the GLSL SPIRV arrays
+    // in each GLSL backend file with --split-backends) but must only be defined once
+    for (const BlobFile& blob_file: blob_files) {
+        if (blob_file.array_name == array_name) {
+            return blob_file.path;
         }
-        gen_shader_array_end(gen);
     }
+    BlobFile blob_file;
+    blob_file.path = fmt::format("{}_{}.bin", blob_path_root, array_name);
+    blob_file.array_name = array_name;
+    blob_file.slang = slang;
+    blob_file.data.assign(bytes, bytes + num_bytes);
+    blob_files.push_back(blob_file);
+    return blob_file.path;
 }
 
 void Generator::gen_shader_desc_funcs(const GenInput& gen) {
@@ -294,15 +419,39 @@ void Generator::gen_reflection_funcs(const GenInput& gen) {
         gen_sampler_slot_refl_func(gen, prog);
         gen_uniform_block_slot_refl_func(gen, prog);
         gen_uniform_block_size_refl_func(gen, prog);
+        gen_uniform_block_used_range_refl_func(gen, prog);
         gen_uniform_offset_refl_func(gen, prog);
+        gen_uniform_used_refl_func(gen, prog);
         gen_uniform_desc_refl_func(gen, prog);
         gen_storage_buffer_slot_refl_func(gen, prog);
         gen_storage_image_slot_refl_func(gen, prog);
     }
 }
 
+// check if a file exists and has the given content
+static bool file_content_equals(const std::string& path, const std::string& content, bool binary = false) {
+    FILE* f = fopen(path.c_str(), binary ? "rb" : "r");
+    if (!f) {
+        return false;
+    }
+    std::string file_content;
+    char buf[4096];
+    size_t num_bytes;
+    while ((num_bytes = fread(buf, 1, sizeof(buf), f)) > 0) {
+        file_content.append(buf, num_bytes);
+    }
+    fclose(f);
+    return file_content == content;
+}
+
 // default behaviour of end() is to write the output file
 ErrMsg Generator::end(const GenInput& gen) {
+    // with --split-output, unchanged common and per-program outputs are not rewritten
+    // so that their timestamps don't trigger rebuilds of downstream code, the index
+    // output is always written since it is the target build systems check against
+    if (((part == Part::Common) || (part == Part::Program)) && file_content_equals(gen.args.output, content)) {
+        return ErrMsg();
+    }
     FILE* f = fopen(gen.args.output.c_str(), "w");
     if (!f) {
         return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", gen.args.output));
@@ -312,6 +461,31 @@ ErrMsg Generator::end(const GenInput& gen) {
     return ErrMsg();
 }
 
+std::vector<std::string> Generator::blob_file_paths() const {
+    std::vector<std::string> res;
+    for (const BlobFile& blob_file: blob_files) {
+        res.push_back(blob_file.path);
+    }
+    return res;
+}
+
+// write the files recorded with add_blob_file(), unchanged files are not rewritten
+ErrMsg Generator::write_blob_files(const GenInput& gen) {
+    for (const BlobFile& blob_file: blob_files) {
+        const std::string data(blob_file.data.begin(), blob_file.data.end());
+        if (file_content_equals(blob_file.path, data, true)) {
+            continue;
+        }
+        FILE* f = fopen(blob_file.path.c_str(), "wb");
+        if (!f) {
+            return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", blob_file.path));
+        }
+        fwrite(data.data(), data.size(), 1, f);
+        fclose(f);
+    }
+    return ErrMsg();
+}
+
 // check that each input shader has the expected stage shaders
 ErrMsg Generator::check_errors(const GenInput& gen) {
     for (int i = 0; i < Slang::Num; i++) {
@@ -392,6 +566,88 @@ std::string Generator::to_camel_case(const std::string& str) {
     return res;
 }
 
+// FNV-1a, length-prefixed so that consecutive items can't alias
+static uint64_t hash_bytes(uint64_t hash, const void* ptr, size_t num_bytes) {
+    const uint64_t prime = 0x100000001b3ULL;
+    const uint64_t len = num_bytes;
+    for (int i = 0; i < 8; i++) {
+        hash = (hash ^ ((len >> (i * 8)) & 0xFF)) * prime;
+    }
+    const uint8_t* bytes = (const uint8_t*)ptr;
+    for (size_t i = 0; i < num_bytes; i++) {
+        hash = (hash ^ bytes[i]) * prime;
+    }
+    return hash;
+}
+
+static uint64_t hash_str(uint64_t hash, const std::string& str) {
+    return hash_bytes(hash, str.data(), str.length());
+}
+
+uint64_t Generator::program_hash(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hash_str(hash, Slang::to_str(slang));
+    // final shader source code or bytecode of each stage
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        const StageReflection& refl = prog.stages[stage_index];
+        if (refl.stage == ShaderStage::Invalid) {
+            continue;
+        }
+        hash = hash_str(hash, fmt::format("stage:{}:{}", ShaderStage::to_str(refl.stage), refl.entry_point_by_slang(slang)));
+        const BytecodeBlob* blob = gen.bytecode[slang].find_blob_by_snippet_index(refl.snippet_index);
+        const SpirvcrossSource* src = gen.spirvcross[slang].find_source_by_snippet_index(refl.snippet_index);
+        if (blob) {
+            hash = hash_bytes(hash, blob->data.data(), blob->data.size());
+        } else if (src) {
+            hash = hash_str(hash, src->source_code);
+        }
+        if (refl.stage == ShaderStage::Compute) {
+            hash = hash_str(hash, fmt::format("wg:{}:{}:{}", refl.cs_workgroup_size[0], refl.cs_workgroup_size[1], refl.cs_workgroup_size[2]));
+        }
+    }
+    // binding layout
+    if (prog.has_vs()) {
+        for (const StageAttr& attr: prog.vs().inputs) {
+            if (attr.slot >= 0) {
+                hash = hash_str(hash, fmt::format("attr:{}:{}:{}:{}:{}", attr.slot, attr.name, attr.sem_name, attr.sem_index, Type::type_to_str(attr.type_info.type)));
+            }
+        }
+    }
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        hash = hash_str(hash, fmt::format("ub:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}",
+            ub.sokol_slot, (int)ub.stage, ub.name, ub.inst_name, ub.struct_info.size, ub.flattened,
+            ub.hlsl_register_b_n, ub.msl_buffer_n, ub.wgsl_group0_binding_n, ub.spirv_set0_binding_n));
+        for (const Type& u: ub.struct_info.struct_items) {
+            hash = hash_str(hash, fmt::format("u:{}:{}:{}:{}", u.name, Type::type_to_str(u.type), u.offset, u.array_count));
+        }
+    }
+    for (const Texture& tex: prog.bindings.textures) {
+        hash = hash_str(hash, fmt::format("tex:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}",
+            tex.sokol_slot, (int)tex.stage, tex.name, (int)tex.type, (int)tex.sample_type, tex.multisampled,
+            tex.hlsl_register_t_n, tex.msl_texture_n, tex.wgsl_group1_binding_n, tex.spirv_set1_binding_n));
+    }
+    for (const Sampler& smp: prog.bindings.samplers) {
+        hash = hash_str(hash, fmt::format("smp:{}:{}:{}:{}:{}:{}:{}:{}",
+            smp.sokol_slot, (int)smp.stage, smp.name, (int)smp.type,
+            smp.hlsl_register_s_n, smp.msl_sampler_n, smp.wgsl_group1_binding_n, smp.spirv_set1_binding_n));
+    }
+    for (const TextureSampler& tex_smp: prog.bindings.texture_samplers) {
+        hash = hash_str(hash, fmt::format("texsmp:{}:{}:{}:{}:{}", tex_smp.sokol_slot, (int)tex_smp.stage, tex_smp.name, tex_smp.texture_name, tex_smp.sampler_name));
+    }
+    for (const StorageBuffer& sbuf: prog.bindings.storage_buffers) {
+        hash = hash_str(hash, fmt::format("sbuf:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}",
+            sbuf.sokol_slot, (int)sbuf.stage, sbuf.name, sbuf.readonly,
+            sbuf.hlsl_register_t_n, sbuf.hlsl_register_u_n, sbuf.msl_buffer_n,
+            sbuf.wgsl_group1_binding_n, sbuf.spirv_set1_binding_n, sbuf.glsl_binding_n, sbuf.struct_info.size));
+    }
+    for (const StorageImage& simg: prog.bindings.storage_images) {
+        hash = hash_str(hash, fmt::format("simg:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}",
+            simg.sokol_slot, (int)simg.stage, simg.name, simg.writeonly, (int)simg.type, (int)simg.access_format,
+            simg.hlsl_register_u_n, simg.msl_texture_n, simg.wgsl_group1_binding_n, simg.spirv_set1_binding_n, simg.glsl_binding_n));
+    }
+    return hash;
+}
+
 const char* Generator::hlsl_target(Slang::Enum slang, ShaderStage::Enum stage) {
     switch (slang) {
         case Slang::HLSL4: switch (stage) {
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "pystring.h"
 #include "types/gen_input.h"
 
@@ -10,14 +11,49 @@ class Generator {
 public:
     virtual ~Generator() {};
     virtual ErrMsg generate(const GenInput& gen);
+    // --embed-files: paths of the files written by generate() besides the regular outputs
+    std::vector<std::string> blob_file_paths() const;
 
 protected:
+    // the part of a module which is currently generated, with --split-output
+    // a module is written as a common output, one output per program and an
+    // index output which includes all other outputs
+    enum class Part {
+        All,        // everything in a single output (default)
+        Common,     // bind slots, uniform block and storage buffer declarations, shared shader code
+        Program,    // a single program (the only item in gen.refl.progs)
+        Index,      // includes the common and per-program outputs
+    };
+    Part part = Part::All;
+    std::vector<bool> shader_array_mask;    // Part::Common/Program: snippets with shader arrays in the current output
+    std::string common_output_path;         // Part::Program: path of the common output
+
+    // called by generate() instead of the regular sequence for --split-output
+    virtual ErrMsg generate_split(const GenInput& gen);
+    virtual ErrMsg generate_split_part(const GenInput& gen, Part p, const std::string& path, const refl::Reflection& part_refl);
+    // called by generate_split() for Part::Index with the paths of the common and per-program outputs
+    virtual void gen_split_index(const GenInput& gen, const std::vector<std::string>& paths) { assert(false && "implement me"); };
+
+    // --embed-files: shader arrays which are written into separate binary files
+    struct BlobFile {
+        std::string path;
+        std::string array_name;
+        Slang::Enum slang = Slang::Num;
+        std::vector<uint8_t> data;
+    };
+    std::vector<BlobFile> blob_files;
+    std::string blob_path_root;             // output path without extension, blob files are written to [root]_[array_name].bin
+    std::string add_blob_file(const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang);
+    // called by generate() after end()
+    virtual ErrMsg write_blob_files(const GenInput& gen);
+
     // called directly by generate() in this order
     virtual ErrMsg begin(const GenInput& gen);
     virtual void gen_prolog(const GenInput& gen);
     virtual void gen_header(const GenInput& gen);
     virtual void gen_prerequisites(const GenInput& gen);
     virtual void gen_vertex_attr_consts(const GenInput& gen);
+    virtual void gen_spec_constant_consts(const GenInput& gen);
     virtual void gen_bind_slot_consts(const GenInput& gen);
     virtual void gen_uniform_block_decls(const GenInput& gen);
     virtual void gen_storage_buffer_decls(const GenInput& gen);
@@ -40,6 +76,10 @@ protected:
     virtual void gen_storage_buffer_decl(const GenInput& gen, const refl::Type& sbuf_struct) { assert(false && "implement me"); };
 
     // called by gen_shader_arrays()
+    void gen_shader_arrays_for_slang(const GenInput& gen, Slang::Enum slang);
+    void gen_glsl_spv_arrays(const GenInput& gen);
+    virtual void gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang);
+    void gen_shader_array_bytes(const uint8_t* bytes, size_t num_bytes);
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) { assert(false && "implement me"); };
     virtual void gen_shader_array_end(const GenInput& gen) { assert(false && "implement me"); };
 
@@ -52,7 +92,9 @@ protected:
     virtual void gen_sampler_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& progm) { };
     virtual void gen_uniform_block_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
     virtual void gen_uniform_block_size_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
+    virtual void gen_uniform_block_used_range_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
     virtual void gen_uniform_offset_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
+    virtual void gen_uniform_used_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
     virtual void gen_uniform_desc_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
     virtual void gen_storage_buffer_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
     virtual void gen_storage_image_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog) { };
@@ -80,6 +122,7 @@ protected:
 
     virtual std::string struct_name(const std::string& name) { assert(false && "implement me"); return ""; };
     virtual std::string vertex_attr_name(const std::string& prog_name, const refl::StageAttr& attr) { assert(false && "implement me"); return ""; };
+    virtual std::string spec_constant_name(const std::string& prog_name, const refl::SpecConstant& sc) { assert(false && "implement me"); return ""; };
     virtual std::string texture_bind_slot_name(const refl::Texture& tex) { assert(false && "implement me"); return ""; };
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp) { assert(false && "implement me"); return ""; };
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub) { assert(false && "implement me"); return ""; };
@@ -87,6 +130,7 @@ protected:
     virtual std::string storage_image_bind_slot_name(const refl::StorageImage& simg) { assert(false && "implement me"); return ""; };
 
     virtual std::string vertex_attr_definition(const std::string& prog_name, const refl::StageAttr& attr) { assert(false && "implement me"); return ""; };
+    virtual std::string spec_constant_definition(const std::string& prog_name, const refl::SpecConstant& sc) { assert(false && "implement me"); return ""; };
     virtual std::string texture_bind_slot_definition(const refl::Texture& img) { assert(false && "implement me"); return ""; };
     virtual std::string storage_buffer_bind_slot_definition(const refl::StorageBuffer& sbuf) { assert(false && "implement me"); return ""; };
     virtual std::string storage_image_bind_slot_definition(const refl::StorageImage& simg) { assert(false && "implement me"); return ""; };
@@ -155,6 +199,8 @@ protected:
     static std::string to_pascal_case(const std::string& str);
     static std::string to_ada_case(const std::string& str);
     static const char* hlsl_target(Slang::Enum slang, ShaderStage::Enum stage);
+    // stable 64-bit hash over a program's final shader code and binding layout for one shader language
+    static uint64_t program_hash(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang);
 
     std::string content;
     int tab_width = 4;
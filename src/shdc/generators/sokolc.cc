@@ -4,6 +4,7 @@
 #include "sokolc.h"
 #include "fmt/format.h"
 #include "pystring.h"
+#include "util.h"
 #include <stdio.h>
 
 namespace shdc::gen {
@@ -45,6 +46,11 @@ ErrMsg SokolCGenerator::begin(const GenInput& gen) {
 
 void SokolCGenerator::gen_prolog(const GenInput& gen) {
     l("#pragma once\n");
+    if (part == Part::Program) {
+        // @header statements and prerequisites are in the common header
+        l("#include \"{}\"\n", pystring::os::path::basename(common_output_path));
+        return;
+    }
     for (const auto& header: gen.inp.headers) {
         l("{}\n", header);
     }
@@ -55,35 +61,74 @@ void SokolCGenerator::gen_epilog(const GenInput& gen) {
 }
 
 void SokolCGenerator::gen_prerequisites(const GenInput& gen) {
-    l("#if !defined(SOKOL_GFX_INCLUDED)\n");
-    l("#error \"Please include sokol_gfx.h before {}\"\n", pystring::os::path::basename(gen.args.output));
-    l("#endif\n");
-    l("#if !defined(SOKOL_SHDC_ALIGN)\n");
-    l("#if defined(_MSC_VER)\n");
-    l("#define SOKOL_SHDC_ALIGN(a) __declspec(align(a))\n");
-    l("#else\n");
-    l("#define SOKOL_SHDC_ALIGN(a) __attribute__((aligned(a)))\n");
-    l("#endif\n");
-    l("#endif\n");
+    if (part != Part::Program) {
+        gen_common_prerequisites(gen);
+    }
     if (gen.args.output_format == Format::SOKOL_IMPL) {
-        for (const auto& item: gen.inp.programs) {
-            const Program& prog = item.second;
+        for (const ProgramReflection& prog: gen.refl.progs) {
             l("const sg_shader_desc* {}{}_shader_desc(sg_backend backend);\n", mod_prefix, prog.name);
+            l("uint64_t {}{}_shader_hash(sg_backend backend);\n", mod_prefix, prog.name);
             if (gen.args.reflection) {
                 l("int {}{}_attr_slot(const char* attr_name);\n", mod_prefix, prog.name);
                 l("int {}{}_texture_slot(const char* tex_name);\n", mod_prefix, prog.name);
                 l("int {}{}_sampler_slot(const char* smp_name);\n", mod_prefix, prog.name);
                 l("int {}{}_uniformblock_slot(const char* ub_name);\n", mod_prefix, prog.name);
                 l("size_t {}{}_uniformblock_size(const char* ub_name);\n", mod_prefix, prog.name);
+                l("int {}{}_uniformblock_used_offset(const char* ub_name);\n", mod_prefix, prog.name);
+                l("size_t {}{}_uniformblock_used_size(const char* ub_name);\n", mod_prefix, prog.name);
                 l("int {}{}_storagebuffer_slot(const char* sbuf_name);\n", mod_prefix, prog.name);
                 l("int {}{}_storageimage_slot(const char* simg_name);\n", mod_prefix, prog.name);
                 l("int {}{}_uniform_offset(const char* ub_name, const char* u_name);\n", mod_prefix, prog.name);
+                l("bool {}{}_uniform_used(const char* ub_name, const char* u_name);\n", mod_prefix, prog.name);
                 l("sg_glsl_shader_uniform {}{}_uniform_desc(const char* ub_name, const char* u_name);\n", mod_prefix, prog.name);
             }
         }
     }
 }
 
+// prerequisites shared by all programs (in the common header with --split-output)
+void SokolCGenerator::gen_common_prerequisites(const GenInput& gen) {
+    l("#if !defined(SOKOL_GFX_INCLUDED)\n");
+    l("#error \"Please include sokol_gfx.h before {}\"\n", pystring::os::path::basename(gen.args.output));
+    l("#endif\n");
+    l("#if !defined(SOKOL_SHDC_ALIGN)\n");
+    l("#if defined(_MSC_VER)\n");
+    l("#define SOKOL_SHDC_ALIGN(a) __declspec(align(a))\n");
+    l("#else\n");
+    l("#define SOKOL_SHDC_ALIGN(a) __attribute__((aligned(a)))\n");
+    l("#endif\n");
+    l("#endif\n");
+    if (gen.args.cpp_uniforms) {
+        gen_cpp_uniform_helpers(gen);
+    }
+    if (gen.args.sbuf_packers) {
+        l("#include <string.h>\n");
+    }
+    if (gen.args.embed_files) {
+        l("#if !defined(SOKOL_SHDC_EXTERN)\n");
+        l("#if defined(__cplusplus)\n");
+        l("#define SOKOL_SHDC_EXTERN extern \"C\"\n");
+        l("#else\n");
+        l("#define SOKOL_SHDC_EXTERN extern\n");
+        l("#endif\n");
+        l("#endif\n");
+    }
+}
+
+void SokolCGenerator::gen_bind_slot_consts(const GenInput& gen) {
+    if (part != Part::Program) {
+        Generator::gen_bind_slot_consts(gen);
+    }
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        for (int i = 0; i < Slang::Num; i++) {
+            Slang::Enum slang = Slang::from_index(i);
+            if (gen.args.slang & Slang::bit(slang)) {
+                l("{}\n", shader_hash_definition(gen, prog, slang));
+            }
+        }
+    }
+}
+
 void SokolCGenerator::gen_uniform_block_decl(const GenInput &gen, const UniformBlock& ub) {
     l("#pragma pack(push,1)\n");
     int cur_offset = 0;
@@ -134,6 +179,149 @@ void SokolCGenerator::gen_uniform_block_decl(const GenInput &gen, const UniformB
     }
     l_close("}} {};\n", struct_name(ub.name));
     l("#pragma pack(pop)\n");
+    if (gen.args.cpp_uniforms) {
+        gen_cpp_uniform_block_decl(gen, ub);
+    }
+}
+
+// returns the stable content hash of a program for a backend, matching the shader desc returned by _shader_desc()
+void SokolCGenerator::gen_shader_hash_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}uint64_t {}{}_shader_hash(sg_backend backend) {{\n", func_prefix, mod_prefix, prog.name);
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            if (gen.args.ifdef) {
+                l("#if defined({})\n", sokol_define(slang));
+            }
+            l_open("if (backend == {}) {{\n", backend(slang));
+            l("return {};\n", shader_hash_name(prog, slang));
+            l_close("}}\n");
+            if (gen.args.ifdef) {
+                l("#endif /* {} */\n", sokol_define(slang));
+            }
+        }
+    }
+    l("return 0;\n");
+    l_close("}}\n");
+}
+
+std::string SokolCGenerator::shader_hash_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return fmt::format("SHADER_HASH_{}{}_{}", mod_prefix, prog.name, Slang::to_str(slang));
+}
+
+std::string SokolCGenerator::shader_hash_definition(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    return fmt::format("#define {} (0x{:016X}ULL)", shader_hash_name(prog, slang), program_hash(gen, prog, slang));
+}
+
+void SokolCGenerator::gen_cpp_uniform_helpers(const GenInput& gen) {
+    l("#if defined(__cplusplus) && !defined(SOKOL_SHDC_CPP_UNIFORMS_INCLUDED)\n");
+    l("#define SOKOL_SHDC_CPP_UNIFORMS_INCLUDED\n");
+    l("#include <stddef.h>\n");
+    l("#include <string.h>\n");
+    l_open("namespace sokol_shdc {{\n");
+    l("struct float2 {{ float x, y; }};\n");
+    l("struct float3 {{ float x, y, z; }};\n");
+    l("struct float4 {{ float x, y, z, w; }};\n");
+    l("struct int2 {{ int x, y; }};\n");
+    l("struct int3 {{ int x, y, z; }};\n");
+    l("struct int4 {{ int x, y, z, w; }};\n");
+    l("struct float4x4 {{ float4 cols[4]; }};\n");
+    l("// a range of modified 16-byte std140 rows in a uniform block\n");
+    l_open("struct dirty_rows {{\n");
+    l("int first = 0;\n");
+    l("int count = 0;\n");
+    l("bool empty() const {{ return count == 0; }}\n");
+    l("size_t offset() const {{ return (size_t)first * 16; }}\n");
+    l("size_t size() const {{ return (size_t)count * 16; }}\n");
+    l_close("}};\n");
+    l("// tracks which rows of a uniform block struct changed since the last apply()\n");
+    l_open("template<typename T> struct uniform_tracker {{\n");
+    l("T data = {{}};\n");
+    l("T applied = {{}};\n");
+    l("bool valid = false;\n");
+    l_open("dirty_rows dirty() const {{\n");
+    l("dirty_rows res;\n");
+    l_open("if (!valid) {{\n");
+    l("res.count = T::num_rows;\n");
+    l("return res;\n");
+    l_close("}}\n");
+    l("const unsigned char* cur = (const unsigned char*)&data;\n");
+    l("const unsigned char* prev = (const unsigned char*)&applied;\n");
+    l("int last = -1;\n");
+    l_open("for (int row = 0; row < T::num_rows; row++) {{\n");
+    l_open("if (memcmp(cur + row * 16, prev + row * 16, 16) != 0) {{\n");
+    l_open("if (last < 0) {{\n");
+    l("res.first = row;\n");
+    l_close("}}\n");
+    l("last = row;\n");
+    l_close("}}\n");
+    l_close("}}\n");
+    l_open("if (last >= 0) {{\n");
+    l("res.count = last - res.first + 1;\n");
+    l_close("}}\n");
+    l("return res;\n");
+    l_close("}}\n");
+    l("// must be called after each sg_apply_pipeline(), since that invalidates all applied uniforms\n");
+    l("void reset() {{ valid = false; }}\n");
+    l("// returns the dirty row range and marks the current data as applied\n");
+    l_open("dirty_rows apply() {{\n");
+    l("const dirty_rows res = dirty();\n");
+    l("memcpy(&applied, &data, sizeof(T));\n");
+    l("valid = true;\n");
+    l("return res;\n");
+    l_close("}}\n");
+    l("sg_range range() const {{ sg_range r = {{ &data, sizeof(T) }}; return r; }}\n");
+    l_close("}};\n");
+    l_close("}} // namespace sokol_shdc\n");
+    l("#endif\n");
+}
+
+std::string SokolCGenerator::cpp_uniform_type(const GenInput& gen, const Type& uniform) {
+    if (gen.inp.ctype_map.count(uniform.type_as_glsl()) > 0) {
+        return gen.inp.ctype_map.at(uniform.type_as_glsl());
+    }
+    switch (uniform.type) {
+        case Type::Float:   return "float";
+        case Type::Float2:  return "sokol_shdc::float2";
+        case Type::Float3:  return "sokol_shdc::float3";
+        case Type::Float4:  return "sokol_shdc::float4";
+        case Type::Int:     return "int";
+        case Type::Int2:    return "sokol_shdc::int2";
+        case Type::Int3:    return "sokol_shdc::int3";
+        case Type::Int4:    return "sokol_shdc::int4";
+        case Type::Mat4x4:  return "sokol_shdc::float4x4";
+        default:            return "INVALID_UNIFORM_TYPE";
+    }
+}
+
+void SokolCGenerator::gen_cpp_uniform_block_decl(const GenInput& gen, const UniformBlock& ub) {
+    const std::string cpp_struct_name = fmt::format("{}{}_cpp_t", mod_prefix, ub.name);
+    int cur_offset = 0;
+    l("#if defined(__cplusplus)\n");
+    l_open("struct alignas(16) {} {{\n", cpp_struct_name);
+    for (const Type& uniform: ub.struct_info.struct_items) {
+        if (uniform.offset > cur_offset) {
+            l("uint8_t _pad_{}[{}];\n", cur_offset, uniform.offset - cur_offset);
+            cur_offset = uniform.offset;
+        }
+        if (uniform.array_count == 0) {
+            l("{} {};\n", cpp_uniform_type(gen, uniform), uniform.name);
+        } else {
+            l("{} {}[{}];\n", cpp_uniform_type(gen, uniform), uniform.name, uniform.array_count);
+        }
+        cur_offset += uniform.size;
+    }
+    const int round16 = roundup(cur_offset, 16);
+    if (cur_offset < round16) {
+        l("uint8_t _pad_{}[{}];\n", cur_offset, round16 - cur_offset);
+    }
+    l("static constexpr int num_rows = {};\n", round16 / 16);
+    l_close("}};\n");
+    l("static_assert(sizeof({}) == sizeof({}), \"{}: size mismatch with std140 layout\");\n", cpp_struct_name, struct_name(ub.name), cpp_struct_name);
+    for (const Type& uniform: ub.struct_info.struct_items) {
+        l("static_assert(offsetof({}, {}) == {}, \"{}.{}: offset mismatch with std140 layout\");\n", cpp_struct_name, uniform.name, uniform.offset, cpp_struct_name, uniform.name);
+    }
+    l("#endif\n");
 }
 
 void SokolCGenerator::gen_struct_interior_decl_std430(const GenInput& gen, const Type& struc, int pad_to_size) {
@@ -248,9 +436,140 @@ void SokolCGenerator::gen_storage_buffer_decl(const GenInput& gen, const Type& s
     gen_struct_interior_decl_std430(gen, struc, struc.size);
     l_close("}} {};\n", struct_name(struc.struct_typename));
     l("#pragma pack(pop)\n");
+    if (gen.args.sbuf_packers) {
+        gen_storage_buffer_packers(gen, struc);
+    }
+}
+
+// a scalar, vector or matrix item in a (possibly nested) std430 struct
+struct PackerLeaf {
+    std::string name;
+    const char* ctype = "float";
+    int offset = 0;
+    int rows = 1;
+    int columns = 1;
+    int column_stride = 0;
+    std::vector<std::pair<int,int>> dims;     // (array_count, array_stride) of enclosing arrays, outermost first
+};
+
+static void gather_packer_leafs(const Type& struc, const std::string& prefix, int base_offset, std::vector<std::pair<int,int>> dims, std::vector<PackerLeaf>& out_leafs) {
+    for (const Type& item: struc.struct_items) {
+        std::vector<std::pair<int,int>> item_dims = dims;
+        if (item.is_array && (item.array_count > 0)) {
+            item_dims.push_back({ item.array_count, item.array_stride });
+        }
+        if (item.type == Type::Struct) {
+            gather_packer_leafs(item, fmt::format("{}{}_", prefix, item.name), base_offset + item.offset, item_dims, out_leafs);
+            continue;
+        }
+        PackerLeaf leaf;
+        leaf.name = prefix + item.name;
+        leaf.offset = base_offset + item.offset;
+        leaf.dims = item_dims;
+        switch (item.basetype()) {
+            case Type::Bool:
+            case Type::Int:     leaf.ctype = "int32_t"; break;
+            case Type::UInt:    leaf.ctype = "uint32_t"; break;
+            default:            leaf.ctype = "float"; break;
+        }
+        if (item.is_matrix) {
+            // MatCxR: C columns of R components, each column starts at a multiple of matrix_stride
+            const int index = (int)item.type - (int)Type::Mat2x1;
+            leaf.columns = 2 + (index / 4);
+            leaf.rows = 1 + (index % 4);
+            leaf.column_stride = item.matrix_stride;
+        } else {
+            const int index = ((int)item.type - (int)Type::Bool) % 4;
+            leaf.rows = 1 + index;
+        }
+        out_leafs.push_back(leaf);
+    }
+}
+
+void SokolCGenerator::gen_storage_buffer_packers(const GenInput& gen, const Type& struc) {
+    const std::string name = fmt::format("{}{}", mod_prefix, struc.struct_typename);
+    std::vector<PackerLeaf> leafs;
+    gather_packer_leafs(struc, "", 0, {}, leafs);
+
+    l("// structure-of-arrays layout for {}, items are tightly packed, matrices are column-major\n", struct_name(struc.struct_typename));
+    l_open("typedef struct {}_soa_t {{\n", name);
+    for (const PackerLeaf& leaf: leafs) {
+        l("{}* {};\n", leaf.ctype, leaf.name);
+    }
+    l_close("}} {}_soa_t;\n", name);
+
+    for (int unpack = 0; unpack < 2; unpack++) {
+        if (unpack) {
+            l("// convert num std430 array items at src into the structure-of-arrays layout at dst\n");
+            l_open("static inline void {}_unpack({}_soa_t* dst, const {}* src, size_t num) {{\n", name, name, struct_name(struc.struct_typename));
+            l("const uint8_t* src_bytes = (const uint8_t*)src;\n");
+        } else {
+            l("// convert num items in structure-of-arrays layout at src into std430 array items at dst\n");
+            l_open("static inline void {}_pack({}* dst, const {}_soa_t* src, size_t num) {{\n", name, struct_name(struc.struct_typename), name);
+            l("uint8_t* dst_bytes = (uint8_t*)dst;\n");
+        }
+        for (const PackerLeaf& leaf: leafs) {
+            int num_comps = leaf.rows * leaf.columns;
+            for (const auto& dim: leaf.dims) {
+                num_comps *= dim.first;
+            }
+            // each item gets its own loop with constant strides, so that compilers can vectorize it
+            l_open("for (size_t i = 0; i < num; i++) {{\n");
+            if (unpack) {
+                l("const uint8_t* s = src_bytes + i * {} + {};\n", struc.size, leaf.offset);
+                l("{}* d = dst->{} + i * {};\n", leaf.ctype, leaf.name, num_comps);
+            } else {
+                l("uint8_t* d = dst_bytes + i * {} + {};\n", struc.size, leaf.offset);
+                l("const {}* s = src->{} + i * {};\n", leaf.ctype, leaf.name, num_comps);
+            }
+            std::string bytes_offset;
+            std::string comps_index;
+            for (size_t dim_index = 0; dim_index < leaf.dims.size(); dim_index++) {
+                const auto& dim = leaf.dims[dim_index];
+                const std::string var = fmt::format("j{}", dim_index);
+                l_open("for (int {} = 0; {} < {}; {}++) {{\n", var, var, dim.first, var);
+                bytes_offset += fmt::format(" + {} * {}", var, dim.second);
+                comps_index = comps_index.empty() ? var : fmt::format("({}) * {} + {}", comps_index, dim.first, var);
+            }
+            if (leaf.columns > 1) {
+                l_open("for (int c = 0; c < {}; c++) {{\n", leaf.columns);
+                bytes_offset += fmt::format(" + c * {}", leaf.column_stride);
+                comps_index = comps_index.empty() ? "c" : fmt::format("({}) * {} + c", comps_index, leaf.columns);
+            }
+            std::string comps_offset;
+            if (!comps_index.empty()) {
+                if (comps_index.find(' ') != std::string::npos) {
+                    comps_offset = fmt::format(" + ({}) * {}", comps_index, leaf.rows);
+                } else {
+                    comps_offset = fmt::format(" + {} * {}", comps_index, leaf.rows);
+                }
+            }
+            if (unpack) {
+                l("memcpy(d{}, s{}, {});\n", comps_offset, bytes_offset, leaf.rows * 4);
+            } else {
+                l("memcpy(d{}, s{}, {});\n", bytes_offset, comps_offset, leaf.rows * 4);
+            }
+            if (leaf.columns > 1) {
+                l_close("}}\n");
+            }
+            for (size_t dim_index = 0; dim_index < leaf.dims.size(); dim_index++) {
+                l_close("}}\n");
+            }
+            l_close("}}\n");
+        }
+        l_close("}}\n");
+    }
 }
 
 void SokolCGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    if (gen.args.split_backends) {
+        for (int i = 0; i < Slang::Num; i++) {
+            Slang::Enum slang = Slang::from_index(i);
+            if (gen.args.slang & Slang::bit(slang)) {
+                l("const sg_shader_desc* {}(void);\n", backend_shader_desc_func_name(prog, slang));
+            }
+        }
+    }
     l_open("{}const sg_shader_desc* {}{}_shader_desc(sg_backend backend) {{\n", func_prefix, mod_prefix, prog.name);
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
@@ -259,195 +578,207 @@ void SokolCGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
                 l("#if defined({})\n", sokol_define(slang));
             }
             l_open("if (backend == {}) {{\n", backend(slang));
-            l("static sg_shader_desc desc;\n");
-            l("static bool valid;\n");
-            l_open("if (!valid) {{\n");
-            l("valid = true;\n");
-            for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
-                const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
-                if (info.stage == ShaderStage::Invalid) {
-                    continue;
-                }
-                const StageReflection& refl = prog.stages[stage_index];
-                std::string dsn;
-                switch (info.stage) {
-                    case ShaderStage::Vertex: dsn = "desc.vertex_func"; break;
-                    case ShaderStage::Fragment: dsn = "desc.fragment_func"; break;
-                    case ShaderStage::Compute: dsn = "desc.compute_func"; break;
-                    default: dsn = "INVALID"; break;
+            if (gen.args.split_backends) {
+                // the shader desc and shader code live in the per-backend C file
+                l("return {}();\n", backend_shader_desc_func_name(prog, slang));
+            } else {
+                gen_shader_desc_body(gen, prog, slang);
+            }
+            l_close("}}\n");
+            if (gen.args.ifdef) {
+                l("#endif /* {} */\n", sokol_define(slang));
+            }
+        }
+    }
+    l("return 0;\n");
+    l_close("}}\n");
+    gen_shader_hash_func(gen, prog);
+}
+
+// the static shader desc of a program for one shader language, called by gen_shader_desc_func()
+// or by gen_backend_impl() with --split-backends
+void SokolCGenerator::gen_shader_desc_body(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    l("static sg_shader_desc desc;\n");
+    l("static bool valid;\n");
+    l_open("if (!valid) {{\n");
+    l("valid = true;\n");
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
+        if (info.stage == ShaderStage::Invalid) {
+            continue;
+        }
+        const StageReflection& refl = prog.stages[stage_index];
+        std::string dsn;
+        switch (info.stage) {
+            case ShaderStage::Vertex: dsn = "desc.vertex_func"; break;
+            case ShaderStage::Fragment: dsn = "desc.fragment_func"; break;
+            case ShaderStage::Compute: dsn = "desc.compute_func"; break;
+            default: dsn = "INVALID"; break;
+        }
+        if (info.has_bytecode) {
+            l("{}.bytecode.ptr = {};\n", dsn, info.bytecode_array_name);
+            l("{}.bytecode.size = {};\n", dsn, info.bytecode_array_size);
+        } else {
+            l("{}.source = (const char*){};\n", dsn, info.source_array_name);
+            const char* d3d11_tgt = hlsl_target(slang, info.stage);
+            if (d3d11_tgt) {
+                l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
+            }
+        }
+        l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
+    }
+    if (Slang::is_msl(slang) && prog.has_cs()) {
+        l("desc.mtl_threads_per_threadgroup.x = {};\n", prog.cs().cs_workgroup_size[0]);
+        l("desc.mtl_threads_per_threadgroup.y = {};\n", prog.cs().cs_workgroup_size[1]);
+        l("desc.mtl_threads_per_threadgroup.z = {};\n", prog.cs().cs_workgroup_size[2]);
+    }
+    if (prog.has_vs()) {
+        for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
+            const StageAttr& attr = prog.vs().inputs[attr_index];
+            if (attr.slot >= 0) {
+                l("desc.attrs[{}].base_type = {};\n", attr_index, attr_basetype(attr.type_info.basetype()));
+                if (Slang::is_glsl(slang)) {
+                    l("desc.attrs[{}].glsl_name = \"{}\";\n", attr_index, attr.name);
+                } else if (Slang::is_hlsl(slang)) {
+                    l("desc.attrs[{}].hlsl_sem_name = \"{}\";\n", attr_index, attr.sem_name);
+                    l("desc.attrs[{}].hlsl_sem_index = {};\n", attr_index, attr.sem_index);
                 }
-                if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = {};\n", dsn, info.bytecode_array_name);
-                    l("{}.bytecode.size = {};\n", dsn, info.bytecode_array_size);
+            }
+        }
+    }
+    if (Slang::is_glsl(slang)) {
+        const auto module_name = gen.inp.module;
+        l("#if defined(NOBE_VULKAN)\n");
+        l("desc.spv_vs.ptr = {}_glsl_spv_vs;\n", module_name);
+        l("desc.spv_vs.size = sizeof({}_glsl_spv_vs);\n", module_name);
+        l("desc.spv_fs.ptr = {}_glsl_spv_fs;\n", module_name);
+        l("desc.spv_fs.size = sizeof({}_glsl_spv_fs);\n", module_name);
+        l("#endif\n");
+    }
+    for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
+        const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
+        if (ub) {
+            const std::string ubn = fmt::format("desc.uniform_blocks[{}]", ub_index);
+            l("{}.stage = {};\n", ubn, shader_stage(ub->stage));
+            l("{}.layout = SG_UNIFORMLAYOUT_STD140;\n", ubn);
+            l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
+            if (Slang::is_hlsl(slang)) {
+                l("{}.hlsl_register_b_n = {};\n", ubn, ub->hlsl_register_b_n);
+            } else if (Slang::is_msl(slang)) {
+                l("{}.msl_buffer_n = {};\n", ubn, ub->msl_buffer_n);
+            } else if (Slang::is_wgsl(slang)) {
+                l("{}.wgsl_group0_binding_n = {};\n", ubn, ub->wgsl_group0_binding_n);
+            } else if (Slang::is_spirv(slang)) {
+                l("{}.spirv_set0_binding_n = {};\n", ubn, ub->spirv_set0_binding_n);
+            } else if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                if (ub->flattened) {
+                    // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
+                    l("{}.glsl_uniforms[0].type = {};\n", ubn, flattened_uniform_type(ub->struct_info.struct_items[0].type));
+                    l("{}.glsl_uniforms[0].array_count = {};\n", ubn, roundup(ub->struct_info.size, 16) / 16);
+                    l("{}.glsl_uniforms[0].glsl_name = \"{}\";\n", ubn, ub->name);
                 } else {
-                    l("{}.source = (const char*){};\n", dsn, info.source_array_name);
-                    const char* d3d11_tgt = hlsl_target(slang, info.stage);
-                    if (d3d11_tgt) {
-                        l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
-                    }
-                }
-                l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
-            }
-            if (Slang::is_msl(slang) && prog.has_cs()) {
-                l("desc.mtl_threads_per_threadgroup.x = {};\n", prog.cs().cs_workgroup_size[0]);
-                l("desc.mtl_threads_per_threadgroup.y = {};\n", prog.cs().cs_workgroup_size[1]);
-                l("desc.mtl_threads_per_threadgroup.z = {};\n", prog.cs().cs_workgroup_size[2]);
-            }
-            if (prog.has_vs()) {
-                for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
-                    const StageAttr& attr = prog.vs().inputs[attr_index];
-                    if (attr.slot >= 0) {
-                        l("desc.attrs[{}].base_type = {};\n", attr_index, attr_basetype(attr.type_info.basetype()));
-                        if (Slang::is_glsl(slang)) {
-                            l("desc.attrs[{}].glsl_name = \"{}\";\n", attr_index, attr.name);
-                        } else if (Slang::is_hlsl(slang)) {
-                            l("desc.attrs[{}].hlsl_sem_name = \"{}\";\n", attr_index, attr.sem_name);
-                            l("desc.attrs[{}].hlsl_sem_index = {};\n", attr_index, attr.sem_index);
-                        }
+                    for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
+                        const Type& u = ub->struct_info.struct_items[u_index];
+                        const std::string un = fmt::format("{}.glsl_uniforms[{}]", ubn, u_index);
+                        l("{}.type = {};\n", un, uniform_type(u.type));
+                        l("{}.array_count = {};\n", un, u.array_count);
+                        l("{}.glsl_name = \"{}.{}\";\n", un, ub->inst_name, u.name);
                     }
                 }
             }
-            if (Slang::is_glsl(slang)) {
-                const auto module_name = gen.inp.module;
-                l("#if defined(NOBE_VULKAN)\n");
-                l("desc.spv_vs.ptr = {}_glsl_spv_vs;\n", module_name);
-                l("desc.spv_vs.size = sizeof({}_glsl_spv_vs);\n", module_name);
-                l("desc.spv_fs.ptr = {}_glsl_spv_fs;\n", module_name);
-                l("desc.spv_fs.size = sizeof({}_glsl_spv_fs);\n", module_name);
-                l("#endif\n");
-            }
-            for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
-                const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
-                if (ub) {
-                    const std::string ubn = fmt::format("desc.uniform_blocks[{}]", ub_index);
-                    l("{}.stage = {};\n", ubn, shader_stage(ub->stage));
-                    l("{}.layout = SG_UNIFORMLAYOUT_STD140;\n", ubn);
-                    l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_b_n = {};\n", ubn, ub->hlsl_register_b_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_buffer_n = {};\n", ubn, ub->msl_buffer_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group0_binding_n = {};\n", ubn, ub->wgsl_group0_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set0_binding_n = {};\n", ubn, ub->spirv_set0_binding_n);
-                    } else if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
-                        if (ub->flattened) {
-                            // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
-                            l("{}.glsl_uniforms[0].type = {};\n", ubn, flattened_uniform_type(ub->struct_info.struct_items[0].type));
-                            l("{}.glsl_uniforms[0].array_count = {};\n", ubn, roundup(ub->struct_info.size, 16) / 16);
-                            l("{}.glsl_uniforms[0].glsl_name = \"{}\";\n", ubn, ub->name);
-                        } else {
-                            for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
-                                const Type& u = ub->struct_info.struct_items[u_index];
-                                const std::string un = fmt::format("{}.glsl_uniforms[{}]", ubn, u_index);
-                                l("{}.type = {};\n", un, uniform_type(u.type));
-                                l("{}.array_count = {};\n", un, u.array_count);
-                                l("{}.glsl_name = \"{}.{}\";\n", un, ub->inst_name, u.name);
-                            }
-                        }
-                    }
-                }
+        }
+    }
+    for (int view_index = 0; view_index < MaxViews; view_index++) {
+        const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
+        if (view.type == BindSlot::Type::Texture) {
+            const Texture* tex = &view.texture;
+            const std::string& tn = fmt::format("desc.views[{}].texture", view_index);
+            l("{}.stage = {};\n", tn, shader_stage(tex->stage));
+            l("{}.image_type = {};\n", tn, image_type(tex->type));
+            l("{}.sample_type = {};\n", tn, image_sample_type(tex->sample_type));
+            l("{}.multisampled = {};\n", tn, tex->multisampled ? "true" : "false");
+            if (Slang::is_hlsl(slang)) {
+                l("{}.hlsl_register_t_n = {};\n", tn, tex->hlsl_register_t_n);
+            } else if (Slang::is_msl(slang)) {
+                l("{}.msl_texture_n = {};\n", tn, tex->msl_texture_n);
+            } else if (Slang::is_wgsl(slang)) {
+                l("{}.wgsl_group1_binding_n = {};\n", tn, tex->wgsl_group1_binding_n);
+            } else if (Slang::is_spirv(slang)) {
+                l("{}.spirv_set1_binding_n = {};\n", tn, tex->spirv_set1_binding_n);
             }
-            for (int view_index = 0; view_index < MaxViews; view_index++) {
-                const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
-                if (view.type == BindSlot::Type::Texture) {
-                    const Texture* tex = &view.texture;
-                    const std::string& tn = fmt::format("desc.views[{}].texture", view_index);
-                    l("{}.stage = {};\n", tn, shader_stage(tex->stage));
-                    l("{}.image_type = {};\n", tn, image_type(tex->type));
-                    l("{}.sample_type = {};\n", tn, image_sample_type(tex->sample_type));
-                    l("{}.multisampled = {};\n", tn, tex->multisampled ? "true" : "false");
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_t_n = {};\n", tn, tex->hlsl_register_t_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_texture_n = {};\n", tn, tex->msl_texture_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", tn, tex->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", tn, tex->spirv_set1_binding_n);
-                    }
-                } else if (view.type == BindSlot::Type::StorageBuffer) {
-                    const StorageBuffer* sbuf = &view.storage_buffer;
-                    const std::string& sbn = fmt::format("desc.views[{}].storage_buffer", view_index);
-                    l("{}.stage = {};\n", sbn, shader_stage(sbuf->stage));
-                    l("{}.readonly = {};\n", sbn, sbuf->readonly);
-                    if (Slang::is_hlsl(slang)) {
-                        if (sbuf->hlsl_register_t_n >= 0) {
-                            l("{}.hlsl_register_t_n = {};\n", sbn, sbuf->hlsl_register_t_n);
-                        }
-                        if (sbuf->hlsl_register_u_n >= 0) {
-                            l("{}.hlsl_register_u_n = {};\n", sbn, sbuf->hlsl_register_u_n);
-                        }
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_buffer_n = {};\n", sbn, sbuf->msl_buffer_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sbn, sbuf->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sbn, sbuf->spirv_set1_binding_n);
-                    } else if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_binding_n = {};\n", sbn, sbuf->glsl_binding_n);
-                    }
-                } else if (view.type == BindSlot::Type::StorageImage) {
-                    const StorageImage* simg = &view.storage_image;
-                    const std::string& sin = fmt::format("desc.views[{}].storage_image", view_index);
-                    l("{}.stage = {};\n", sin, shader_stage(simg->stage));
-                    l("{}.image_type = {};\n", sin, image_type(simg->type));
-                    l("{}.access_format = {};\n", sin, storage_pixel_format(simg->access_format));
-                    l("{}.writeonly = {};\n", sin, simg->writeonly);
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_u_n = {};\n", sin, simg->hlsl_register_u_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_texture_n = {};\n", sin, simg->msl_texture_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sin, simg->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sin, simg->spirv_set1_binding_n);
-                    } else if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_binding_n = {};\n", sin, simg->glsl_binding_n);
-                    }
+        } else if (view.type == BindSlot::Type::StorageBuffer) {
+            const StorageBuffer* sbuf = &view.storage_buffer;
+            const std::string& sbn = fmt::format("desc.views[{}].storage_buffer", view_index);
+            l("{}.stage = {};\n", sbn, shader_stage(sbuf->stage));
+            l("{}.readonly = {};\n", sbn, sbuf->readonly);
+            if (Slang::is_hlsl(slang)) {
+                if (sbuf->hlsl_register_t_n >= 0) {
+                    l("{}.hlsl_register_t_n = {};\n", sbn, sbuf->hlsl_register_t_n);
                 }
-            }
-            for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
-                const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
-                if (smp) {
-                    const std::string sn = fmt::format("desc.samplers[{}]", smp_index);
-                    l("{}.stage = {};\n", sn, shader_stage(smp->stage));
-                    l("{}.sampler_type = {};\n", sn, sampler_type(smp->type));
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_s_n = {};\n", sn, smp->hlsl_register_s_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_sampler_n = {};\n", sn, smp->msl_sampler_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sn, smp->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sn, smp->spirv_set1_binding_n);
-                    }
+                if (sbuf->hlsl_register_u_n >= 0) {
+                    l("{}.hlsl_register_u_n = {};\n", sbn, sbuf->hlsl_register_u_n);
                 }
+            } else if (Slang::is_msl(slang)) {
+                l("{}.msl_buffer_n = {};\n", sbn, sbuf->msl_buffer_n);
+            } else if (Slang::is_wgsl(slang)) {
+                l("{}.wgsl_group1_binding_n = {};\n", sbn, sbuf->wgsl_group1_binding_n);
+            } else if (Slang::is_spirv(slang)) {
+                l("{}.spirv_set1_binding_n = {};\n", sbn, sbuf->spirv_set1_binding_n);
+            } else if (Slang::is_glsl(slang)) {
+                l("{}.glsl_binding_n = {};\n", sbn, sbuf->glsl_binding_n);
             }
-            for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
-                const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
-                if (tex_smp) {
-                    const std::string tsn = fmt::format("desc.texture_sampler_pairs[{}]", tex_smp_index);
-                    l("{}.stage = {};\n", tsn, shader_stage(tex_smp->stage));
-                    l("{}.view_slot = {};\n", tsn, prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot);
-                    l("{}.sampler_slot = {};\n", tsn, prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot);
-                    if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_name = \"{}\";\n", tsn, tex_smp->name);
-                    }
-                }
+        } else if (view.type == BindSlot::Type::StorageImage) {
+            const StorageImage* simg = &view.storage_image;
+            const std::string& sin = fmt::format("desc.views[{}].storage_image", view_index);
+            l("{}.stage = {};\n", sin, shader_stage(simg->stage));
+            l("{}.image_type = {};\n", sin, image_type(simg->type));
+            l("{}.access_format = {};\n", sin, storage_pixel_format(simg->access_format));
+            l("{}.writeonly = {};\n", sin, simg->writeonly);
+            if (Slang::is_hlsl(slang)) {
+                l("{}.hlsl_register_u_n = {};\n", sin, simg->hlsl_register_u_n);
+            } else if (Slang::is_msl(slang)) {
+                l("{}.msl_texture_n = {};\n", sin, simg->msl_texture_n);
+            } else if (Slang::is_wgsl(slang)) {
+                l("{}.wgsl_group1_binding_n = {};\n", sin, simg->wgsl_group1_binding_n);
+            } else if (Slang::is_spirv(slang)) {
+                l("{}.spirv_set1_binding_n = {};\n", sin, simg->spirv_set1_binding_n);
+            } else if (Slang::is_glsl(slang)) {
+                l("{}.glsl_binding_n = {};\n", sin, simg->glsl_binding_n);
             }
-            l("desc.label = \"{}{}_shader\";\n", mod_prefix, prog.name);
-            l_close("}}\n");
-            l("return &desc;\n");
-            l_close("}}\n");
-            if (gen.args.ifdef) {
-                l("#endif /* {} */\n", sokol_define(slang));
+        }
+    }
+    for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
+        const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
+        if (smp) {
+            const std::string sn = fmt::format("desc.samplers[{}]", smp_index);
+            l("{}.stage = {};\n", sn, shader_stage(smp->stage));
+            l("{}.sampler_type = {};\n", sn, sampler_type(smp->type));
+            if (Slang::is_hlsl(slang)) {
+                l("{}.hlsl_register_s_n = {};\n", sn, smp->hlsl_register_s_n);
+            } else if (Slang::is_msl(slang)) {
+                l("{}.msl_sampler_n = {};\n", sn, smp->msl_sampler_n);
+            } else if (Slang::is_wgsl(slang)) {
+                l("{}.wgsl_group1_binding_n = {};\n", sn, smp->wgsl_group1_binding_n);
+            } else if (Slang::is_spirv(slang)) {
+                l("{}.spirv_set1_binding_n = {};\n", sn, smp->spirv_set1_binding_n);
             }
         }
     }
-    l("return 0;\n");
+    for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
+        const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
+        if (tex_smp) {
+            const std::string tsn = fmt::format("desc.texture_sampler_pairs[{}]", tex_smp_index);
+            l("{}.stage = {};\n", tsn, shader_stage(tex_smp->stage));
+            l("{}.view_slot = {};\n", tsn, prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot);
+            l("{}.sampler_slot = {};\n", tsn, prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot);
+            if (Slang::is_glsl(slang)) {
+                l("{}.glsl_name = \"{}\";\n", tsn, tex_smp->name);
+            }
+        }
+    }
+    l("desc.label = \"{}{}_shader\";\n", mod_prefix, prog.name);
     l_close("}}\n");
+    l("return &desc;\n");
 }
 
 void SokolCGenerator::gen_attr_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
@@ -520,6 +851,31 @@ void SokolCGenerator::gen_uniform_block_size_refl_func(const GenInput& gen, cons
     l_close("}}\n");
 }
 
+void SokolCGenerator::gen_uniform_block_used_range_refl_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}int {}{}_uniformblock_used_offset(const char* ub_name) {{\n", func_prefix, mod_prefix, prog.name);
+    l("(void)ub_name;\n");
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
+            l("return {};\n", ub.used_offset);
+            l_close("}}\n");
+        }
+    }
+    l("return -1;\n");
+    l_close("}}\n");
+    l_open("{}size_t {}{}_uniformblock_used_size(const char* ub_name) {{\n", func_prefix, mod_prefix, prog.name);
+    l("(void)ub_name;\n");
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
+            l("return {};\n", ub.used_size);
+            l_close("}}\n");
+        }
+    }
+    l("return 0;\n");
+    l_close("}}\n");
+}
+
 void SokolCGenerator::gen_storage_buffer_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_storagebuffer_slot(const char* sbuf_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)sbuf_name;\n");
@@ -566,6 +922,24 @@ void SokolCGenerator::gen_uniform_offset_refl_func(const GenInput& gen, const Pr
     l_close("}}\n");
 }
 
+void SokolCGenerator::gen_uniform_used_refl_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}bool {}{}_uniform_used(const char* ub_name, const char* u_name) {{\n", func_prefix, mod_prefix, prog.name);
+    l("(void)ub_name; (void)u_name;\n");
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
+            for (const Type& u: ub.struct_info.struct_items) {
+                l_open("if (0 == strcmp(u_name, \"{}\")) {{\n", u.name);
+                l("return {};\n", u.used);
+                l_close("}}\n");
+            }
+            l_close("}}\n");
+        }
+    }
+    l("return false;\n");
+    l_close("}}\n");
+}
+
 void SokolCGenerator::gen_uniform_desc_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}sg_glsl_shader_uniform {}{}_uniform_desc(const char* ub_name, const char* u_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)ub_name; (void)u_name;\n");
@@ -606,6 +980,85 @@ void SokolCGenerator::gen_shader_array_end(const GenInput& gen) {
     }
 }
 
+/* --embed-files: the array content is written to a binary file, with SOKOL_SHDC_INCBIN
+    defined the array is defined in the generated assembler stub, otherwise it is
+    included with C23 #embed if the compiler supports it, with hex initializers as fallback
+*/
+void SokolCGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    if (!gen.args.embed_files) {
+        Generator::gen_shader_array(gen, array_name, bytes, num_bytes, slang);
+        return;
+    }
+    const std::string path = add_blob_file(array_name, bytes, num_bytes, slang);
+    if (gen.args.ifdef) {
+        l("#if defined({})\n", sokol_define(slang));
+    }
+    l("#if defined(SOKOL_SHDC_INCBIN)\n");
+    l("SOKOL_SHDC_EXTERN const uint8_t {}[{}];\n", array_name, num_bytes);
+    l("#else\n");
+    l("static const uint8_t {}[{}] = {{\n", array_name, num_bytes);
+    l("#if defined(__has_embed)\n");
+    l("#embed \"{}\"\n", pystring::os::path::basename(path));
+    l("#else\n");
+    gen_shader_array_bytes(bytes, num_bytes);
+    l("\n#endif\n");
+    l("}};\n");
+    l("#endif\n");
+    if (gen.args.ifdef) {
+        l("#endif\n");
+    }
+}
+
+// --embed-files: also write an assembler stub which defines all arrays with .incbin
+ErrMsg SokolCGenerator::write_blob_files(const GenInput& gen) {
+    if (blob_files.empty()) {
+        return ErrMsg();
+    }
+    content.clear();
+    cbl_start();
+    cbl("#version:{}# (machine generated, don't edit!)\n", gen.args.gen_version);
+    cbl("\n");
+    cbl("Generated by sokol-shdc (https://github.com/floooh/sokol-tools)\n");
+    cbl("\n");
+    cbl("Defines the shader arrays of '{}' with .incbin, add this file to the\n", pystring::os::path::basename(gen.args.output));
+    cbl("build and define SOKOL_SHDC_INCBIN for all code which includes the header.\n");
+    cbl("The binary files are referenced by file name, the directory of this file\n");
+    cbl("must be in the assembler's include path (e.g. -Wa,-I[dir] with GCC).\n");
+    cbl_end();
+    l("#if defined(__APPLE__) || (defined(_WIN32) && !defined(_WIN64))\n");
+    l("#define SOKOL_SHDC_SYMBOL(name) _##name\n");
+    l("#else\n");
+    l("#define SOKOL_SHDC_SYMBOL(name) name\n");
+    l("#endif\n");
+    l("#if defined(__APPLE__)\n");
+    l("    .const_data\n");
+    l("#elif defined(_WIN32)\n");
+    l("    .section .rdata,\"dr\"\n");
+    l("#else\n");
+    l("    .section .rodata\n");
+    l("#endif\n");
+    for (const BlobFile& blob_file: blob_files) {
+        if (gen.args.ifdef) {
+            l("#if defined({})\n", sokol_define(blob_file.slang));
+        }
+        l("    .globl SOKOL_SHDC_SYMBOL({})\n", blob_file.array_name);
+        l("    .balign 16\n");
+        l("SOKOL_SHDC_SYMBOL({}):\n", blob_file.array_name);
+        l("    .incbin \"{}\"\n", pystring::os::path::basename(blob_file.path));
+        if (gen.args.ifdef) {
+            l("#endif\n");
+        }
+    }
+    l("#if defined(__ELF__)\n");
+    l("    .section .note.GNU-stack,\"\",%progbits\n");
+    l("#endif\n");
+    BlobFile stub;
+    stub.path = fmt::format("{}_blobs.S", blob_path_root);
+    stub.data.assign(content.begin(), content.end());
+    blob_files.push_back(stub);
+    return Generator::write_blob_files(gen);
+}
+
 void SokolCGenerator::gen_stb_impl_start(const GenInput &gen) {
     if (gen.args.output_format == Format::SOKOL_IMPL) {
         l("#if defined(SOKOL_SHDC_IMPL)\n");
@@ -618,6 +1071,84 @@ void SokolCGenerator::gen_stb_impl_end(const GenInput& gen) {
     }
 }
 
+void SokolCGenerator::gen_shader_arrays(const GenInput& gen) {
+    // with --split-backends, the shader code is written to the per-backend C files
+    if (!gen.args.split_backends) {
+        Generator::gen_shader_arrays(gen);
+    }
+}
+
+ErrMsg SokolCGenerator::end(const GenInput& gen) {
+    ErrMsg err = Generator::end(gen);
+    if (err.valid() || !gen.args.split_backends) {
+        return err;
+    }
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            err = gen_backend_impl(gen, slang);
+            if (err.valid()) {
+                return err;
+            }
+        }
+    }
+    return err;
+}
+
+/* --split-backends: write the shader code and the shader descs of all programs for
+    one shader language into a C file, the whole file is wrapped in the backend's
+    SOKOL_* define with --ifdef, so that a build only parses the active backend's code
+*/
+ErrMsg SokolCGenerator::gen_backend_impl(const GenInput& gen, Slang::Enum slang) {
+    Args impl_args = gen.args;
+    impl_args.output = util::backend_impl_path(gen.args.output, slang);
+    impl_args.ifdef = false;
+    const GenInput impl_gen(impl_args, gen.inp, gen.spirvcross, gen.bytecode, gen.refl, gen.spv_vs, gen.spv_fs);
+    content.clear();
+    cbl_start();
+    cbl("#version:{}# (machine generated, don't edit!)\n", gen.args.gen_version);
+    cbl("\n");
+    cbl("Generated by sokol-shdc (https://github.com/floooh/sokol-tools)\n");
+    cbl("\n");
+    cbl("Shader code and shader descs for '{}', written with --split-backends.\n", Slang::to_str(slang));
+    cbl_end();
+    if (gen.args.ifdef) {
+        l("#if defined({})\n", sokol_define(slang));
+    }
+    l("#include \"{}\"\n", pystring::os::path::basename(gen.args.output));
+    gen_shader_arrays_for_slang(impl_gen, slang);
+    if (Slang::is_glsl(slang) && !gen.spv_vs.empty() && !gen.spv_fs.empty()) {
+        gen_glsl_spv_arrays(impl_gen);
+    }
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        l_open("const sg_shader_desc* {}(void) {{\n", backend_shader_desc_func_name(prog, slang));
+        gen_shader_desc_body(impl_gen, prog, slang);
+        l_close("}}\n");
+    }
+    if (gen.args.ifdef) {
+        l("#endif /* {} */\n", sokol_define(slang));
+    }
+    return Generator::end(impl_gen);
+}
+
+std::string SokolCGenerator::backend_shader_desc_func_name(const ProgramReflection& prog, Slang::Enum slang) {
+    return fmt::format("{}{}_shader_desc_{}", mod_prefix, prog.name, Slang::to_str(slang));
+}
+
+void SokolCGenerator::gen_split_index(const GenInput& gen, const std::vector<std::string>& paths) {
+    l("#pragma once\n");
+    cbl_start();
+    cbl("#version:{}# (machine generated, don't edit!)\n", gen.args.gen_version);
+    cbl("\n");
+    cbl("Generated by sokol-shdc (https://github.com/floooh/sokol-tools)\n");
+    cbl("\n");
+    cbl("Includes the common header and the per-program headers written with --split-output.\n");
+    cbl_end();
+    for (const std::string& path: paths) {
+        l("#include \"{}\"\n", pystring::os::path::basename(path));
+    }
+}
+
 std::string SokolCGenerator::lang_name() {
     return "C";
 }
@@ -784,6 +1315,10 @@ std::string SokolCGenerator::vertex_attr_name(const std::string& prog_name, cons
     return fmt::format("ATTR_{}{}_{}", mod_prefix, prog_name, attr.name);
 }
 
+std::string SokolCGenerator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("SPEC_{}{}_{}", mod_prefix, prog_name, sc.name);
+}
+
 std::string SokolCGenerator::texture_bind_slot_name(const Texture& tex) {
     return fmt::format("VIEW_{}{}", mod_prefix, tex.name);
 }
@@ -808,6 +1343,10 @@ std::string SokolCGenerator::vertex_attr_definition(const std::string& prog_name
     return fmt::format("#define {} ({})", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolCGenerator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("#define {} ({})", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolCGenerator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("#define {} ({})", texture_bind_slot_name(tex), tex.sokol_slot);
 }
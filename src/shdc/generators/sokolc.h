@@ -4,26 +4,34 @@
 namespace shdc::gen {
 
 class SokolCGenerator: public Generator {
+protected:
     std::string mod_prefix;
     std::string func_prefix;
-protected:
     virtual ErrMsg begin(const GenInput& gen);
     virtual void gen_prolog(const GenInput& gen);
     virtual void gen_epilog(const GenInput& gen);
     virtual void gen_prerequisites(const GenInput& gen);
+    virtual void gen_bind_slot_consts(const GenInput& gen);
     virtual void gen_uniform_block_decl(const GenInput& gen, const refl::UniformBlock& ub);
     virtual void gen_storage_buffer_decl(const GenInput& gen, const refl::Type& struc);
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_end(const GenInput& gen);
+    virtual void gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang);
+    virtual ErrMsg write_blob_files(const GenInput& gen);
     virtual void gen_stb_impl_start(const GenInput& gen);
     virtual void gen_stb_impl_end(const GenInput& gen);
+    virtual void gen_shader_arrays(const GenInput& gen);
+    virtual ErrMsg end(const GenInput& gen);
+    virtual void gen_split_index(const GenInput& gen, const std::vector<std::string>& paths);
     virtual void gen_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_attr_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_texture_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_sampler_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& progm);
     virtual void gen_uniform_block_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_uniform_block_size_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
+    virtual void gen_uniform_block_used_range_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_uniform_offset_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
+    virtual void gen_uniform_used_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_uniform_desc_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_storage_buffer_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_storage_image_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
@@ -45,19 +53,32 @@ protected:
     virtual std::string backend(Slang::Enum e);
     virtual std::string struct_name(const std::string& name);
     virtual std::string vertex_attr_name(const std::string& prog_name, const refl::StageAttr& attr);
+    virtual std::string spec_constant_name(const std::string& prog_name, const refl::SpecConstant& sc);
     virtual std::string texture_bind_slot_name(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf);
     virtual std::string storage_image_bind_slot_name(const refl::StorageImage& simg);
     virtual std::string vertex_attr_definition(const std::string& prog_name, const refl::StageAttr& attr);
+    virtual std::string spec_constant_definition(const std::string& prog_name, const refl::SpecConstant& sc);
     virtual std::string texture_bind_slot_definition(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_definition(const refl::StorageBuffer& sbuf);
     virtual std::string storage_image_bind_slot_definition(const refl::StorageImage& simg);
 private:
+    void gen_common_prerequisites(const GenInput& gen);
     virtual void gen_struct_interior_decl_std430(const GenInput& gen, const refl::Type& struc, int pad_to_size);
+    void gen_shader_desc_body(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang);
+    ErrMsg gen_backend_impl(const GenInput& gen, Slang::Enum slang);
+    std::string backend_shader_desc_func_name(const refl::ProgramReflection& prog, Slang::Enum slang);
+    void gen_shader_hash_func(const GenInput& gen, const refl::ProgramReflection& prog);
+    std::string shader_hash_name(const refl::ProgramReflection& prog, Slang::Enum slang);
+    std::string shader_hash_definition(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang);
+    void gen_cpp_uniform_helpers(const GenInput& gen);
+    void gen_cpp_uniform_block_decl(const GenInput& gen, const refl::UniformBlock& ub);
+    std::string cpp_uniform_type(const GenInput& gen, const refl::Type& uniform);
+    void gen_storage_buffer_packers(const GenInput& gen, const refl::Type& struc);
 };
 
 } // namespace
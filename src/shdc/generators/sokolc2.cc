@@ -547,6 +547,10 @@ std::string SokolC2Generator::vertex_attr_name(const std::string& prog_name, con
     return pystring::upper(fmt::format("ATTR_{}_{}", prog_name, attr.name));
 }
 
+std::string SokolC2Generator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return pystring::upper(fmt::format("SPEC_{}_{}", prog_name, sc.name));
+}
+
 std::string SokolC2Generator::texture_bind_slot_name(const Texture& tex) {
     return pystring::upper(fmt::format("VIEW_{}", tex.name));
 }
@@ -571,6 +575,10 @@ std::string SokolC2Generator::vertex_attr_definition(const std::string& prog_nam
     return fmt::format("const i32 {} = {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolC2Generator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("const i32 {} = {};", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolC2Generator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("const i32 {} = {};", texture_bind_slot_name(tex), tex.sokol_slot);
 }
@@ -31,12 +31,14 @@ protected:
     virtual std::string backend(Slang::Enum e);
     virtual std::string struct_name(const std::string& name);
     virtual std::string vertex_attr_name(const std::string& prog_name, const refl::StageAttr& attr);
+    virtual std::string spec_constant_name(const std::string& prog_name, const refl::SpecConstant& sc);
     virtual std::string texture_bind_slot_name(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf);
     virtual std::string storage_image_bind_slot_name(const refl::StorageImage& simg);
     virtual std::string vertex_attr_definition(const std::string& prog_name, const refl::StageAttr& attr);
+    virtual std::string spec_constant_definition(const std::string& prog_name, const refl::SpecConstant& sc);
     virtual std::string texture_bind_slot_definition(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub);
@@ -555,6 +555,10 @@ std::string SokolC3Generator::vertex_attr_name(const std::string& prog_name, con
     return pystring::upper(fmt::format("ATTR_{}_{}", prog_name, attr.name));
 }
 
+std::string SokolC3Generator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return pystring::upper(fmt::format("SPEC_{}_{}", prog_name, sc.name));
+}
+
 std::string SokolC3Generator::texture_bind_slot_name(const Texture& tex) {
     return pystring::upper(fmt::format("VIEW_{}", tex.name));
 }
@@ -579,6 +583,10 @@ std::string SokolC3Generator::vertex_attr_definition(const std::string& prog_nam
     return fmt::format("const int {} = {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolC3Generator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("const int {} = {};", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolC3Generator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("const int {} = {};", texture_bind_slot_name(tex), tex.sokol_slot);
 }
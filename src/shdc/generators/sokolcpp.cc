@@ -0,0 +1,156 @@
+/*
+    Generate output header in C++20 for sokol_gfx.h, this is the sokol C
+    output plus constexpr reflection data for compile-time bind slot
+    lookup and layout validation.
+*/
+#include "sokolcpp.h"
+#include "fmt/format.h"
+
+namespace shdc::gen {
+
+using namespace refl;
+
+void SokolCppGenerator::gen_prolog(const GenInput& gen) {
+    SokolCGenerator::gen_prolog(gen);
+    l("#if !defined(__cplusplus) || ((__cplusplus < 202002L) && !(defined(_MSVC_LANG) && (_MSVC_LANG >= 202002L)))\n");
+    l("#error \"sokol-shdc: the sokol_cpp output format requires C++20\"\n");
+    l("#endif\n");
+}
+
+void SokolCppGenerator::gen_prerequisites(const GenInput& gen) {
+    SokolCGenerator::gen_prerequisites(gen);
+    if (part == Part::Program) {
+        return;
+    }
+    l("#if !defined(SOKOL_SHDC_CPP_REFL_INCLUDED)\n");
+    l("#define SOKOL_SHDC_CPP_REFL_INCLUDED\n");
+    l("#include <array>\n");
+    l("#include <cstddef>\n");
+    l("#include <span>\n");
+    l("#include <string_view>\n");
+    l_open("namespace sokol_shdc::refl {{\n");
+    l("struct attr {{ std::string_view name; int slot; sg_shader_attr_base_type base_type; std::string_view sem_name; int sem_index; }};\n");
+    l("struct uniform {{ std::string_view name; sg_uniform_type type; int array_count; int offset; bool used; }};\n");
+    l("struct uniform_block {{ std::string_view name; int slot; sg_shader_stage stage; std::size_t size; int used_offset; std::size_t used_size; std::span<const uniform> uniforms; }};\n");
+    l("struct texture {{ std::string_view name; int slot; sg_shader_stage stage; sg_image_type image_type; sg_image_sample_type sample_type; bool multisampled; }};\n");
+    l("struct sampler {{ std::string_view name; int slot; sg_shader_stage stage; sg_sampler_type sampler_type; }};\n");
+    l("struct storage_buffer {{ std::string_view name; int slot; sg_shader_stage stage; bool readonly; }};\n");
+    l("struct storage_image {{ std::string_view name; int slot; sg_shader_stage stage; sg_image_type image_type; sg_pixel_format access_format; bool writeonly; }};\n");
+    l_open("template<typename T> constexpr const T* find(std::span<const T> items, std::string_view name) {{\n");
+    l_open("for (const T& item: items) {{\n");
+    l_open("if (item.name == name) {{\n");
+    l("return &item;\n");
+    l_close("}}\n");
+    l_close("}}\n");
+    l("return nullptr;\n");
+    l_close("}}\n");
+    l_open("template<typename T> constexpr int slot(std::span<const T> items, std::string_view name) {{\n");
+    l("const T* item = find(items, name);\n");
+    l("return item ? item->slot : -1;\n");
+    l_close("}}\n");
+    l_close("}} // namespace sokol_shdc::refl\n");
+    l("#endif\n");
+}
+
+void SokolCppGenerator::gen_epilog(const GenInput& gen) {
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        gen_constexpr_reflection(gen, prog);
+    }
+    SokolCGenerator::gen_epilog(gen);
+}
+
+void SokolCppGenerator::gen_array(const std::string& item_type, const std::string& name, const std::vector<std::string>& items) {
+    if (items.empty()) {
+        l("inline constexpr std::array<sokol_shdc::refl::{}, 0> {} = {{}};\n", item_type, name);
+        return;
+    }
+    l_open("inline constexpr std::array<sokol_shdc::refl::{}, {}> {} = {{{{\n", item_type, items.size(), name);
+    for (const std::string& item: items) {
+        l("{},\n", item);
+    }
+    l_close("}}}};\n");
+}
+
+void SokolCppGenerator::gen_constexpr_reflection(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("namespace {}{}_refl {{\n", mod_prefix, prog.name);
+
+    // vertex attributes
+    std::vector<std::string> items;
+    if (prog.has_vs()) {
+        for (const StageAttr& attr: prog.vs().inputs) {
+            if (attr.slot >= 0) {
+                items.push_back(fmt::format("{{ \"{}\", {}, {}, \"{}\", {} }}", attr.name, attr.slot, attr_basetype(attr.type_info.basetype()), attr.sem_name, attr.sem_index));
+            }
+        }
+    }
+    gen_array("attr", "attrs", items);
+
+    // uniform blocks and their members
+    std::vector<std::string> ub_items;
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        items.clear();
+        for (const Type& u: ub.struct_info.struct_items) {
+            items.push_back(fmt::format("{{ \"{}\", {}, {}, {}, {} }}", u.name, uniform_type(u.type), u.array_count, u.offset, u.used));
+        }
+        gen_array("uniform", fmt::format("{}_uniforms", ub.name), items);
+        ub_items.push_back(fmt::format("{{ \"{}\", {}, {}, sizeof({}), {}, {}, {}_uniforms }}", ub.name, ub.sokol_slot, shader_stage(ub.stage), struct_name(ub.name), ub.used_offset, ub.used_size, ub.name));
+    }
+    gen_array("uniform_block", "uniform_blocks", ub_items);
+
+    items.clear();
+    for (const Texture& tex: prog.bindings.textures) {
+        items.push_back(fmt::format("{{ \"{}\", {}, {}, {}, {}, {} }}", tex.name, tex.sokol_slot, shader_stage(tex.stage), image_type(tex.type), image_sample_type(tex.sample_type), tex.multisampled));
+    }
+    gen_array("texture", "textures", items);
+
+    items.clear();
+    for (const Sampler& smp: prog.bindings.samplers) {
+        items.push_back(fmt::format("{{ \"{}\", {}, {}, {} }}", smp.name, smp.sokol_slot, shader_stage(smp.stage), sampler_type(smp.type)));
+    }
+    gen_array("sampler", "samplers", items);
+
+    items.clear();
+    for (const StorageBuffer& sbuf: prog.bindings.storage_buffers) {
+        items.push_back(fmt::format("{{ \"{}\", {}, {}, {} }}", sbuf.name, sbuf.sokol_slot, shader_stage(sbuf.stage), sbuf.readonly));
+    }
+    gen_array("storage_buffer", "storage_buffers", items);
+
+    items.clear();
+    for (const StorageImage& simg: prog.bindings.storage_images) {
+        items.push_back(fmt::format("{{ \"{}\", {}, {}, {}, {}, {} }}", simg.name, simg.sokol_slot, shader_stage(simg.stage), image_type(simg.type), storage_pixel_format(simg.access_format), simg.writeonly));
+    }
+    gen_array("storage_image", "storage_images", items);
+
+    // name => slot lookup functions
+    l("constexpr int attr_slot(std::string_view name) {{ return sokol_shdc::refl::slot<sokol_shdc::refl::attr>(attrs, name); }}\n");
+    l("constexpr int texture_slot(std::string_view name) {{ return sokol_shdc::refl::slot<sokol_shdc::refl::texture>(textures, name); }}\n");
+    l("constexpr int sampler_slot(std::string_view name) {{ return sokol_shdc::refl::slot<sokol_shdc::refl::sampler>(samplers, name); }}\n");
+    l("constexpr int uniformblock_slot(std::string_view name) {{ return sokol_shdc::refl::slot<sokol_shdc::refl::uniform_block>(uniform_blocks, name); }}\n");
+    l("constexpr int storagebuffer_slot(std::string_view name) {{ return sokol_shdc::refl::slot<sokol_shdc::refl::storage_buffer>(storage_buffers, name); }}\n");
+    l("constexpr int storageimage_slot(std::string_view name) {{ return sokol_shdc::refl::slot<sokol_shdc::refl::storage_image>(storage_images, name); }}\n");
+    l_open("constexpr std::size_t uniformblock_size(std::string_view name) {{\n");
+    l("const sokol_shdc::refl::uniform_block* ub = sokol_shdc::refl::find<sokol_shdc::refl::uniform_block>(uniform_blocks, name);\n");
+    l("return ub ? ub->size : 0;\n");
+    l_close("}}\n");
+    l_open("constexpr int uniform_offset(std::string_view ub_name, std::string_view u_name) {{\n");
+    l("const sokol_shdc::refl::uniform_block* ub = sokol_shdc::refl::find<sokol_shdc::refl::uniform_block>(uniform_blocks, ub_name);\n");
+    l("const sokol_shdc::refl::uniform* u = ub ? sokol_shdc::refl::find<sokol_shdc::refl::uniform>(ub->uniforms, u_name) : nullptr;\n");
+    l("return u ? u->offset : -1;\n");
+    l_close("}}\n");
+    l_open("constexpr int uniformblock_used_offset(std::string_view name) {{\n");
+    l("const sokol_shdc::refl::uniform_block* ub = sokol_shdc::refl::find<sokol_shdc::refl::uniform_block>(uniform_blocks, name);\n");
+    l("return ub ? ub->used_offset : -1;\n");
+    l_close("}}\n");
+    l_open("constexpr std::size_t uniformblock_used_size(std::string_view name) {{\n");
+    l("const sokol_shdc::refl::uniform_block* ub = sokol_shdc::refl::find<sokol_shdc::refl::uniform_block>(uniform_blocks, name);\n");
+    l("return ub ? ub->used_size : 0;\n");
+    l_close("}}\n");
+    l_open("constexpr bool uniform_used(std::string_view ub_name, std::string_view u_name) {{\n");
+    l("const sokol_shdc::refl::uniform_block* ub = sokol_shdc::refl::find<sokol_shdc::refl::uniform_block>(uniform_blocks, ub_name);\n");
+    l("const sokol_shdc::refl::uniform* u = ub ? sokol_shdc::refl::find<sokol_shdc::refl::uniform>(ub->uniforms, u_name) : nullptr;\n");
+    l("return u ? u->used : false;\n");
+    l_close("}}\n");
+    l_close("}} // namespace {}{}_refl\n", mod_prefix, prog.name);
+}
+
+} // namespace
@@ -0,0 +1,17 @@
+#pragma once
+#include "sokolc.h"
+
+namespace shdc::gen {
+
+// C++20 variant of the sokol C header with additional constexpr reflection data
+class SokolCppGenerator: public SokolCGenerator {
+protected:
+    virtual void gen_prolog(const GenInput& gen);
+    virtual void gen_prerequisites(const GenInput& gen);
+    virtual void gen_epilog(const GenInput& gen);
+private:
+    void gen_constexpr_reflection(const GenInput& gen, const refl::ProgramReflection& prog);
+    void gen_array(const std::string& item_type, const std::string& name, const std::vector<std::string>& items);
+};
+
+} // namespace
@@ -201,6 +201,17 @@ void SokolDGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n];\n");
 }
 
+// --embed-files: reference the array content in a separate binary file
+void SokolDGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    if (!gen.args.embed_files) {
+        Generator::gen_shader_array(gen, array_name, bytes, num_bytes, slang);
+        return;
+    }
+    const std::string path = add_blob_file(array_name, bytes, num_bytes, slang);
+    // NOTE: string imports need the output directory in the import path (-J)
+    l("__gshared char[{}] {} = import(\"{}\");\n", num_bytes, array_name, pystring::os::path::basename(path));
+}
+
 void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("sg.ShaderDesc {}ShaderDesc(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
     l("sg.ShaderDesc desc;\n");
@@ -383,6 +394,22 @@ void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
     l_close("}}\n"); // close switch statement
     l("return desc;\n");
     l_close("}}\n"); // close function
+    gen_shader_hash_func(gen, prog);
+}
+
+// returns the stable content hash of a program for a backend, matching the shader desc returned by [prog]ShaderDesc()
+void SokolDGenerator::gen_shader_hash_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("ulong {}ShaderHash(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
+    l_open("switch (backend) {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("case {}: return 0x{:016X}UL;\n", backend(slang), program_hash(gen, prog, slang));
+        }
+    }
+    l("default: return 0;\n");
+    l_close("}}\n");
+    l_close("}}\n");
 }
 
 std::string SokolDGenerator::lang_name() {
@@ -551,6 +578,10 @@ std::string SokolDGenerator::vertex_attr_name(const std::string& prog_name, cons
     return pystring::upper(fmt::format("ATTR_{}_{}", prog_name, attr.name));
 }
 
+std::string SokolDGenerator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return pystring::upper(fmt::format("SPEC_{}_{}", prog_name, sc.name));
+}
+
 std::string SokolDGenerator::texture_bind_slot_name(const Texture& tex) {
     return pystring::upper(fmt::format("VIEW_{}", tex.name));
 }
@@ -579,6 +610,10 @@ std::string SokolDGenerator::vertex_attr_definition(const std::string& prog_name
     return const_def(vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolDGenerator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return const_def(spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolDGenerator::texture_bind_slot_definition(const Texture& tex) {
     return const_def(texture_bind_slot_name(tex), tex.sokol_slot);
 }
@@ -209,10 +209,10 @@ void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     default: dsn = "INVALID"; break;
                 }
                 if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = *{};\n", dsn, info.bytecode_array_name);
+                    l("{}.bytecode.ptr = {};\n", dsn, shader_array_ptr(gen, info.bytecode_array_name));
                     l("{}.bytecode.size = {};\n", dsn, info.bytecode_array_size);
                 } else {
-                    l("{}.source = xx *{};\n", dsn, info.source_array_name);
+                    l("{}.source = xx {};\n", dsn, shader_array_ptr(gen, info.source_array_name));
                     const char* d3d11_tgt = hlsl_target(slang, info.stage);
                     if (d3d11_tgt) {
                         l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
@@ -366,6 +366,24 @@ void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
     l("}}\n"); // close switch statement
     l("return desc;\n");
     l_close("}}\n"); // close function
+    gen_shader_hash_func(gen, prog);
+}
+
+// returns the stable content hash of a program for a backend, matching the shader desc returned by [prog]_shader_desc()
+void SokolJaiGenerator::gen_shader_hash_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}_shader_hash :: (backend: sg_backend) -> u64 {{\n", prog.name);
+    l("if backend == {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l_open("case {};\n", backend(slang));
+            l("return 0x{:016X};\n", program_hash(gen, prog, slang));
+            l_close();
+        }
+    }
+    l("}}\n");
+    l("return 0;\n");
+    l_close("}}\n");
 }
 
 void SokolJaiGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -376,6 +394,25 @@ void SokolJaiGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n];\n");
 }
 
+// --embed-files: reference the array content in a separate binary file
+void SokolJaiGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    if (!gen.args.embed_files) {
+        Generator::gen_shader_array(gen, array_name, bytes, num_bytes, slang);
+        return;
+    }
+    const std::string path = add_blob_file(array_name, bytes, num_bytes, slang);
+    // NOTE: the read_entire_file() result is a string, see shader_array_ptr()
+    l("{} :: #run read_entire_file(tprint(\"%1%2\", #filepath, \"{}\"));\n", array_name, pystring::os::path::basename(path));
+}
+
+// with --embed-files the shader arrays are strings returned by read_entire_file()
+std::string SokolJaiGenerator::shader_array_ptr(const GenInput& gen, const std::string& array_name) {
+    if (gen.args.embed_files) {
+        return fmt::format("{}.data", array_name);
+    }
+    return fmt::format("*{}", array_name);
+}
+
 std::string SokolJaiGenerator::lang_name() {
     return "Jai";
 }
@@ -542,6 +579,10 @@ std::string SokolJaiGenerator::vertex_attr_name(const std::string& prog_name, co
     return fmt::format("ATTR_{}_{}", prog_name, attr.name);
 }
 
+std::string SokolJaiGenerator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("SPEC_{}_{}", prog_name, sc.name);
+}
+
 std::string SokolJaiGenerator::texture_bind_slot_name(const Texture& tex) {
     return fmt::format("VIEW_{}", tex.name);
 }
@@ -566,6 +607,10 @@ std::string SokolJaiGenerator::vertex_attr_definition(const std::string& prog_na
     return fmt::format("{} :: {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolJaiGenerator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("{} :: {};", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolJaiGenerator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("{} :: {};", texture_bind_slot_name(tex), tex.sokol_slot);
 }
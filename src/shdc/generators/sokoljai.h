@@ -12,6 +12,7 @@ protected:
     virtual void gen_storage_buffer_decl(const GenInput& gen, const refl::Type& struc);
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_end(const GenInput& gen);
+    virtual void gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual std::string lang_name();
     virtual std::string comment_block_start();
@@ -31,19 +32,23 @@ protected:
     virtual std::string backend(Slang::Enum e);
     virtual std::string struct_name(const std::string& name);
     virtual std::string vertex_attr_name(const std::string& prog_name, const refl::StageAttr& attr);
+    virtual std::string spec_constant_name(const std::string& prog_name, const refl::SpecConstant& sc);
     virtual std::string texture_bind_slot_name(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf);
     virtual std::string storage_image_bind_slot_name(const refl::StorageImage& simg);
     virtual std::string vertex_attr_definition(const std::string& prog_name, const refl::StageAttr& attr);
+    virtual std::string spec_constant_definition(const std::string& prog_name, const refl::SpecConstant& sc);
     virtual std::string texture_bind_slot_definition(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub);
     virtual std::string storage_buffer_bind_slot_definition(const refl::StorageBuffer& sbuf);
     virtual std::string storage_image_bind_slot_definition(const refl::StorageImage& simg);
 private:
+    void gen_shader_hash_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_struct_interior_decl_std430(const GenInput& gen, const refl::Type& struc, int pad_to_size);
+    std::string shader_array_ptr(const GenInput& gen, const std::string& array_name);
 };
 
 } // namespace
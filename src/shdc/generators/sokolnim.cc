@@ -10,8 +10,7 @@ namespace shdc::gen {
 
 using namespace refl;
 
-// need to special-case the gen-shader-arrays function because Nim
-// needs the type appeneded to the first array element
+// Nim doesn't use the GLSL SPIRV arrays
 void SokolNimGenerator::gen_shader_arrays(const GenInput& gen) {
     for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
         Slang::Enum slang = Slang::from_index(slang_idx);
@@ -35,42 +34,10 @@ void SokolNimGenerator::gen_shader_arrays(const GenInput& gen) {
                 }
                 cbl_end();
                 if (blob) {
-                    const std::string array_name = shader_bytecode_array_name(snippet.name, slang);
-                    gen_shader_array_start(gen, array_name, blob->data.size(), slang);
-                    const size_t len = blob->data.size();
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        if (0 == i) {
-                            l("{:#04x}'u8,", blob->data[i]);
-                        } else {
-                            l("{:#04x},", blob->data[i]);
-                        }
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
+                    gen_shader_array(gen, shader_bytecode_array_name(snippet.name, slang), blob->data.data(), blob->data.size(), slang);
                 } else {
                     // if no bytecode exists, write the source code, but also a byte array with a trailing 0
-                    const std::string array_name = shader_source_array_name(snippet.name, slang);
-                    const size_t len = src->source_code.length() + 1;
-                    gen_shader_array_start(gen, array_name, len, slang);
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        if (0 == i) {
-                            l("{:#04x}'u8,", (int)src->source_code[i]);
-                        } else {
-                            l("{:#04x},", (int)src->source_code[i]);
-                        }
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
+                    gen_shader_array(gen, shader_source_array_name(snippet.name, slang), (const uint8_t*)src->source_code.c_str(), src->source_code.length() + 1, slang);
                 }
             }
         }
@@ -291,10 +258,18 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     default: dsn = "INVALID"; break;
                 }
                 if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = {}\n", dsn, info.bytecode_array_name);
+                    if (gen.args.embed_files) {
+                        l("{}.bytecode.ptr = cast[pointer]({}.cstring)\n", dsn, info.bytecode_array_name);
+                    } else {
+                        l("{}.bytecode.ptr = {}\n", dsn, info.bytecode_array_name);
+                    }
                     l("{}.bytecode.size = {}\n", dsn, info.bytecode_array_size);
                 } else {
-                    l("{}.source = cast[cstring](addr({}))\n", dsn, info.source_array_name);
+                    if (gen.args.embed_files) {
+                        l("{}.source = {}.cstring\n", dsn, info.source_array_name);
+                    } else {
+                        l("{}.source = cast[cstring](addr({}))\n", dsn, info.source_array_name);
+                    }
                     const char* d3d11_tgt = hlsl_target(slang, info.stage);
                     if (d3d11_tgt) {
                         l("{}.d3d11Target = \"{}\"\n", dsn, d3d11_tgt);
@@ -448,6 +423,24 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
     l("else: discard\n");
     l_close();
     l_close();
+    gen_shader_hash_func(gen, prog);
+}
+
+// returns the stable content hash of a program for a backend, matching the shader desc returned by [prog]ShaderDesc()
+void SokolNimGenerator::gen_shader_hash_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("proc {}ShaderHash*(backend: sg.Backend): uint64 =\n", to_camel_case(prog.name));
+    l_open("case backend:\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l_open("of {}:\n", backend(slang));
+            l("result = 0x{:016X}'u64\n", program_hash(gen, prog, slang));
+            l_close();
+        }
+    }
+    l("else: discard\n");
+    l_close();
+    l_close();
 }
 
 void SokolNimGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -458,6 +451,32 @@ void SokolNimGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n]\n");
 }
 
+// need to special-case the shader array function because Nim
+// needs the type appended to the first array element
+void SokolNimGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    if (gen.args.embed_files) {
+        // --embed-files: the staticRead() string is used directly, see gen_shader_desc_func()
+        const std::string path = add_blob_file(array_name, bytes, num_bytes, slang);
+        l("const {} = staticRead(\"{}\")\n", array_name, pystring::os::path::basename(path));
+        return;
+    }
+    gen_shader_array_start(gen, array_name, num_bytes, slang);
+    for (size_t i = 0; i < num_bytes; i++) {
+        if ((i & 15) == 0) {
+            l("    ");
+        }
+        if (0 == i) {
+            l("{:#04x}'u8,", bytes[i]);
+        } else {
+            l("{:#04x},", bytes[i]);
+        }
+        if ((i & 15) == 15) {
+            l("\n");
+        }
+    }
+    gen_shader_array_end(gen);
+}
+
 std::string SokolNimGenerator::lang_name() {
     return "Nim";
 }
@@ -624,6 +643,10 @@ std::string SokolNimGenerator::vertex_attr_name(const std::string& prog_name, co
     return to_camel_case(fmt::format("ATTR_{}_{}", prog_name, attr.name));
 }
 
+std::string SokolNimGenerator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return to_camel_case(fmt::format("SPEC_{}_{}", prog_name, sc.name));
+}
+
 std::string SokolNimGenerator::texture_bind_slot_name(const Texture& tex) {
     return to_camel_case(fmt::format("VIEW_{}", tex.name));
 }
@@ -648,6 +671,10 @@ std::string SokolNimGenerator::vertex_attr_definition(const std::string& prog_na
     return fmt::format("const {}* = {}", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolNimGenerator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("const {}* = {}", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolNimGenerator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("const {}* = {}", texture_bind_slot_name(tex), tex.sokol_slot);
 }
@@ -218,10 +218,10 @@ void SokolOdinGenerator::gen_shader_desc_func(const GenInput& gen, const Program
                     default: dsn = "INVALID";
                 }
                 if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = &{}\n", dsn, info.bytecode_array_name);
+                    l("{}.bytecode.ptr = {}\n", dsn, shader_array_ptr(gen, info.bytecode_array_name));
                     l("{}.bytecode.size = {}\n", dsn, info.bytecode_array_size);
                 } else {
-                    l("{}.source = transmute(cstring)&{}\n", dsn, info.source_array_name);
+                    l("{}.source = transmute(cstring){}\n", dsn, shader_array_ptr(gen, info.source_array_name));
                     const char* d3d11_tgt = hlsl_target(slang, info.stage);
                     if (d3d11_tgt) {
                         l("{}.d3d11_target = \"{}\"\n", dsn, d3d11_tgt);
@@ -375,6 +375,24 @@ void SokolOdinGenerator::gen_shader_desc_func(const GenInput& gen, const Program
     l("}}\n"); // close switch statement
     l("return desc\n");
     l_close("}}\n"); // close function
+    gen_shader_hash_func(gen, prog);
+}
+
+// returns the stable content hash of a program for a backend, matching the shader desc returned by [prog]_shader_desc()
+void SokolOdinGenerator::gen_shader_hash_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}_shader_hash :: proc (backend: sg.Backend) -> u64 {{\n", prog.name);
+    l("#partial switch backend {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l_open("case {}:\n", backend(slang));
+            l("return 0x{:016X}\n", program_hash(gen, prog, slang));
+            l_close();
+        }
+    }
+    l("}}\n");
+    l("return 0\n");
+    l_close("}}\n");
 }
 
 void SokolOdinGenerator::gen_attr_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
@@ -442,6 +460,29 @@ void SokolOdinGenerator::gen_uniform_block_size_refl_func(const GenInput& gen, c
     l_close("}}\n");
 }
 
+void SokolOdinGenerator::gen_uniform_block_used_range_refl_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}{}_uniformblock_used_offset :: proc (ub_name: string) -> int {{\n", mod_prefix, prog.name);
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if ub_name == \"{}\" {{\n", ub.name);
+            l("return {}\n", ub.used_offset);
+            l_close("}}\n");
+        }
+    }
+    l("return -1\n");
+    l_close("}}\n");
+    l_open("{}{}_uniformblock_used_size :: proc (ub_name: string) -> int {{\n", mod_prefix, prog.name);
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if ub_name == \"{}\" {{\n", ub.name);
+            l("return {}\n", ub.used_size);
+            l_close("}}\n");
+        }
+    }
+    l("return 0\n");
+    l_close("}}\n");
+}
+
 void SokolOdinGenerator::gen_storage_buffer_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}{}_storagebuffer_slot :: proc (sbuf_name: string) -> int {{\n", mod_prefix, prog.name);
     for (const StorageBuffer& sbuf: prog.bindings.storage_buffers) {
@@ -485,6 +526,23 @@ void SokolOdinGenerator::gen_uniform_offset_refl_func(const GenInput& gen, const
     l_close("}}\n");
 }
 
+void SokolOdinGenerator::gen_uniform_used_refl_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("{}{}_uniform_used :: proc (ub_name, u_name: string) -> bool {{\n", mod_prefix, prog.name);
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if ub_name == \"{}\" {{\n", ub.name);
+            for (const Type& u: ub.struct_info.struct_items) {
+                l_open("if u_name == \"{}\" {{\n", u.name);
+                l("return {}\n", u.used);
+                l_close("}}\n");
+            }
+            l_close("}}\n");
+        }
+    }
+    l("return false\n");
+    l_close("}}\n");
+}
+
 void SokolOdinGenerator::gen_uniform_desc_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}{}_uniform_desc :: proc (ub_name, u_name: string) -> sg.Glsl_Shader_Uniform {{\n", mod_prefix, prog.name);
     l("res := sg.Glsl_Shader_Uniform {{}}\n");
@@ -514,6 +572,25 @@ void SokolOdinGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n}}\n");
 }
 
+// --embed-files: reference the array content in a separate binary file
+void SokolOdinGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    if (!gen.args.embed_files) {
+        Generator::gen_shader_array(gen, array_name, bytes, num_bytes, slang);
+        return;
+    }
+    const std::string path = add_blob_file(array_name, bytes, num_bytes, slang);
+    // NOTE: #load() returns a slice, see shader_array_ptr()
+    l("@(private=\"file\")\n{} := #load(\"{}\")\n", array_name, pystring::os::path::basename(path));
+}
+
+// with --embed-files the shader arrays are slices returned by #load()
+std::string SokolOdinGenerator::shader_array_ptr(const GenInput& gen, const std::string& array_name) {
+    if (gen.args.embed_files) {
+        return fmt::format("raw_data({})", array_name);
+    }
+    return fmt::format("&{}", array_name);
+}
+
 std::string SokolOdinGenerator::lang_name() {
     return "Odin";
 }
@@ -681,6 +758,10 @@ std::string SokolOdinGenerator::vertex_attr_name(const std::string& prog_name, c
     return fmt::format("ATTR_{}{}_{}", mod_prefix, prog_name, attr.name);
 }
 
+std::string SokolOdinGenerator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("SPEC_{}{}_{}", mod_prefix, prog_name, sc.name);
+}
+
 std::string SokolOdinGenerator::texture_bind_slot_name(const Texture& tex) {
     return fmt::format("VIEW_{}{}", mod_prefix, tex.name);
 }
@@ -705,6 +786,10 @@ std::string SokolOdinGenerator::vertex_attr_definition(const std::string& prog_n
     return fmt::format("{} :: {}", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolOdinGenerator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("{} :: {}", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolOdinGenerator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("{} :: {}", texture_bind_slot_name(tex), tex.sokol_slot);
 }
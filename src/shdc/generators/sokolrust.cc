@@ -382,6 +382,22 @@ void SokolRustGenerator::gen_shader_desc_func(const GenInput& gen, const Program
     l_close("}}\n"); // close switch statement
     l("desc\n");
     l_close("}}\n"); // close function
+    gen_shader_hash_func(gen, prog);
+}
+
+// returns the stable content hash of a program for a backend, matching the shader desc returned by [prog]_shader_desc()
+void SokolRustGenerator::gen_shader_hash_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("pub fn {}_shader_hash(backend: sg::Backend) -> u64 {{\n", prog.name);
+    l_open("match backend {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("{} => 0x{:016X},\n", backend(slang), program_hash(gen, prog, slang));
+        }
+    }
+    l("_ => 0,\n");
+    l_close("}}\n");
+    l_close("}}\n");
 }
 
 void SokolRustGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -392,6 +408,16 @@ void SokolRustGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n];\n");
 }
 
+// --embed-files: reference the array content in a separate binary file
+void SokolRustGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    if (!gen.args.embed_files) {
+        Generator::gen_shader_array(gen, array_name, bytes, num_bytes, slang);
+        return;
+    }
+    const std::string path = add_blob_file(array_name, bytes, num_bytes, slang);
+    l("pub const {}: [u8; {}] = *include_bytes!(\"{}\");\n", array_name, num_bytes, pystring::os::path::basename(path));
+}
+
 std::string SokolRustGenerator::lang_name() {
     return "Rust";
 }
@@ -558,6 +584,10 @@ std::string SokolRustGenerator::vertex_attr_name(const std::string& prog_name, c
     return pystring::upper(fmt::format("ATTR_{}_{}", prog_name, attr.name));
 }
 
+std::string SokolRustGenerator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return pystring::upper(fmt::format("SPEC_{}_{}", prog_name, sc.name));
+}
+
 std::string SokolRustGenerator::texture_bind_slot_name(const Texture& tex) {
     return pystring::upper(fmt::format("VIEW_{}", tex.name));
 }
@@ -582,6 +612,10 @@ std::string SokolRustGenerator::vertex_attr_definition(const std::string& prog_n
     return fmt::format("pub const {}: usize = {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolRustGenerator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("pub const {}: u32 = {};", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolRustGenerator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("pub const {}: usize = {};", texture_bind_slot_name(tex), tex.sokol_slot);
 }
@@ -380,6 +380,22 @@ void SokolZigGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
     l_close("}}\n"); // close switch statement
     l("return desc;\n");
     l_close("}}\n"); // close function
+    gen_shader_hash_func(gen, prog);
+}
+
+// returns the stable content hash of a program for a backend, matching the shader desc returned by [prog]ShaderDesc()
+void SokolZigGenerator::gen_shader_hash_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("pub fn {}ShaderHash(backend: sg.Backend) u64 {{\n", to_camel_case(prog.name));
+    l_open("return switch (backend) {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("{} => 0x{:016X},\n", backend(slang), program_hash(gen, prog, slang));
+        }
+    }
+    l("else => 0,\n");
+    l_close("}};\n");
+    l_close("}}\n");
 }
 
 void SokolZigGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -390,6 +406,17 @@ void SokolZigGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n}};\n");
 }
 
+// --embed-files: reference the array content in a separate binary file
+void SokolZigGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const uint8_t* bytes, size_t num_bytes, Slang::Enum slang) {
+    if (!gen.args.embed_files) {
+        Generator::gen_shader_array(gen, array_name, bytes, num_bytes, slang);
+        return;
+    }
+    const std::string path = add_blob_file(array_name, bytes, num_bytes, slang);
+    // @embedFile() returns a pointer to a sentinel-terminated array, dereference to get an array value like the hex initializer
+    l("const {} = @embedFile(\"{}\").*;\n", array_name, pystring::os::path::basename(path));
+}
+
 std::string SokolZigGenerator::lang_name() {
     return "Zig";
 }
@@ -556,6 +583,10 @@ std::string SokolZigGenerator::vertex_attr_name(const std::string& prog_name, co
     return fmt::format("ATTR_{}_{}", prog_name, attr.name);
 }
 
+std::string SokolZigGenerator::spec_constant_name(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("SPEC_{}_{}", prog_name, sc.name);
+}
+
 std::string SokolZigGenerator::texture_bind_slot_name(const Texture& tex) {
     return fmt::format("VIEW_{}", tex.name);
 }
@@ -580,6 +611,10 @@ std::string SokolZigGenerator::vertex_attr_definition(const std::string& prog_na
     return fmt::format("pub const {} = {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
 
+std::string SokolZigGenerator::spec_constant_definition(const std::string& prog_name, const SpecConstant& sc) {
+    return fmt::format("pub const {} = {};", spec_constant_name(prog_name, sc), sc.constant_id);
+}
+
 std::string SokolZigGenerator::texture_bind_slot_definition(const Texture& tex) {
     return fmt::format("pub const {} = {};", texture_bind_slot_name(tex), tex.sokol_slot);
 }
@@ -688,6 +723,37 @@ void SokolZigGenerator::gen_uniform_block_size_refl_func(const GenInput& gen, co
     l_close("}}\n");
 }
 
+void SokolZigGenerator::gen_uniform_block_used_range_refl_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("pub fn {}UniformBlockUsedOffset(ub_name: []const u8) ?usize {{\n", to_camel_case(prog.name));
+    bool wrote_ub_name = false;
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if (std.mem.eql(u8, ub_name, \"{}\")) {{\n", ub.name);
+            l("return {};\n", ub.used_offset);
+            l_close("}}\n");
+            wrote_ub_name = true;
+        }
+    }
+    if (!wrote_ub_name) {
+        l("_ = ub_name;\n");
+    }
+    l("return null;\n");
+    l_close("}}\n");
+    l_open("pub fn {}UniformBlockUsedSize(ub_name: []const u8) ?usize {{\n", to_camel_case(prog.name));
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if (std.mem.eql(u8, ub_name, \"{}\")) {{\n", ub.name);
+            l("return {};\n", ub.used_size);
+            l_close("}}\n");
+        }
+    }
+    if (!wrote_ub_name) {
+        l("_ = ub_name;\n");
+    }
+    l("return null;\n");
+    l_close("}}\n");
+}
+
 void SokolZigGenerator::gen_storage_buffer_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("pub fn {}StorageBufferSlot(sbuf_name: []const u8) ?usize {{\n", to_camel_case(prog.name));
     bool wrote_sbuf_name = false;
@@ -751,6 +817,33 @@ void SokolZigGenerator::gen_uniform_offset_refl_func(const GenInput& gen, const
     l_close("}}\n");
 }
 
+void SokolZigGenerator::gen_uniform_used_refl_func(const GenInput& gen, const ProgramReflection& prog) {
+    l_open("pub fn {}UniformUsed(ub_name: []const u8, u_name: []const u8) ?bool {{\n", to_camel_case(prog.name));
+    bool wrote_ub_name = false;
+    bool wrote_u_name = false;
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            l_open("if (std.mem.eql(u8, ub_name, \"{}\")) {{\n", ub.name);
+            wrote_ub_name = true;
+            for (const Type& u: ub.struct_info.struct_items) {
+                l_open("if (std.mem.eql(u8, u_name, \"{}\")) {{\n", u.name);
+                l("return {};\n", u.used);
+                l_close("}}\n");
+                wrote_u_name = true;
+            }
+            l_close("}}\n");
+        }
+    }
+    if (!wrote_ub_name) {
+        l("_ = ub_name;\n");
+    }
+    if (!wrote_u_name) {
+        l("_ = u_name;\n");
+    }
+    l("return null;\n");
+    l_close("}}\n");
+}
+
 void SokolZigGenerator::gen_uniform_desc_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("pub fn {}UniformDesc(ub_name: []const u8, u_name: []const u8) ?sg.GlslShaderUniform {{\n", to_camel_case(prog.name));
     bool wrote_ub_name = false;
@@ -30,6 +30,7 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
             for (const ProgramReflection& prog: gen.refl.progs) {
                 l_open("-\n");
                 l("name: {}\n", prog.name);
+                l("hash: 0x{:016X}\n", program_hash(gen, prog, slang));
                 for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
                     const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                     if (info.stage == ShaderStage::Invalid) {
@@ -52,6 +53,10 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
                     if (d3d11_tgt) {
                         l("d3d11_target: {}\n", d3d11_tgt);
                     }
+                    const SpirvcrossSource* src = gen.spirvcross[slang].find_source_by_snippet_index(refl.snippet_index);
+                    if (src) {
+                        gen_stats(src->stats);
+                    }
                     l_close();
                 }
                 if (Slang::is_msl(slang) && prog.has_cs()) {
@@ -70,6 +75,13 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
                     }
                     l_close();
                 }
+                if (prog.spec_constants.size() > 0) {
+                    l_open("spec_constants:\n");
+                    for (const auto& spec_constant: prog.spec_constants) {
+                        gen_spec_constant(spec_constant, slang);
+                    }
+                    l_close();
+                }
                 if (prog.bindings.uniform_blocks.size() > 0) {
                     l_open("uniform_blocks:\n");
                     for (const auto& uniform_block: prog.bindings.uniform_blocks) {
@@ -124,6 +136,24 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
     return ErrMsg();
 }
 
+void YamlGenerator::gen_stats(const SpirvStats& stats) {
+    l_open("stats:\n");
+    l("instructions: {}\n", stats.num_instructions);
+    l("alu: {}\n", stats.num_alu);
+    l("samples: {}\n", stats.num_samples);
+    l("branches: {}\n", stats.num_branches);
+    l("loops: {}\n", stats.num_loops);
+    l("barriers: {}\n", stats.num_barriers);
+    l("locals: {}\n", stats.num_locals);
+    l("cost: {}\n", stats.cost());
+    if (stats.is_compute()) {
+        l("shared_memory: {}\n", stats.shared_memory_size);
+        l("workgroups_per_cu: {}\n", stats.workgroups_per_cu);
+        l("occupancy: {}\n", stats.occupancy);
+    }
+    l_close();
+}
+
 void YamlGenerator::gen_attr(const StageAttr& attr, Slang::Enum slang) {
     l_open("-\n");
     l("slot: {}\n", attr.slot);
@@ -138,11 +168,27 @@ void YamlGenerator::gen_attr(const StageAttr& attr, Slang::Enum slang) {
     l_close();
 }
 
+void YamlGenerator::gen_spec_constant(const SpecConstant& sc, Slang::Enum slang) {
+    l_open("-\n");
+    l("name: {}\n", sc.name);
+    l("constant_id: {}\n", sc.constant_id);
+    l("type: {}\n", Type::type_to_glsl(sc.type));
+    l("default_value: {}\n", sc.default_value);
+    // GLSL without Vulkan semantics and HLSL have no specialization constants,
+    // the default value can instead be overridden with a preprocessor define
+    if (Slang::is_hlsl(slang) || (Slang::is_glsl(slang) && (slang != Slang::GLSL450))) {
+        l("define: SPIRV_CROSS_CONSTANT_ID_{}\n", sc.constant_id);
+    }
+    l_close();
+}
+
 void YamlGenerator::gen_uniform_block(const GenInput& gen, const UniformBlock& ub, Slang::Enum slang) {
     l_open("-\n");
     l("slot: {}\n", ub.sokol_slot);
     l("stage: {}\n", shader_stage(ub.stage));
     l("size: {}\n", roundup(ub.struct_info.size, 16));
+    l("used_offset: {}\n", ub.used_offset);
+    l("used_size: {}\n", ub.used_size);
     l("struct_name: {}\n", ub.name);
     l("inst_name: {}\n", ub.inst_name);
     if (Slang::is_hlsl(slang)) {
@@ -188,6 +234,7 @@ void YamlGenerator::gen_uniform_block_refl(const UniformBlock& ub) {
         l("type: {}\n", uniform_type(u.type));
         l("array_count: {}\n", u.array_count);
         l("offset: {}\n", u.offset);
+        l("used: {}\n", u.used);
         l_close();
     }
     l_close();
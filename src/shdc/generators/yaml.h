@@ -16,7 +16,9 @@ protected:
     virtual std::string sampler_type(refl::SamplerType::Enum e);
     virtual std::string storage_pixel_format(refl::StoragePixelFormat::Enum e);
 private:
+    void gen_stats(const SpirvStats& stats);
     void gen_attr(const refl::StageAttr& attr, Slang::Enum slang);
+    void gen_spec_constant(const refl::SpecConstant& sc, Slang::Enum slang);
     void gen_uniform_block(const GenInput& gen, const refl::UniformBlock& ub, Slang::Enum slang);
     void gen_uniform_block_refl(const refl::UniformBlock& ub);
     void gen_storage_buffer(const refl::StorageBuffer& sbuf, Slang::Enum slang);
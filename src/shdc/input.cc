@@ -2,12 +2,15 @@
     code for loading and parsing the input .glsl file with custom-tags
 */
 #include "input.h"
+#include "layout.h"
 #include "types/reflection/type.h"
 #include "types/reflection/bindings.h"
 #include "types/option.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string_view>
+#include <unordered_set>
 #include "fmt/format.h"
 #include "pystring.h"
 
@@ -130,8 +133,48 @@ static const std::string msl_options_tag = "@msl_options";
 static const std::string include_tag = "@include";
 static const std::string image_sample_type_tag = "@image_sample_type";
 static const std::string sampler_type_tag = "@sampler_type";
+static const std::string ub_packed_tag = "@ub_packed";
 
-static bool normalize_pragma_sokol(std::vector<std::string>& toks, std::string &line, int line_index, Input& inp) {
+// a tag line split into whitespace-separated tokens, the tokens are views into the line string
+using Tokens = std::vector<std::string_view>;
+
+static bool is_space(char c) {
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\v') || (c == '\f');
+}
+
+// return the first non-whitespace character in a line, or 0 for empty lines
+static char first_nonspace_char(std::string_view line) {
+    for (const char c: line) {
+        if (!is_space(c)) {
+            return c;
+        }
+    }
+    return 0;
+}
+
+/* split a line into whitespace-separated tokens, the token array is reused
+    and the tokens point into the line string, so this doesn't allocate
+    once the token array has grown to its final capacity
+*/
+static void split_tokens(std::string_view line, Tokens& out_tokens) {
+    out_tokens.clear();
+    size_t pos = 0;
+    const size_t len = line.length();
+    while (pos < len) {
+        while ((pos < len) && is_space(line[pos])) {
+            pos++;
+        }
+        const size_t start = pos;
+        while ((pos < len) && !is_space(line[pos])) {
+            pos++;
+        }
+        if (pos > start) {
+            out_tokens.push_back(line.substr(start, pos - start));
+        }
+    }
+}
+
+static bool normalize_pragma_sokol(Tokens& toks, std::string &line, int line_index, Input& inp) {
     // Returns true if it saw no errors, even if it did nothing.
     // If it sees #pragma sokol, it modifies both `toks` and `line`
     // in-place so that they no longer contain them.
@@ -152,20 +195,21 @@ static bool normalize_pragma_sokol(std::vector<std::string>& toks, std::string &
     if (toks.size() <= expect_tag_index || toks[expect_tag_index][0] != '@') {
         inp.out_error = inp.error(line_index, fmt::format(
             "'#pragma sokol' should be followed by a @tag, got `{}`.",
-            toks[expect_tag_index]));
+            (toks.size() > expect_tag_index) ? toks[expect_tag_index] : std::string_view()));
         return false;
     }
-    toks.erase(toks.begin(), toks.begin() + expect_tag_index);
     // We don't know where in the line itself this is, so just drop everything
-    // before the first @.
+    // before the first @. Since the tokens point into the line they need to
+    // be split again afterwards.
     auto at_pos = line.find('@');
     assert(at_pos != std::string::npos);
     line.erase(line.begin(), line.begin() + at_pos);
-    return true;;
+    split_tokens(line, toks);
+    return true;
 }
 
 // validate source tags for errors, on error returns false and sets error object in inp
-static bool validate_module_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_module_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 2) {
         inp.out_error = inp.error(line_index, "@module tag must have exactly one arg (@lib name)");
         return false;
@@ -181,7 +225,7 @@ static bool validate_module_tag(const std::vector<std::string>& tokens, bool in_
     return true;
 }
 
-static bool validate_ctype_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_ctype_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 3) {
         inp.out_error = inp.error(line_index, "@ctype tag must have exactly two args (@ctype glsltype ctype)");
         return false;
@@ -190,14 +234,14 @@ static bool validate_ctype_tag(const std::vector<std::string>& tokens, bool in_s
         inp.out_error = inp.error(line_index, "@ctype tag cannot be inside a tag block (missing @end?).");
         return false;
     }
-    if (!Type::is_valid_glsl_type(tokens[1])) {
+    if (!Type::is_valid_glsl_type(std::string(tokens[1]))) {
         inp.out_error = inp.error(line_index, fmt::format("first arg of @ctype tag must be one of {}", Type::valid_glsl_types_as_str()));
         return false;
     }
     return true;
 }
 
-static bool validate_header_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_header_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() < 2) {
         inp.out_error = inp.error(line_index, "@header tag must have at least one arg (@header ...)");
         return false;
@@ -209,7 +253,7 @@ static bool validate_header_tag(const std::vector<std::string>& tokens, bool in_
     return true;
 }
 
-static bool validate_block_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_block_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 2) {
         inp.out_error = inp.error(line_index, "@block tag must have exactly one arg (@block name).");
         return false;
@@ -218,14 +262,14 @@ static bool validate_block_tag(const std::vector<std::string>& tokens, bool in_s
         inp.out_error = inp.error(line_index, "@block tag cannot be inside other tag block (missing @end?).");
         return false;
     }
-    if (inp.snippet_map.count(tokens[1]) > 0) {
+    if (inp.snippet_map.count(std::string(tokens[1])) > 0) {
         inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@block {}).", tokens[1]));
         return false;
     }
     return true;
 }
 
-static bool validate_vs_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_vs_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 2) {
         inp.out_error = inp.error(line_index, "@vs tag must have exactly one arg (@vs name).");
         return false;
@@ -234,14 +278,14 @@ static bool validate_vs_tag(const std::vector<std::string>& tokens, bool in_snip
         inp.out_error = inp.error(line_index, "@vs tag cannot be inside other tag block (missing @end?).");
         return false;
     }
-    if (inp.snippet_map.count(tokens[1]) > 0) {
+    if (inp.snippet_map.count(std::string(tokens[1])) > 0) {
         inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@vs {}).", tokens[1]));
         return false;
     }
     return true;
 }
 
-static bool validate_fs_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_fs_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 2) {
         inp.out_error = inp.error(line_index, "@fs tag must have exactly one arg (@fs name).");
         return false;
@@ -250,14 +294,14 @@ static bool validate_fs_tag(const std::vector<std::string>& tokens, bool in_snip
         inp.out_error = inp.error(line_index, "@fs tag cannot be inside other tag block (missing @end?).");
         return false;
     }
-    if (inp.snippet_map.count(tokens[1]) > 0) {
+    if (inp.snippet_map.count(std::string(tokens[1])) > 0) {
         inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@fs {}).", tokens[1]));
         return false;
     }
     return true;
 }
 
-static bool validate_cs_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_cs_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 2) {
         inp.out_error = inp.error(line_index, "@cs tag must have exactly one arg (@cs name).");
         return false;
@@ -266,14 +310,14 @@ static bool validate_cs_tag(const std::vector<std::string>& tokens, bool in_snip
         inp.out_error = inp.error(line_index, "@cs tag cannot be inside other tag block (missing @end?).");
         return false;
     }
-    if (inp.snippet_map.count(tokens[1]) > 0) {
+    if (inp.snippet_map.count(std::string(tokens[1])) > 0) {
         inp.out_error = inp.error(line_index, fmt::format("@block, @vs, @fs and @cs tag names must be unique (@cs {}).", tokens[1]));
         return false;
     }
     return true;
 }
 
-static bool validate_inclblock_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_inclblock_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 2) {
         inp.out_error = inp.error(line_index, "@include_block tag must have exactly one arg (@include_block block_name).");
         return false;
@@ -282,14 +326,14 @@ static bool validate_inclblock_tag(const std::vector<std::string>& tokens, bool
         inp.out_error = inp.error(line_index, "@include_block must be inside a @block, @vs or @fs block.");
         return false;
     }
-    if (inp.snippet_map.count(tokens[1]) != 1) {
+    if (inp.snippet_map.count(std::string(tokens[1])) != 1) {
         inp.out_error = inp.error(line_index, fmt::format("@block '{}' not found for including.", tokens[1]));
         return false;
     }
     return true;
 }
 
-static bool validate_end_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_end_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if (tokens.size() != 1) {
         inp.out_error = inp.error(line_index, "@end tag must be the only word in a line.");
         return false;
@@ -301,7 +345,7 @@ static bool validate_end_tag(const std::vector<std::string>& tokens, bool in_sni
     return true;
 }
 
-static bool validate_program_tag(const std::vector<std::string>& tokens, bool in_snippet, int line_index, Input& inp) {
+static bool validate_program_tag(const Tokens& tokens, bool in_snippet, int line_index, Input& inp) {
     if ((tokens.size() != 3) && (tokens.size() != 4)) {
         inp.out_error = inp.error(line_index, "@program tag must have 2 or 3 args (@program name [vs_name fs_name]|[cs_name]).");
         return false;
@@ -310,21 +354,21 @@ static bool validate_program_tag(const std::vector<std::string>& tokens, bool in
         inp.out_error = inp.error(line_index, "@program tag cannot be inside a block tag.");
         return false;
     }
-    if (inp.programs.count(tokens[1]) > 0) {
+    if (inp.programs.count(std::string(tokens[1])) > 0) {
         inp.out_error = inp.error(line_index, fmt::format("@program '{}' already defined.", tokens[1]));
         return false;
     }
     if (tokens.size() == 4) {
-        if (inp.vs_map.count(tokens[2]) != 1) {
+        if (inp.vs_map.count(std::string(tokens[2])) != 1) {
             inp.out_error = inp.error(line_index, fmt::format("@vs '{}' not found for @program '{}'.", tokens[2], tokens[1]));
             return false;
         }
-        if (inp.fs_map.count(tokens[3]) != 1) {
+        if (inp.fs_map.count(std::string(tokens[3])) != 1) {
             inp.out_error = inp.error(line_index, fmt::format("@fs '{}' not found for @program '{}'.", tokens[3], tokens[1]));
             return false;
         }
     } else {
-        if (inp.cs_map.count(tokens[2]) != 1) {
+        if (inp.cs_map.count(std::string(tokens[2])) != 1) {
             inp.out_error = inp.error(line_index, fmt::format("@cs '{}' not found for @program '{}.", tokens[2], tokens[1]));
             return false;
         }
@@ -332,7 +376,7 @@ static bool validate_program_tag(const std::vector<std::string>& tokens, bool in
     return true;
 }
 
-static bool validate_options_tag(const std::vector<std::string>& tokens, const Snippet& cur_snippet, int line_index, Input& inp) {
+static bool validate_options_tag(const Tokens& tokens, const Snippet& cur_snippet, int line_index, Input& inp) {
     if (tokens.size() < 2) {
         inp.out_error = inp.error(line_index, fmt::format("{} must have at least 1 arg ('fixup_clipspace', 'flip_vert_y')", tokens[0]));
         return false;
@@ -342,7 +386,7 @@ static bool validate_options_tag(const std::vector<std::string>& tokens, const S
         return false;
     }
     for (int i = 1; i < (int)tokens.size(); i++) {
-        if (Option::from_string(tokens[i]) == Option::INVALID) {
+        if (Option::from_string(std::string(tokens[i])) == Option::INVALID) {
             inp.out_error = inp.error(line_index, fmt::format("unknown option '{}' (must be 'fixup_clipspace', 'flip_vert_y')", tokens[i]));
             return false;
         }
@@ -350,38 +394,50 @@ static bool validate_options_tag(const std::vector<std::string>& tokens, const S
     return true;
 }
 
-static bool validate_image_sample_type_tag(const std::vector<std::string>& tokens, int line_index, Input& inp) {
+static bool validate_image_sample_type_tag(const Tokens& tokens, int line_index, Input& inp) {
     if (tokens.size() != 3) {
         inp.out_error = inp.error(line_index, fmt::format("@image_sample_type must have 2 args (@image_sample_type [texture] {})", ImageSampleType::valid_image_sample_types_as_str()));
         return false;
     }
-    if (nullptr != inp.find_image_sample_type_tag(tokens[1])) {
+    if (nullptr != inp.find_image_sample_type_tag(std::string(tokens[1]))) {
         inp.out_error = inp.error(line_index, "duplicate @image_sample_type (texture name must be unique)");
         return false;
     }
-    if (!ImageSampleType::is_valid_str(tokens[2])) {
+    if (!ImageSampleType::is_valid_str(std::string(tokens[2]))) {
         inp.out_error = inp.error(line_index, fmt::format("second arg of @image_sample_type tag must be one of {}", ImageSampleType::valid_image_sample_types_as_str()));
         return false;
     }
     return true;
 }
 
-static bool validate_sampler_type_tag(const std::vector<std::string>& tokens, int line_index, Input& inp) {
+static bool validate_sampler_type_tag(const Tokens& tokens, int line_index, Input& inp) {
     if (tokens.size() != 3) {
         inp.out_error = inp.error(line_index, fmt::format("@sampler_type must have 2 args (@sampler_type [sampler] {})", SamplerType::valid_sampler_types_as_str()));
         return false;
     }
-    if (nullptr != inp.find_sampler_type_tag(tokens[1])) {
+    if (nullptr != inp.find_sampler_type_tag(std::string(tokens[1]))) {
         inp.out_error = inp.error(line_index, "duplicate @sampler_type (sampler name must be unique)");
         return false;
     }
-    if (!SamplerType::is_valid_str(tokens[2])) {
+    if (!SamplerType::is_valid_str(std::string(tokens[2]))) {
         inp.out_error = inp.error(line_index, fmt::format("second arg of @sampler_type tag must be one of {}", SamplerType::valid_sampler_types_as_str()));
         return false;
     }
     return true;
 }
 
+static bool validate_ub_packed_tag(const Tokens& tokens, int line_index, Input& inp) {
+    if (tokens.size() != 2) {
+        inp.out_error = inp.error(line_index, "@ub_packed must have exactly one arg (@ub_packed [uniform block name])");
+        return false;
+    }
+    if (inp.ub_packed_tags.count(std::string(tokens[1])) > 0) {
+        inp.out_error = inp.error(line_index, "duplicate @ub_packed (uniform block name must be unique)");
+        return false;
+    }
+    return true;
+}
+
 /* This parses the split input line array for custom tags (@vs, @fs, @block,
     @end and @program), and fills the respective members. If a parsing error
     happens, the inp.error object is setup accordingly.
@@ -390,40 +446,46 @@ static bool parse(Input& inp) {
     bool in_snippet = false;
     bool add_line = false;
     Snippet cur_snippet;
-    std::vector<std::string> tokens;
+    Tokens tokens;
     int line_index = 0;
     for (Line& line_info : inp.lines) {
-        const std::string& line = line_info.line;
+        const std::string_view line = line_info.line;
         add_line = in_snippet;
-        pystring::split(line, tokens);
-        if (tokens.size() > 0) {
+        // only lines starting with a tag need to be split into tokens
+        if (first_nonspace_char(line) == '@') {
+            split_tokens(line, tokens);
             if (tokens[0] == module_tag) {
                 if (!validate_module_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                inp.module = tokens[1];
+                inp.module = std::string(tokens[1]);
             } else if (tokens[0] == ctype_tag) {
                 if (!validate_ctype_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                if (inp.ctype_map.count(tokens[1]) > 0) {
+                if (inp.ctype_map.count(std::string(tokens[1])) > 0) {
                     inp.out_error = inp.error(line_index, fmt::format("type '{}' already defined!", tokens[1]));
                     return false;
                 }
-                inp.ctype_map[tokens[1]] = tokens[2];
+                inp.ctype_map[std::string(tokens[1])] = std::string(tokens[2]);
             } else if (tokens[0] == header_tag) {
                 if (!validate_header_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                std::vector<std::string> skip_first_token = tokens;
-                skip_first_token.erase(skip_first_token.begin());
-                inp.headers.push_back(pystring::join(" ", skip_first_token));
+                std::string header;
+                for (size_t i = 1; i < tokens.size(); i++) {
+                    if (i > 1) {
+                        header += ' ';
+                    }
+                    header += tokens[i];
+                }
+                inp.headers.push_back(std::move(header));
             } else if (tokens[0] == glsl_options_tag) {
                 if (!validate_options_tag(tokens, cur_snippet, line_index, inp)) {
                     return false;
                 }
                 for (int i = 1; i < (int)tokens.size(); i++) {
-                    uint32_t option_bit = Option::from_string(tokens[i]);
+                    uint32_t option_bit = Option::from_string(std::string(tokens[i]));
                     cur_snippet.options[Slang::GLSL410] |= option_bit;
                     cur_snippet.options[Slang::GLSL430] |= option_bit;
                     cur_snippet.options[Slang::GLSL450] |= option_bit;
@@ -436,7 +498,7 @@ static bool parse(Input& inp) {
                     return false;
                 }
                 for (int i = 1; i < (int)tokens.size(); i++) {
-                    uint32_t option_bit = Option::from_string(tokens[i]);
+                    uint32_t option_bit = Option::from_string(std::string(tokens[i]));
                     cur_snippet.options[Slang::HLSL4] |= option_bit;
                     cur_snippet.options[Slang::HLSL5] |= option_bit;
                 }
@@ -446,7 +508,7 @@ static bool parse(Input& inp) {
                     return false;
                 }
                 for (int i = 1; i < (int)tokens.size(); i++) {
-                    uint32_t option_bit = Option::from_string(tokens[i]);
+                    uint32_t option_bit = Option::from_string(std::string(tokens[i]));
                     cur_snippet.options[Slang::METAL_MACOS] |= option_bit;
                     cur_snippet.options[Slang::METAL_IOS] |= option_bit;
                     cur_snippet.options[Slang::METAL_SIM] |= option_bit;
@@ -456,35 +518,35 @@ static bool parse(Input& inp) {
                 if (!validate_block_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                cur_snippet = Snippet(Snippet::BLOCK, tokens[1]);
+                cur_snippet = Snippet(Snippet::BLOCK, std::string(tokens[1]));
                 add_line = false;
                 in_snippet = true;
             } else if (tokens[0] == vs_tag) {
                 if (!validate_vs_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                cur_snippet = Snippet(Snippet::VS, tokens[1]);
+                cur_snippet = Snippet(Snippet::VS, std::string(tokens[1]));
                 add_line = false;
                 in_snippet = true;
             } else if (tokens[0] == fs_tag) {
                 if (!validate_fs_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                cur_snippet = Snippet(Snippet::FS, tokens[1]);
+                cur_snippet = Snippet(Snippet::FS, std::string(tokens[1]));
                 add_line = false;
                 in_snippet = true;
             } else if (tokens[0] == cs_tag) {
                 if (!validate_cs_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                cur_snippet = Snippet(Snippet::CS, tokens[1]);
+                cur_snippet = Snippet(Snippet::CS, std::string(tokens[1]));
                 add_line = false;
                 in_snippet = true;
             } else if (tokens[0] == inclblock_tag) {
                 if (!validate_inclblock_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
-                const Snippet& src_snippet = inp.snippets[inp.snippet_map[tokens[1]]];
+                const Snippet& src_snippet = inp.snippets[inp.snippet_map[std::string(tokens[1])]];
                 for (int line_index : src_snippet.lines) {
                     cur_snippet.lines.push_back(line_index);
                 }
@@ -518,25 +580,34 @@ static bool parse(Input& inp) {
                 if (!validate_program_tag(tokens, in_snippet, line_index, inp)) {
                     return false;
                 }
+                const std::string prog_name(tokens[1]);
                 if (tokens.size() == 4) {
-                    inp.programs[tokens[1]] = Program::from_vs_fs(tokens[1], tokens[2], tokens[3], line_index);
+                    inp.programs[prog_name] = Program::from_vs_fs(prog_name, std::string(tokens[2]), std::string(tokens[3]), line_index);
                 } else {
-                    inp.programs[tokens[1]] = Program::from_cs(tokens[1], tokens[2], line_index);
+                    inp.programs[prog_name] = Program::from_cs(prog_name, std::string(tokens[2]), line_index);
                 }
                 add_line = false;
             } else if (tokens[0] == image_sample_type_tag) {
                 if (!validate_image_sample_type_tag(tokens, line_index, inp)) {
                     return false;
                 }
-                inp.image_sample_type_tags[tokens[1]] = ImageSampleTypeTag(tokens[1], ImageSampleType::from_str(tokens[2]), line_index);
+                const std::string tex_name(tokens[1]);
+                inp.image_sample_type_tags[tex_name] = ImageSampleTypeTag(tex_name, ImageSampleType::from_str(std::string(tokens[2])), line_index);
                 add_line = false;
             } else if (tokens[0] == sampler_type_tag) {
                 if (!validate_sampler_type_tag(tokens, line_index, inp)) {
                     return false;
                 }
-                inp.sampler_type_tags[tokens[1]] = SamplerTypeTag(tokens[1], SamplerType::from_str(tokens[2]), line_index);
+                const std::string smp_name(tokens[1]);
+                inp.sampler_type_tags[smp_name] = SamplerTypeTag(smp_name, SamplerType::from_str(std::string(tokens[2])), line_index);
+                add_line = false;
+            } else if (tokens[0] == ub_packed_tag) {
+                if (!validate_ub_packed_tag(tokens, line_index, inp)) {
+                    return false;
+                }
+                inp.ub_packed_tags[std::string(tokens[1])] = line_index;
                 add_line = false;
-            } else if (tokens[0][0] == '@') {
+            } else {
                 inp.out_error = inp.error(line_index, fmt::format("unknown meta tag: {}", tokens[0]));
                 return false;
             }
@@ -557,7 +628,144 @@ static bool parse(Input& inp) {
     return true;
 }
 
-static bool validate_include_tag(const std::vector<std::string>& tokens, int line_nr, const std::string& path, Input& inp) {
+// remove a trailing line comment and surrounding whitespace
+static std::string_view strip_line(std::string_view line) {
+    const size_t comment_pos = line.find("//");
+    if (comment_pos != std::string_view::npos) {
+        line = line.substr(0, comment_pos);
+    }
+    while (!line.empty() && is_space(line.front())) {
+        line.remove_prefix(1);
+    }
+    while (!line.empty() && is_space(line.back())) {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+// parse a uniform block member declaration of the form 'type name;' or 'type name[N];'
+// (optionally with precision qualifier), returns false if the line isn't a single declaration
+static bool parse_ub_member_line(std::string_view line, Tokens& tokens, Layout::Item& out_item, std::string& out_type) {
+    line = strip_line(line);
+    if (line.empty() || (line.back() != ';') || (line.find(';') != (line.length() - 1))) {
+        return false;
+    }
+    line.remove_suffix(1);
+    split_tokens(line, tokens);
+    if (tokens.size() < 2) {
+        return false;
+    }
+    std::string_view name = tokens.back();
+    int array_count = 0;
+    const size_t bracket_pos = name.find('[');
+    if (bracket_pos != std::string_view::npos) {
+        if (name.back() != ']') {
+            return false;
+        }
+        array_count = atoi(std::string(name.substr(bracket_pos + 1, name.length() - bracket_pos - 2)).c_str());
+        if (array_count <= 0) {
+            return false;
+        }
+        name = name.substr(0, bracket_pos);
+    }
+    out_item.name = std::string(name);
+    out_type = std::string(tokens[tokens.size() - 2]);
+    return Layout::std140_item(out_type, array_count, out_item);
+}
+
+// check if a line starts a uniform block declaration, returns the block name
+static std::string_view find_uniform_block_name(std::string_view line, Tokens& tokens) {
+    split_tokens(strip_line(line), tokens);
+    for (size_t i = 0; (i + 1) < tokens.size(); i++) {
+        if (tokens[i] == "uniform") {
+            std::string_view name = tokens[i + 1];
+            const size_t brace_pos = name.find('{');
+            if (brace_pos != std::string_view::npos) {
+                name = name.substr(0, brace_pos);
+            }
+            return name;
+        }
+    }
+    return std::string_view();
+}
+
+/* Reorder the members of uniform blocks tagged with @ub_packed for
+    minimal std140 padding. This only permutes the snippet's line indices,
+    so error messages still point to the original source lines.
+*/
+static bool apply_ub_packed_tags(Input& inp) {
+    if (inp.ub_packed_tags.empty()) {
+        return true;
+    }
+    std::unordered_set<std::string> found_blocks;
+    Tokens tokens;
+    for (Snippet& snippet: inp.snippets) {
+        for (size_t i = 0; i < snippet.lines.size(); i++) {
+            const std::string ub_name(find_uniform_block_name(inp.lines[snippet.lines[i]].line, tokens));
+            if (ub_name.empty() || (inp.ub_packed_tags.count(ub_name) == 0)) {
+                continue;
+            }
+            // find the opening brace, either on the same or the next line
+            size_t first = i + 1;
+            if (inp.lines[snippet.lines[i]].line.find('{') == std::string_view::npos) {
+                if ((first >= snippet.lines.size()) || (strip_line(inp.lines[snippet.lines[first]].line) != "{")) {
+                    inp.out_error = inp.error(snippet.lines[i], fmt::format("@ub_packed: expected '{{' on the line after 'uniform {}'", ub_name));
+                    return false;
+                }
+                first++;
+            }
+            // gather member declarations up to the closing brace
+            std::vector<size_t> member_positions;
+            std::vector<Layout::Item> items;
+            size_t pos = first;
+            for (; pos < snippet.lines.size(); pos++) {
+                const int line_index = snippet.lines[pos];
+                const std::string_view line = strip_line(inp.lines[line_index].line);
+                if (line.empty()) {
+                    continue;
+                }
+                if (line.front() == '}') {
+                    break;
+                }
+                Layout::Item item;
+                std::string type;
+                if (!parse_ub_member_line(line, tokens, item, type)) {
+                    if (type.empty()) {
+                        inp.out_error = inp.error(line_index, fmt::format("@ub_packed: members of uniform block '{}' must be declared one per line ('type name;' or 'type name[N];')", ub_name));
+                    } else {
+                        inp.out_error = inp.error(line_index, fmt::format("@ub_packed: unsupported type '{}' in uniform block '{}'", type, ub_name));
+                    }
+                    return false;
+                }
+                member_positions.push_back(pos);
+                items.push_back(item);
+            }
+            if (pos == snippet.lines.size()) {
+                inp.out_error = inp.error(snippet.lines[i], fmt::format("@ub_packed: closing '}}' of uniform block '{}' not found", ub_name));
+                return false;
+            }
+            const std::vector<int> order = Layout::packed_order(items, 16);
+            std::vector<int> member_lines;
+            for (size_t member_pos: member_positions) {
+                member_lines.push_back(snippet.lines[member_pos]);
+            }
+            for (size_t j = 0; j < member_positions.size(); j++) {
+                snippet.lines[member_positions[j]] = member_lines[order[j]];
+            }
+            found_blocks.insert(ub_name);
+            i = pos;
+        }
+    }
+    for (const auto& [ub_name, line_index]: inp.ub_packed_tags) {
+        if (found_blocks.count(ub_name) == 0) {
+            inp.out_error = inp.error(line_index, fmt::format("@ub_packed: uniform block '{}' not found", ub_name));
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool validate_include_tag(const Tokens& tokens, int line_nr, const std::string& path, Input& inp) {
     if (tokens.size() != 2) {
         inp.out_error = ErrMsg::error(path, line_nr, "@include tag must have exactly one arg (@include filename).");
         return false;
@@ -565,6 +773,53 @@ static bool validate_include_tag(const std::vector<std::string>& tokens, int lin
     return true;
 }
 
+static ErrMsg open_error(const std::string& path, const Input& inp, int parent_line_index) {
+    if (inp.base_path == path) {
+        return ErrMsg::error(path, 0, fmt::format("Failed to open input file '{}'", path));
+    } else {
+        return ErrMsg::error(inp.filenames.back(), parent_line_index, fmt::format("Failed to open @include file '{}'", path));
+    }
+}
+
+// remove comments, split into lines and resolve '#pragma sokol' and @include tags
+static bool preprocess(std::string& str, const std::string& path, Input& inp, SourceFile& out_file) {
+    out_file.path = path;
+
+    // remove comments before splitting into lines
+    if (!remove_comments(str)) {
+        inp.out_error = ErrMsg::error(path, 0, fmt::format("(FIXME) Error during removing comments in '{}'", path));
+    }
+
+    // split source file into lines
+    pystring::splitlines(str, out_file.lines);
+    out_file.includes.resize(out_file.lines.size());
+
+    // only lines starting with '@' or '#' can contain an @include
+    // or '#pragma sokol' tag, everything else is passed through
+    Tokens tokens;
+    int line_index = 0;
+    for (std::string& line : out_file.lines) {
+        const char first_char = first_nonspace_char(line);
+        if ((first_char == '@') || (first_char == '#')) {
+            split_tokens(line, tokens);
+            if (!normalize_pragma_sokol(tokens, line, line_index, inp)) {
+                return false;
+            }
+            if (tokens[0] == include_tag) {
+                if (!validate_include_tag(tokens, line_index, path, inp)) {
+                    return false;
+                }
+                out_file.includes[line_index] = tokens[1];
+            }
+        }
+        // the terminating newline isn't part of Line::line, but allows
+        // to pass lines directly to glslang without copying them
+        line.push_back('\n');
+        line_index++;
+    }
+    return true;
+}
+
 static bool load_and_preprocess(const std::string& path, const std::vector<std::string>& include_dirs, Input& inp, int parent_line_index) {
     std::string path_used = path;
     std::string str = load_file_into_str(path_used);
@@ -579,63 +834,40 @@ static bool load_and_preprocess(const std::string& path, const std::vector<std::
         }
         // failure?
         if (str.empty()) {
-            if (inp.base_path == path) {
-                inp.out_error = ErrMsg::error(path, 0, fmt::format("Failed to open input file '{}'", path));
-            } else {
-                inp.out_error = ErrMsg::error(inp.filenames.back(), parent_line_index, fmt::format("Failed to open @include file '{}'", path));
-            }
+            inp.out_error = open_error(path, inp, parent_line_index);
             return false;
         }
     }
     // check for include cycles
-    for (const std::string& filename : inp.filenames) {
-        if (filename == path_used) {
-            inp.out_error = ErrMsg::error(inp.filenames.back(), parent_line_index, fmt::format("Detected @include file cycle: '{}'", path_used));
-            return false;
-        }
+    if (inp.filename_set.count(path_used) > 0) {
+        inp.out_error = ErrMsg::error(inp.filenames.back(), parent_line_index, fmt::format("Detected @include file cycle: '{}'", path_used));
+        return false;
     }
-    // add to filenames
-    int filename_index = (int)inp.filenames.size();
-    inp.filenames.push_back(path_used);
 
-    // remove comments before splitting into lines
-    if (!remove_comments(str)) {
-        inp.out_error = ErrMsg::error(path_used, 0, fmt::format("(FIXME) Error during removing comments in '{}'", path_used));
+    auto file = std::make_shared<SourceFile>();
+    if (!preprocess(str, path_used, inp, *file)) {
+        return false;
     }
 
-    // split source file into lines
-    int line_index = 0;
-    std::vector<std::string> lines;
-    pystring::splitlines(str, lines);
-
-    // preprocess
-    std::vector<std::string> tokens;
-    for (std::string& line : lines) {
-        // look for @include tags
-        pystring::split(line, tokens);
-        if (tokens.size() > 0) {
-            if (!normalize_pragma_sokol(tokens, line, line_index, inp)) {
+    // add to filenames, the Input object keeps the file content alive
+    int filename_index = (int)inp.filenames.size();
+    inp.filenames.push_back(path_used);
+    inp.filename_set.insert(path_used);
+    inp.sources.push_back(file);
+
+    for (int line_index = 0; line_index < (int)file->lines.size(); line_index++) {
+        const std::string& include_filename = file->includes[line_index];
+        if (!include_filename.empty()) {
+            // insert included file
+            if (!load_and_preprocess(include_filename, include_dirs, inp, line_index)) {
                 return false;
             }
-            if (tokens[0] == include_tag) {
-                if (!validate_include_tag(tokens, line_index, path_used, inp)) {
-                    return false;
-                }
-                // insert included file
-                const std::string& include_filename = tokens[1];
-                if (!load_and_preprocess(include_filename, include_dirs, inp, line_index)) {
-                    return false;
-                }
-            } else {
-                // otherwise process file as normal
-                inp.lines.push_back({line, filename_index, line_index});
-            }
         } else {
-            // this is an empty line, but add it anyway so the error line
-            // indices are always correct
-            inp.lines.push_back({line, filename_index, line_index});
+            // otherwise process line as normal, also add empty lines so
+            // that the error line indices are always correct
+            const std::string& line = file->lines[line_index];
+            inp.lines.push_back({std::string_view(line.data(), line.length() - 1), filename_index, line_index});
         }
-        line_index++;
     }
 
     return true;
@@ -653,7 +885,9 @@ Input Input::load_and_parse(const std::string& path, const std::string& module_o
     Input inp;
     inp.base_path = path;
     if (load_and_preprocess(path, include_dirs, inp, 0)) {
-        parse(inp);
+        if (parse(inp)) {
+            apply_ub_packed_tags(inp);
+        }
     }
     if (!module_override.empty()) {
         inp.module = module_override;
@@ -757,6 +991,10 @@ void Input::dump_debug(ErrMsg::Format err_fmt) const {
     for (const auto& [key, val]: sampler_type_tags) {
         fmt::print(stderr, "      {}: {} (line: {})\n", key, SamplerType::to_str(val.type), val.line_index);
     }
+    fmt::print(stderr, "    ub packed tags:\n");
+    for (const auto& [key, val]: ub_packed_tags) {
+        fmt::print(stderr, "      {} (line: {})\n", key, val);
+    }
     fmt::print("\n");
 }
 
@@ -2,8 +2,11 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_set>
+#include <memory>
 #include "types/errmsg.h"
 #include "types/line.h"
+#include "types/source_file.h"
 #include "types/snippet.h"
 #include "types/program.h"
 
@@ -15,7 +18,9 @@ struct Input {
     std::string base_path;              // path to base file
     std::string module;                 // optional module name
     std::vector<std::string> filenames; // all source files, base is first entry
+    std::unordered_set<std::string> filename_set;   // all entries of filenames, for the @include cycle check
     std::vector<Line> lines;          // input source files split into lines
+    std::vector<std::shared_ptr<const SourceFile>> sources; // keeps the content referenced by lines alive
     std::vector<Snippet> snippets;    // @block, @vs and @fs snippets
     std::map<std::string, std::string> ctype_map;    // @ctype uniform type definitions
     std::vector<std::string> headers;       // @header statements
@@ -27,6 +32,7 @@ struct Input {
     std::map<std::string, Program> programs;    // all @program definitions
     std::map<std::string, ImageSampleTypeTag> image_sample_type_tags;
     std::map<std::string, SamplerTypeTag> sampler_type_tags;
+    std::map<std::string, int> ub_packed_tags;  // @ub_packed uniform block names => line index
 
     static Input load_and_parse(const std::string& path, const std::string& module_override);
     ErrMsg error(int line_index, const std::string& msg) const;
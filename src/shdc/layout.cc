@@ -0,0 +1,176 @@
+/*
+    Uniform block and storage buffer struct layout analysis: computes the
+    bytes wasted on alignment padding and proposes a member order with
+    minimal padding.
+*/
+#include "layout.h"
+#include "reflection.h"
+
+namespace shdc {
+
+using namespace refl;
+
+static int roundup(int val, int round_to) {
+    return (val + (round_to - 1)) & ~(round_to - 1);
+}
+
+bool Layout::std140_item(const std::string& glsl_type, int array_count, Item& out_item) {
+    std::string base = glsl_type;
+    if ((base.length() > 1) && ((base[0] == 'b') || (base[0] == 'i') || (base[0] == 'u')) && (base.compare(1, 3, "vec") == 0)) {
+        base = base.substr(1);
+    }
+    int size = 0;
+    int align = 0;
+    if ((base == "float") || (base == "int") || (base == "uint") || (base == "bool")) {
+        size = 4; align = 4;
+    } else if (base == "vec2") {
+        size = 8; align = 8;
+    } else if (base == "vec3") {
+        size = 12; align = 16;
+    } else if (base == "vec4") {
+        size = 16; align = 16;
+    } else if ((base.length() >= 4) && (base.compare(0, 3, "mat") == 0) && (base[3] >= '2') && (base[3] <= '4')) {
+        // std140 matrices are arrays of column vectors with a 16 byte stride
+        if ((base.length() != 4) && !((base.length() == 6) && (base[4] == 'x') && (base[5] >= '1') && (base[5] <= '4'))) {
+            return false;
+        }
+        size = 16 * (base[3] - '0'); align = 16;
+    } else {
+        return false;
+    }
+    if (array_count > 0) {
+        // std140 array elements are rounded up to 16 bytes
+        size = roundup(size, 16) * array_count;
+        align = 16;
+    }
+    out_item.size = size;
+    out_item.align = align;
+    return true;
+}
+
+std::vector<Layout::Item> Layout::items_from_struct(const Type& struc, bool std140) {
+    std::vector<Item> items;
+    for (const Type& type: struc.struct_items) {
+        Item item;
+        item.name = type.name;
+        item.size = type.size;
+        item.align = type.align;
+        if (std140 && (type.is_array || type.is_matrix || (type.type == Type::Struct))) {
+            item.align = 16;
+        }
+        item.pinned_last = type.is_array && (type.array_count == 0);
+        items.push_back(item);
+    }
+    return items;
+}
+
+std::vector<int> Layout::original_order(const std::vector<Item>& items) {
+    std::vector<int> order;
+    for (int i = 0; i < (int)items.size(); i++) {
+        order.push_back(i);
+    }
+    return order;
+}
+
+std::vector<int> Layout::packed_order(const std::vector<Item>& items, int struct_align) {
+    // greedy: at each step pick the item which needs the least padding at the
+    // current offset, preferring items with bigger alignment and size
+    std::vector<int> order;
+    std::vector<bool> placed(items.size(), false);
+    int offset = 0;
+    for (size_t n = 0; n < items.size(); n++) {
+        int best = -1;
+        int best_pad = 0;
+        for (int i = 0; i < (int)items.size(); i++) {
+            const Item& item = items[i];
+            if (placed[i] || item.pinned_last) {
+                continue;
+            }
+            const int pad = roundup(offset, item.align) - offset;
+            if ((best == -1) ||
+                (pad < best_pad) ||
+                ((pad == best_pad) && (item.align > items[best].align)) ||
+                ((pad == best_pad) && (item.align == items[best].align) && (item.size > items[best].size)))
+            {
+                best = i;
+                best_pad = pad;
+            }
+        }
+        if (best == -1) {
+            break;
+        }
+        placed[best] = true;
+        order.push_back(best);
+        offset = roundup(offset, items[best].align) + items[best].size;
+    }
+    for (int i = 0; i < (int)items.size(); i++) {
+        if (items[i].pinned_last) {
+            order.push_back(i);
+        }
+    }
+    // never propose an order which is worse than the original order
+    int orig_padding = 0;
+    int packed_padding = 0;
+    const std::vector<int> orig = original_order(items);
+    const int orig_size = struct_size(items, orig, struct_align, orig_padding);
+    const int packed_size = struct_size(items, order, struct_align, packed_padding);
+    if (packed_size >= orig_size) {
+        return orig;
+    }
+    return order;
+}
+
+int Layout::struct_size(const std::vector<Item>& items, const std::vector<int>& order, int struct_align, int& out_padding) {
+    int offset = 0;
+    int payload = 0;
+    for (int index: order) {
+        const Item& item = items[index];
+        offset = roundup(offset, item.align) + item.size;
+        payload += item.size;
+    }
+    const int size = roundup(offset, struct_align);
+    out_padding = size - payload;
+    return size;
+}
+
+static void print_struct_report(const char* kind, const std::string& name, const Type& struc, bool std140) {
+    const std::vector<Layout::Item> items = Layout::items_from_struct(struc, std140);
+    int struct_align = std140 ? 16 : 4;
+    for (const Layout::Item& item: items) {
+        if (item.align > struct_align) {
+            struct_align = item.align;
+        }
+    }
+    const std::vector<int> orig = Layout::original_order(items);
+    const std::vector<int> packed = Layout::packed_order(items, struct_align);
+    int orig_padding = 0;
+    int packed_padding = 0;
+    const int orig_size = Layout::struct_size(items, orig, struct_align, orig_padding);
+    const int packed_size = Layout::struct_size(items, packed, struct_align, packed_padding);
+    fmt::print(stderr, "{} '{}' ({}): {} bytes, {} bytes padding\n", kind, name, std140 ? "std140" : "std430", orig_size, orig_padding);
+    if (packed_size < orig_size) {
+        std::string names;
+        for (int index: packed) {
+            if (!names.empty()) {
+                names += ", ";
+            }
+            names += items[index].name;
+        }
+        fmt::print(stderr, "  proposed order: {} ({} bytes, {} bytes padding)\n", names, packed_size, packed_padding);
+    } else {
+        fmt::print(stderr, "  member order is already optimal\n");
+    }
+}
+
+void Layout::print_report(const Reflection& refl) {
+    fmt::print(stderr, "Layout report:\n");
+    for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+        print_struct_report("uniform block", ub.name, ub.struct_info, true);
+    }
+    for (const Type& struc: refl.sbuf_structs) {
+        print_struct_report("storage buffer struct", struc.struct_typename, struc, false);
+    }
+    fmt::print(stderr, "\n");
+}
+
+} // namespace shdc
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "types/reflection/type.h"
+
+namespace shdc {
+
+namespace refl {
+struct Reflection;
+}
+
+// uniform block and storage buffer struct layout analysis
+struct Layout {
+    struct Item {
+        std::string name;
+        int size = 0;
+        int align = 4;
+        bool pinned_last = false;   // unbounded arrays must remain the last struct item
+    };
+
+    // std140 size and alignment of a GLSL type name (optionally an array), returns false for unsupported types
+    static bool std140_item(const std::string& glsl_type, int array_count, Item& out_item);
+    // convert reflected struct items to layout items using std140 (uniform blocks) or std430 (storage buffers) alignment rules
+    static std::vector<Item> items_from_struct(const refl::Type& struc, bool std140);
+    // return a struct item order (indices into items) with minimal padding
+    static std::vector<int> packed_order(const std::vector<Item>& items, int struct_align);
+    // return the original struct item order
+    static std::vector<int> original_order(const std::vector<Item>& items);
+    // compute the padded struct size and the number of wasted padding bytes for an item order
+    static int struct_size(const std::vector<Item>& items, const std::vector<int>& order, int struct_align, int& out_padding);
+    // print a padding report for all uniform blocks and storage buffer structs to stderr
+    static void print_report(const refl::Reflection& refl);
+};
+
+} // namespace shdc
@@ -6,6 +6,9 @@
 #include "input.h"
 #include "spirvcross.h"
 #include "bytecode.h"
+#include "cache.h"
+#include "minify.h"
+#include "layout.h"
 #include "reflection.h"
 #include "util.h"
 #include "generators/generate.h"
@@ -38,11 +41,14 @@ int main(int argc, const char** argv) {
         return 10;
     }
 
-    // output source file dependencies
-    if (!args.dependency_file.empty()) {
-        const ErrMsg err = util::write_dep_file(args, inp);
-        if (err.valid()) {
-            err.print(args.error_format);
+    // open the optional compile cache
+    const Cache cache = Cache::open(args, inp);
+    if (args.debug_dump) {
+        cache.dump_debug();
+    }
+    if (cache.error.valid()) {
+        cache.error.print(args.error_format);
+        if (cache.error.type == ErrMsg::ERROR) {
             return 10;
         }
     }
@@ -50,10 +56,28 @@ int main(int argc, const char** argv) {
     // compile source snippets to SPIRV blobs (multiple compilations is necessary
     // because of conditional compilation by target language)
     std::array<Spirv,Slang::Num> spirv;
+    bool first_slang = true;
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (args.slang & Slang::bit(slang)) {
-            spirv[i] = Spirv::compile_glsl_and_extract_bindings(inp, slang, args.defines);
+            // shader language independent warnings are only generated for the first shader language
+            if (!cache.load_spirv(inp, slang, spirv[i])) {
+                spirv[i] = Spirv::compile_glsl_and_extract_bindings(inp, slang, args.defines, args.spec_constants, args.opt_level, args.perf_lint && first_slang, args.pack_varyings);
+                cache.store_spirv(slang, spirv[i]);
+            }
+            // the cost budget and compute limit checks need complete SPIRV blobs, so skip
+            // them after compile errors (but not after --perf-lint warnings)
+            bool compile_errors = false;
+            for (const ErrMsg& err: spirv[i].errors) {
+                if (err.type == ErrMsg::ERROR) {
+                    compile_errors = true;
+                }
+            }
+            if (!compile_errors) {
+                spirv[i].check_cost_budgets(inp, args.max_cost);
+                spirv[i].check_compute_limits(inp, slang, args.cs_limits, args.warn_occupancy && first_slang);
+            }
+            first_slang = false;
             if (args.debug_dump) {
                 spirv[i].dump_debug(inp, args.error_format);
             }
@@ -75,7 +99,10 @@ int main(int argc, const char** argv) {
                 }
             }
             if (slang == Slang::GLSL450) {
-                spirv[i].extract_glsl_spv(inp, spv_vs, spv_fs);
+                if (!spirv[i].extract_glsl_spv(inp, spv_vs, spv_fs)) {
+                    spirv[i].errors.back().print(args.error_format);
+                    return 10;
+                }
             }
         }
     }
@@ -85,7 +112,7 @@ int main(int argc, const char** argv) {
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (args.slang & Slang::bit(slang)) {
-            spirvcross[i] = Spirvcross::translate(inp, spirv[i], slang);
+            spirvcross[i] = Spirvcross::translate(inp, spirv[i], slang, cache);
             if (args.debug_dump) {
                 spirvcross[i].dump_debug(args.error_format, slang);
             }
@@ -102,7 +129,7 @@ int main(int argc, const char** argv) {
         Slang::Enum slang = Slang::from_index(i);
         if (args.byte_code || Slang::is_spirv(slang)) {
             if (args.slang & Slang::bit(slang)) {
-                bytecode[i] = Bytecode::compile(args, inp, spirvcross[i], slang);
+                bytecode[i] = Bytecode::compile(args, inp, spirvcross[i], slang, cache);
                 if (args.debug_dump) {
                     bytecode[i].dump_debug();
                 }
@@ -122,6 +149,17 @@ int main(int argc, const char** argv) {
         }
     }
 
+    // minify generated shader source code (after bytecode compilation so that
+    // compiler errors still map to readable source)
+    if (args.minify) {
+        for (int i = 0; i < Slang::Num; i++) {
+            Slang::Enum slang = Slang::from_index(i);
+            if ((args.slang & Slang::bit(slang)) && !Slang::is_spirv(slang)) {
+                Minifier::minify(spirvcross[i], slang);
+            }
+        }
+    }
+
     // build merged Reflection info
     const Reflection refl = Reflection::build(args, inp, spirvcross);
     if (refl.error.valid()) {
@@ -131,15 +169,28 @@ int main(int argc, const char** argv) {
     if (args.debug_dump) {
         refl.dump_debug(args.error_format);
     }
+    if (args.layout_report) {
+        Layout::print_report(refl);
+    }
 
     // generate output files
     const GenInput gen_input(args, inp, spirvcross, bytecode, refl, spv_vs, spv_fs);
-    ErrMsg gen_error = generate(args.output_format, gen_input);
+    std::vector<std::string> blob_file_paths;
+    ErrMsg gen_error = generate(args.output_format, gen_input, blob_file_paths);
     if (gen_error.valid()) {
         gen_error.print(args.error_format);
         return 10;
     }
 
+    // output source file dependencies (after code generation, which knows the --embed-files outputs)
+    if (!args.dependency_file.empty()) {
+        const ErrMsg err = util::write_dep_file(args, inp, blob_file_paths);
+        if (err.valid()) {
+            err.print(args.error_format);
+            return 10;
+        }
+    }
+
     // success
     Spirv::finalize_spirv_tools();
     return 0;
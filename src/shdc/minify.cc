@@ -0,0 +1,484 @@
+/*
+    Token-aware minification of the generated shader source code (GLSL,
+    HLSL, MSL and WGSL). Removes comments and all whitespace which isn't
+    needed to separate tokens, and renames local variables declared inside
+    function bodies to short names. Global names (entry points, uniform
+    blocks, textures, samplers, vertex attributes, varyings...) are never
+    renamed since the 3D APIs may look them up by name.
+*/
+#include "minify.h"
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace shdc {
+
+using namespace refl;
+
+namespace {
+
+struct Token {
+    enum Type {
+        IDENT,
+        NUMBER,
+        STRING,
+        PUNCT,
+        PREPROC,
+    };
+    Type type = PUNCT;
+    std::string_view text;
+    bool space_before = false;  // true if the token was preceded by whitespace or a comment
+
+    bool is_word() const { return (type == IDENT) || (type == NUMBER) || (type == STRING); }
+    bool is(char c) const { return (type == PUNCT) && (text[0] == c); }
+    bool is(std::string_view str) const { return (type == IDENT) && (text == str); }
+};
+
+using Scope = std::unordered_map<std::string_view, std::string>;
+
+// a for statement, which has its own scope for the variables declared in the
+// init statement, the scope ends with the loop body
+struct ForStmt {
+    int depth = 0;              // curly brace nesting depth of the for statement
+    int paren_depth = 0;        // parentheses nesting depth of the for statement
+    bool header = true;         // true while inside the parentheses after 'for'
+    bool braced = false;        // the loop body is a block
+    bool is_do = false;         // the loop body is an unbraced do-while statement
+    bool seen_while = false;    // is_do: the 'while' of the do-while statement was seen
+};
+
+} // anonymous namespace
+
+static bool is_ident_start(char c) {
+    return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '_');
+}
+
+static bool is_digit(char c) {
+    return (c >= '0') && (c <= '9');
+}
+
+static bool is_ident_char(char c) {
+    return is_ident_start(c) || is_digit(c);
+}
+
+static std::vector<Token> tokenize(std::string_view src) {
+    std::vector<Token> tokens;
+    const size_t len = src.length();
+    size_t pos = 0;
+    bool space_before = false;
+    bool at_line_start = true;
+    while (pos < len) {
+        const char c = src[pos];
+        const char next_c = ((pos + 1) < len) ? src[pos + 1] : 0;
+        if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\v') || (c == '\f')) {
+            if (c == '\n') {
+                at_line_start = true;
+            }
+            space_before = true;
+            pos++;
+            continue;
+        }
+        if ((c == '/') && (next_c == '/')) {
+            while ((pos < len) && (src[pos] != '\n')) {
+                pos++;
+            }
+            space_before = true;
+            continue;
+        }
+        if ((c == '/') && (next_c == '*')) {
+            const size_t end = src.find("*/", pos + 2);
+            pos = (end == std::string_view::npos) ? len : end + 2;
+            space_before = true;
+            continue;
+        }
+        Token tok;
+        tok.space_before = space_before;
+        const size_t start = pos;
+        if ((c == '#') && at_line_start) {
+            // preprocessor directives are passed through verbatim (including line continuations)
+            tok.type = Token::PREPROC;
+            while ((pos < len) && (src[pos] != '\n')) {
+                if ((src[pos] == '\\') && ((pos + 1) < len) && (src[pos + 1] == '\n')) {
+                    pos++;
+                }
+                pos++;
+            }
+            size_t end = pos;
+            while ((end > start) && ((src[end - 1] == ' ') || (src[end - 1] == '\t') || (src[end - 1] == '\r'))) {
+                end--;
+            }
+            tok.text = src.substr(start, end - start);
+        } else if (is_ident_start(c)) {
+            tok.type = Token::IDENT;
+            while ((pos < len) && is_ident_char(src[pos])) {
+                pos++;
+            }
+            tok.text = src.substr(start, pos - start);
+        } else if (is_digit(c) || ((c == '.') && is_digit(next_c))) {
+            tok.type = Token::NUMBER;
+            const bool is_hex = (c == '0') && ((next_c == 'x') || (next_c == 'X'));
+            while (pos < len) {
+                const char nc = src[pos];
+                if (is_ident_char(nc) || (nc == '.')) {
+                    pos++;
+                } else if (((nc == '+') || (nc == '-')) && (pos > start)) {
+                    // exponent sign
+                    const char pc = src[pos - 1];
+                    if ((!is_hex && ((pc == 'e') || (pc == 'E'))) || (is_hex && ((pc == 'p') || (pc == 'P')))) {
+                        pos++;
+                    } else {
+                        break;
+                    }
+                } else {
+                    break;
+                }
+            }
+            tok.text = src.substr(start, pos - start);
+        } else if (c == '"') {
+            tok.type = Token::STRING;
+            pos++;
+            while ((pos < len) && (src[pos] != '"') && (src[pos] != '\n')) {
+                if ((src[pos] == '\\') && ((pos + 1) < len)) {
+                    pos++;
+                }
+                pos++;
+            }
+            if (pos < len) {
+                pos++;
+            }
+            tok.text = src.substr(start, pos - start);
+        } else {
+            tok.type = Token::PUNCT;
+            pos++;
+            tok.text = src.substr(start, 1);
+        }
+        tokens.push_back(tok);
+        space_before = false;
+        at_line_start = false;
+    }
+    return tokens;
+}
+
+// true if two punctuation characters would form a different token when written without space
+static bool punct_merges(char c0, char c1) {
+    static const char* pairs[] = {
+        "++", "--", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "==", "!=", "<=", ">=",
+        "&&", "||", "<<", ">>", "->", "::", "//", "/*", "*/", "[[", "]]", "##",
+    };
+    for (const char* pair: pairs) {
+        if ((pair[0] == c0) && (pair[1] == c1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// statements which may precede a local variable name but never are a type name
+static bool is_non_type_keyword(std::string_view str) {
+    static const char* keywords[] = {
+        "return", "else", "case", "default", "goto", "break", "continue", "discard", "do",
+        "throw", "new", "delete", "sizeof", "typedef", "using",
+    };
+    for (const char* kw: keywords) {
+        if (str == kw) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// statements at global scope which open a block that isn't a function body
+static bool is_non_function_keyword(std::string_view str) {
+    static const char* keywords[] = {
+        "struct", "cbuffer", "tbuffer", "layout", "uniform", "buffer", "namespace", "enum", "class", "union",
+    };
+    for (const char* kw: keywords) {
+        if (str == kw) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// generate a new short name which doesn't collide with any identifier in the source
+static std::string next_short_name(int& inout_counter, const std::unordered_set<std::string_view>& used_names) {
+    static const char* chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const int num_chars = 52;
+    while (true) {
+        std::string name = "_";
+        int n = inout_counter++;
+        do {
+            name += chars[n % num_chars];
+            n = (n / num_chars) - 1;
+        } while (n >= 0);
+        if (used_names.count(name) == 0) {
+            return name;
+        }
+    }
+}
+
+// check if the identifier token at index is the name in a local variable declaration
+static bool is_local_decl(const std::vector<Token>& tokens, size_t index, Slang::Enum slang) {
+    if ((index < 1) || ((index + 1) >= tokens.size())) {
+        return false;
+    }
+    const Token& prev = tokens[index - 1];
+    if (Slang::is_wgsl(slang)) {
+        // let x, var x, const x or var<...> x
+        if (prev.is("let") || prev.is("var") || prev.is("const")) {
+            return true;
+        }
+        if (prev.is('>') && (index >= 4)) {
+            // only var<ident> x or var<ident, ident> x, a '>' may also be a comparison
+            size_t i = index - 2;
+            while ((i >= 4) && (tokens[i].type == Token::IDENT) && tokens[i - 1].is(',')) {
+                i -= 2;
+            }
+            return (i >= 2) && (tokens[i].type == Token::IDENT) && tokens[i - 1].is('<') && tokens[i - 2].is("var");
+        }
+        return false;
+    } else {
+        // [type] x = ..., [type] x; or [type] x[...]
+        const Token& next = tokens[index + 1];
+        if ((prev.type != Token::IDENT) || is_non_type_keyword(prev.text)) {
+            return false;
+        }
+        if ((index >= 2) && tokens[index - 2].is('.')) {
+            return false;
+        }
+        return next.is('=') || next.is(';') || next.is('[');
+    }
+}
+
+std::string Minifier::minify_source(const std::string& src, Slang::Enum slang, const std::unordered_set<std::string>& protected_names) {
+    const std::vector<Token> tokens = tokenize(src);
+    std::unordered_set<std::string_view> used_names;
+    for (const Token& tok: tokens) {
+        if (tok.type == Token::IDENT) {
+            used_names.insert(tok.text);
+        } else if (tok.type == Token::PREPROC) {
+            // conservatively treat every word in a preprocessor directive as used name
+            for (const Token& pp_tok: tokenize(tok.text.substr(1))) {
+                if (pp_tok.type == Token::IDENT) {
+                    used_names.insert(pp_tok.text);
+                }
+            }
+        }
+    }
+
+    std::string out;
+    out.reserve(src.length());
+    size_t line_start = 0;
+    const Token* prev = nullptr;
+
+    // scope tracking for renaming local variables
+    int depth = 0;                      // curly brace nesting depth
+    int paren_depth = 0;                // parentheses nesting depth
+    bool in_function = false;           // true while inside a function body
+    bool stmt_paren_seen = false;       // true if a global-scope statement contains a '('
+    bool stmt_non_function = false;     // true if a global-scope statement can't start a function
+    std::vector<Scope> scopes;
+    std::vector<ForStmt> for_stmts;     // the for statements whose scopes are open
+    int name_counter = 0;
+
+    // close the scopes of the for statements which end with the token at index
+    const auto end_for_stmts = [&](size_t index) {
+        const bool next_is_else = ((index + 1) < tokens.size()) && tokens[index + 1].is("else");
+        while (!for_stmts.empty()) {
+            const ForStmt& stmt = for_stmts.back();
+            if (stmt.header || (stmt.depth != depth) || (paren_depth != stmt.paren_depth)) {
+                break;
+            }
+            bool ends = false;
+            if (tokens[index].is('}')) {
+                ends = stmt.braced || (!stmt.is_do && !next_is_else);
+            } else if (tokens[index].is(';')) {
+                ends = !stmt.braced && (!stmt.is_do || stmt.seen_while) && !next_is_else;
+            }
+            if (!ends) {
+                break;
+            }
+            scopes.pop_back();
+            for_stmts.pop_back();
+        }
+    };
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const Token& tok = tokens[i];
+        if (tok.type == Token::PREPROC) {
+            if (!out.empty() && (out.back() != '\n')) {
+                out += '\n';
+            }
+            out.append(tok.text);
+            out += '\n';
+            line_start = out.length();
+            prev = nullptr;
+            continue;
+        }
+
+        // update scope state
+        if (tok.type == Token::PUNCT) {
+            switch (tok.text[0]) {
+                case '{':
+                    if ((depth == 0) && (paren_depth == 0) && stmt_paren_seen && !stmt_non_function) {
+                        in_function = true;
+                    }
+                    if (in_function) {
+                        scopes.push_back({});
+                    }
+                    depth++;
+                    break;
+                case '}':
+                    depth--;
+                    if (in_function) {
+                        scopes.pop_back();
+                        end_for_stmts(i);
+                        if (depth == 0) {
+                            in_function = false;
+                        }
+                    }
+                    if (depth == 0) {
+                        stmt_paren_seen = stmt_non_function = false;
+                    }
+                    break;
+                case '(':
+                    if ((depth == 0) && (paren_depth == 0)) {
+                        stmt_paren_seen = true;
+                    }
+                    paren_depth++;
+                    break;
+                case ')':
+                    paren_depth--;
+                    if (!for_stmts.empty() && for_stmts.back().header && (paren_depth == for_stmts.back().paren_depth)) {
+                        for_stmts.back().header = false;
+                        for_stmts.back().braced = ((i + 1) < tokens.size()) && tokens[i + 1].is('{');
+                        for_stmts.back().is_do = ((i + 1) < tokens.size()) && tokens[i + 1].is("do");
+                    }
+                    break;
+                case ';':
+                    if (depth == 0) {
+                        stmt_paren_seen = stmt_non_function = false;
+                    }
+                    if (in_function) {
+                        end_for_stmts(i);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // rename local variables
+        std::string_view text = tok.text;
+        if (tok.type == Token::IDENT) {
+            if ((depth == 0) && !stmt_paren_seen && is_non_function_keyword(tok.text)) {
+                stmt_non_function = true;
+            }
+            const bool is_member = (i >= 1) && (tokens[i - 1].is('.') || (tokens[i - 1].is(':') && (i >= 2) && tokens[i - 2].is(':')));
+            if (in_function && tok.is("for") && ((i + 1) < tokens.size()) && tokens[i + 1].is('(')) {
+                ForStmt stmt;
+                stmt.depth = depth;
+                stmt.paren_depth = paren_depth;
+                for_stmts.push_back(stmt);
+                scopes.push_back({});
+            } else if (in_function && tok.is("while") && !for_stmts.empty()) {
+                ForStmt& stmt = for_stmts.back();
+                if (stmt.is_do && (stmt.depth == depth) && (stmt.paren_depth == paren_depth)) {
+                    stmt.seen_while = true;
+                }
+            }
+            // local declarations in function bodies and in the init statement of for loops
+            const bool in_for_init = !for_stmts.empty() && for_stmts.back().header && (paren_depth == (for_stmts.back().paren_depth + 1));
+            if (in_function && ((paren_depth == 0) || in_for_init) && !is_member && is_local_decl(tokens, i, slang)) {
+                std::string name(tok.text);
+                if ((protected_names.count(name) == 0) && (name.compare(0, 3, "gl_") != 0)) {
+                    name = next_short_name(name_counter, used_names);
+                }
+                scopes.back()[tok.text] = name;
+                text = scopes.back()[tok.text];
+            } else if (!is_member) {
+                for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+                    auto found = it->find(tok.text);
+                    if (found != it->end()) {
+                        text = found->second;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // only emit whitespace where needed to separate tokens
+        if (prev) {
+            bool need_space = false;
+            if (prev->is_word() && tok.is_word()) {
+                need_space = true;
+            } else if (tok.space_before && (prev->type == Token::PUNCT) && (tok.type == Token::PUNCT)) {
+                need_space = punct_merges(prev->text[0], tok.text[0]);
+            } else if (tok.space_before && (prev->type == Token::NUMBER) && tok.is('.')) {
+                need_space = true;
+            }
+            // keep lines at a reasonable length for drivers with line length limits
+            if (((out.length() - line_start) > 512) && (prev->is(';') || prev->is('{') || prev->is('}'))) {
+                out += '\n';
+                line_start = out.length();
+            } else if (need_space) {
+                out += ' ';
+            }
+        }
+        out.append(text);
+        prev = &tok;
+    }
+    if (!out.empty() && (out.back() != '\n')) {
+        out += '\n';
+    }
+    return out;
+}
+
+static void add_protected_names(const StageReflection& refl, Slang::Enum slang, std::unordered_set<std::string>& out_names) {
+    out_names.insert(refl.entry_point);
+    out_names.insert(refl.entry_point_by_slang(slang));
+    for (const StageAttr& attr: refl.inputs) {
+        if (attr.slot >= 0) {
+            out_names.insert(attr.name);
+            out_names.insert(attr.sem_name);
+        }
+    }
+    for (const StageAttr& attr: refl.outputs) {
+        if (attr.slot >= 0) {
+            out_names.insert(attr.name);
+            out_names.insert(attr.sem_name);
+        }
+    }
+    for (const UniformBlock& ub: refl.bindings.uniform_blocks) {
+        out_names.insert(ub.name);
+        out_names.insert(ub.inst_name);
+    }
+    for (const StorageBuffer& sbuf: refl.bindings.storage_buffers) {
+        out_names.insert(sbuf.name);
+        out_names.insert(sbuf.inst_name);
+    }
+    for (const StorageImage& simg: refl.bindings.storage_images) {
+        out_names.insert(simg.name);
+    }
+    for (const Texture& tex: refl.bindings.textures) {
+        out_names.insert(tex.name);
+    }
+    for (const Sampler& smp: refl.bindings.samplers) {
+        out_names.insert(smp.name);
+    }
+    for (const TextureSampler& tex_smp: refl.bindings.texture_samplers) {
+        out_names.insert(tex_smp.name);
+        out_names.insert(tex_smp.texture_name);
+        out_names.insert(tex_smp.sampler_name);
+    }
+}
+
+void Minifier::minify(Spirvcross& inout_spirvcross, Slang::Enum slang) {
+    for (SpirvcrossSource& src: inout_spirvcross.sources) {
+        std::unordered_set<std::string> protected_names;
+        add_protected_names(src.stage_refl, slang, protected_names);
+        src.source_code = minify_source(src.source_code, slang, protected_names);
+    }
+}
+
+} // namespace shdc
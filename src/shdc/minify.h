@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+#include "spirvcross.h"
+#include "types/slang.h"
+
+namespace shdc {
+
+// token-aware minification of SPIRVCross and Tint generated shader source code
+struct Minifier {
+    static void minify(Spirvcross& inout_spirvcross, Slang::Enum slang);
+    static std::string minify_source(const std::string& src, Slang::Enum slang, const std::unordered_set<std::string>& protected_names);
+};
+
+} // namespace shdc
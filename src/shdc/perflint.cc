@@ -0,0 +1,328 @@
+/*
+    Performance lint pass over the glslang intermediate tree of a shader
+    snippet, warns about common GPU performance pitfalls.
+*/
+#include <set>
+#include "perflint.h"
+#include "fmt/format.h"
+#include "glslang/Include/intermediate.h"
+#include "glslang/MachineIndependent/localintermediate.h"
+
+namespace shdc {
+
+using namespace glslang;
+
+// operations with implicit derivatives, these are undefined in non-uniform control flow
+static bool is_implicit_derivative_op(TOperator op) {
+    switch (op) {
+        case EOpTexture:
+        case EOpTextureProj:
+        case EOpTextureOffset:
+        case EOpTextureProjOffset:
+        case EOpSparseTexture:
+        case EOpSparseTextureOffset:
+        case EOpDPdx:
+        case EOpDPdy:
+        case EOpFwidth:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// divisions and transcendental functions which are expensive inside loops
+static const char* expensive_op_name(TOperator op) {
+    switch (op) {
+        case EOpDiv:
+        case EOpDivAssign:
+            return "division";
+        case EOpPow: return "pow()";
+        case EOpExp: return "exp()";
+        case EOpLog: return "log()";
+        case EOpExp2: return "exp2()";
+        case EOpLog2: return "log2()";
+        case EOpSin: return "sin()";
+        case EOpCos: return "cos()";
+        case EOpTan: return "tan()";
+        case EOpAsin: return "asin()";
+        case EOpAcos: return "acos()";
+        case EOpAtan: return "atan()";
+        case EOpSinh: return "sinh()";
+        case EOpCosh: return "cosh()";
+        case EOpTanh: return "tanh()";
+        case EOpAsinh: return "asinh()";
+        case EOpAcosh: return "acosh()";
+        case EOpAtanh: return "atanh()";
+        default: return nullptr;
+    }
+}
+
+static bool is_index_op(TOperator op) {
+    return (op == EOpIndexDirect) || (op == EOpIndexIndirect) || (op == EOpIndexDirectStruct);
+}
+
+static bool is_comparison_op(TOperator op) {
+    switch (op) {
+        case EOpLessThan:
+        case EOpGreaterThan:
+        case EOpLessThanEqual:
+        case EOpGreaterThanEqual:
+        case EOpNotEqual:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// the variable at the root of an index/member dereference chain
+static const TIntermSymbol* root_symbol(TIntermTyped* node) {
+    while (node) {
+        if (const TIntermSymbol* sym = node->getAsSymbolNode()) {
+            return sym;
+        }
+        const TIntermBinary* bin = node->getAsBinaryNode();
+        if (!bin || !is_index_op(bin->getOp())) {
+            return nullptr;
+        }
+        node = bin->getLeft();
+    }
+    return nullptr;
+}
+
+// a readable name for the array in an index expression (struct member or variable name)
+static std::string array_name(TIntermTyped* node) {
+    if (const TIntermSymbol* sym = node->getAsSymbolNode()) {
+        return sym->getName().c_str();
+    }
+    const TIntermBinary* bin = node->getAsBinaryNode();
+    if (bin && (bin->getOp() == EOpIndexDirectStruct) && bin->getLeft()->getType().isStruct() && bin->getRight()->getAsConstantUnion()) {
+        const TTypeList* members = bin->getLeft()->getType().getStruct();
+        const int member_index = bin->getRight()->getAsConstantUnion()->getConstArray()[0].getIConst();
+        if ((member_index >= 0) && (member_index < (int)members->size())) {
+            return (*members)[member_index].type->getFieldName().c_str();
+        }
+    }
+    if (bin) {
+        return array_name(bin->getLeft());
+    }
+    return "(unknown)";
+}
+
+// true if an expression only depends on constants and uniforms
+static bool is_uniform_expr(TIntermNode* node) {
+    if (!node) {
+        return true;
+    }
+    if (node->getAsConstantUnion()) {
+        return true;
+    }
+    if (TIntermSymbol* sym = node->getAsSymbolNode()) {
+        const TStorageQualifier storage = sym->getQualifier().storage;
+        return (storage == EvqConst) || (storage == EvqUniform);
+    }
+    if (TIntermBinary* bin = node->getAsBinaryNode()) {
+        return is_uniform_expr(bin->getLeft()) && is_uniform_expr(bin->getRight());
+    }
+    if (TIntermUnary* un = node->getAsUnaryNode()) {
+        return is_uniform_expr(un->getOperand());
+    }
+    if (TIntermSelection* sel = node->getAsSelectionNode()) {
+        return is_uniform_expr(sel->getCondition()) && is_uniform_expr(sel->getTrueBlock()) && is_uniform_expr(sel->getFalseBlock());
+    }
+    if (TIntermAggregate* agg = node->getAsAggregate()) {
+        if ((agg->getOp() == EOpFunctionCall) || agg->isTexture() || agg->isImage()) {
+            return false;
+        }
+        for (TIntermNode* child: agg->getSequence()) {
+            if (!is_uniform_expr(child)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+class PerfLintTraverser: public TIntermTraverser {
+public:
+    PerfLintTraverser(const Input& inp, int snippet_index, bool is_fragment_shader, std::vector<ErrMsg>& out_warnings):
+        TIntermTraverser(true, false, true),
+        inp(inp),
+        snippet_index(snippet_index),
+        is_fragment_shader(is_fragment_shader),
+        out_warnings(out_warnings)
+    { };
+
+    bool visitBinary(TVisit visit, TIntermBinary* node) override;
+    bool visitUnary(TVisit visit, TIntermUnary* node) override;
+    bool visitAggregate(TVisit visit, TIntermAggregate* node) override;
+    bool visitSelection(TVisit visit, TIntermSelection* node) override;
+    bool visitSwitch(TVisit visit, TIntermSwitch* node) override;
+    bool visitLoop(TVisit visit, TIntermLoop* node) override;
+
+private:
+    enum TripCount {
+        TripCountConstant,  // loop counter compared against a constant
+        TripCountUniform,   // loop counter compared against a uniform expression
+        TripCountUnknown,
+    };
+    void warn(const TSourceLoc& loc, const std::string& msg);
+    void check_op(const TSourceLoc& loc, TOperator op);
+    static TripCount loop_trip_count(TIntermLoop* loop);
+
+    const Input& inp;
+    int snippet_index;
+    bool is_fragment_shader;
+    std::vector<ErrMsg>& out_warnings;
+    int loop_depth = 0;
+    int nonuniform_depth = 0;
+    std::vector<bool> nonuniform_stack;
+    std::set<std::pair<int, std::string>> reported;
+};
+
+void PerfLintTraverser::warn(const TSourceLoc& loc, const std::string& msg) {
+    // source lines are passed to glslang as one string per snippet line
+    // after a leading '#version' string (see compile() in spirv.cc)
+    const Snippet& snippet = inp.snippets[snippet_index];
+    int snippet_line_index = loc.string - 1;
+    if ((snippet_line_index < 0) || (snippet_line_index >= (int)snippet.lines.size())) {
+        snippet_line_index = 0;
+    }
+    const int line_index = snippet.lines.empty() ? 0 : snippet.lines[snippet_line_index];
+    // only report each issue once per line
+    if (reported.insert({ line_index, msg }).second) {
+        out_warnings.push_back(inp.warning(line_index, fmt::format("perf: {}", msg)));
+    }
+}
+
+void PerfLintTraverser::check_op(const TSourceLoc& loc, TOperator op) {
+    if (loop_depth > 0) {
+        const char* name = expensive_op_name(op);
+        if (name) {
+            warn(loc, fmt::format("{} inside loop, consider moving it out of the loop or using a cheaper approximation", name));
+        }
+    }
+    if (is_fragment_shader && (nonuniform_depth > 0) && is_implicit_derivative_op(op)) {
+        warn(loc, "texture sample or derivative with implicit LOD inside non-uniform control flow, use textureLod()/textureGrad() or move it out of the branch");
+    }
+}
+
+bool PerfLintTraverser::visitBinary(TVisit visit, TIntermBinary* node) {
+    if (visit != EvPreVisit) {
+        return true;
+    }
+    // divisions by a constant are turned into multiplications by the compiler
+    const bool is_div = (node->getOp() == EOpDiv) || (node->getOp() == EOpDivAssign);
+    if (!(is_div && node->getRight()->getAsConstantUnion())) {
+        check_op(node->getLoc(), node->getOp());
+    }
+    if (node->getOp() == EOpIndexIndirect) {
+        const TIntermSymbol* sym = root_symbol(node->getLeft());
+        if (sym) {
+            const TStorageQualifier storage = sym->getQualifier().storage;
+            if (storage == EvqUniform) {
+                warn(node->getLoc(), fmt::format("dynamic indexing into uniform array '{}'", array_name(node->getLeft())));
+            } else if ((storage == EvqTemporary) || (storage == EvqGlobal)) {
+                const int num_bytes = node->getLeft()->getType().computeNumComponents() * 4;
+                if (num_bytes > PerfLint::MaxPrivateArraySize) {
+                    warn(node->getLoc(), fmt::format("dynamic indexing into private array '{}' ({} bytes) will likely spill to scratch memory", array_name(node->getLeft()), num_bytes));
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool PerfLintTraverser::visitUnary(TVisit visit, TIntermUnary* node) {
+    if (visit == EvPreVisit) {
+        check_op(node->getLoc(), node->getOp());
+    }
+    return true;
+}
+
+bool PerfLintTraverser::visitAggregate(TVisit visit, TIntermAggregate* node) {
+    if (visit == EvPreVisit) {
+        check_op(node->getLoc(), node->getOp());
+    }
+    return true;
+}
+
+bool PerfLintTraverser::visitSelection(TVisit visit, TIntermSelection* node) {
+    if (visit == EvPreVisit) {
+        const bool nonuniform = !is_uniform_expr(node->getCondition());
+        nonuniform_stack.push_back(nonuniform);
+        nonuniform_depth += nonuniform ? 1 : 0;
+    } else if (visit == EvPostVisit) {
+        nonuniform_depth -= nonuniform_stack.back() ? 1 : 0;
+        nonuniform_stack.pop_back();
+    }
+    return true;
+}
+
+bool PerfLintTraverser::visitSwitch(TVisit visit, TIntermSwitch* node) {
+    if (visit == EvPreVisit) {
+        const bool nonuniform = !is_uniform_expr(node->getCondition());
+        nonuniform_stack.push_back(nonuniform);
+        nonuniform_depth += nonuniform ? 1 : 0;
+    } else if (visit == EvPostVisit) {
+        nonuniform_depth -= nonuniform_stack.back() ? 1 : 0;
+        nonuniform_stack.pop_back();
+    }
+    return true;
+}
+
+PerfLintTraverser::TripCount PerfLintTraverser::loop_trip_count(TIntermLoop* loop) {
+    // only recognize the canonical 'for (counter = ...; counter [cmp] bound; counter++)' form
+    if (!loop->getTest() || !loop->getTerminal()) {
+        return TripCountUnknown;
+    }
+    const TIntermBinary* test = loop->getTest()->getAsBinaryNode();
+    if (!test || !is_comparison_op(test->getOp())) {
+        return TripCountUnknown;
+    }
+    TIntermTyped* bound = nullptr;
+    if (test->getLeft()->getAsSymbolNode()) {
+        bound = test->getRight();
+    } else if (test->getRight()->getAsSymbolNode()) {
+        bound = test->getLeft();
+    }
+    if (!bound) {
+        return TripCountUnknown;
+    }
+    if (bound->getAsConstantUnion()) {
+        return TripCountConstant;
+    }
+    if (is_uniform_expr(bound)) {
+        return TripCountUniform;
+    }
+    return TripCountUnknown;
+}
+
+bool PerfLintTraverser::visitLoop(TVisit visit, TIntermLoop* node) {
+    if (visit == EvPreVisit) {
+        const TripCount trip_count = loop_trip_count(node);
+        if (trip_count != TripCountConstant) {
+            warn(node->getLoc(), "loop with unknown trip count can't be unrolled");
+        }
+        const bool nonuniform = (trip_count == TripCountUnknown);
+        nonuniform_stack.push_back(nonuniform);
+        nonuniform_depth += nonuniform ? 1 : 0;
+        loop_depth++;
+    } else if (visit == EvPostVisit) {
+        loop_depth--;
+        nonuniform_depth -= nonuniform_stack.back() ? 1 : 0;
+        nonuniform_stack.pop_back();
+    }
+    return true;
+}
+
+void PerfLint::lint(const Input& inp, int snippet_index, bool is_fragment_shader, const TIntermediate* im, std::vector<ErrMsg>& out_warnings) {
+    TIntermNode* root = im->getTreeRoot();
+    if (!root) {
+        return;
+    }
+    PerfLintTraverser traverser(inp, snippet_index, is_fragment_shader, out_warnings);
+    root->traverse(&traverser);
+}
+
+} // namespace shdc
@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+#include "input.h"
+#include "types/errmsg.h"
+
+namespace glslang {
+class TIntermediate;
+}
+
+namespace shdc {
+
+// static analysis of a compiled shader snippet for common GPU performance pitfalls
+struct PerfLint {
+    // private arrays bigger than this (in bytes) which are dynamically indexed will likely spill to scratch memory
+    static const int MaxPrivateArraySize = 64;
+
+    static void lint(const Input& inp, int snippet_index, bool is_fragment_shader, const glslang::TIntermediate* im, std::vector<ErrMsg>& out_warnings);
+};
+
+} // namespace shdc
@@ -124,6 +124,15 @@ Reflection Reflection::build(const Args& args, const Input& inp, const std::arra
             res.error = inp.error(prog.line_index, err.msg);
             return res;
         }
+        if (prog.has_vs_fs()) {
+            prog_refl.spec_constants = merge_spec_constants({ vs_src->stage_refl, fs_src->stage_refl }, err);
+        } else {
+            prog_refl.spec_constants = merge_spec_constants({ cs_src->stage_refl }, err);
+        }
+        if (err.valid()) {
+            res.error = inp.error(prog.line_index, err.msg);
+            return res;
+        }
         prog_bindings.push_back(prog_refl.bindings);
 
         // check that the outputs of the vertex stage match the input stage
@@ -332,6 +341,25 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
         }
         // uniform blocks always have 16 byte alignment
         refl_ub.struct_info.align = 16;
+        // find the members which are actually referenced by the shader code
+        // (via access chains), and the byte range covering those members
+        for (Type& item: refl_ub.struct_info.struct_items) {
+            item.used = false;
+        }
+        int used_end = 0;
+        refl_ub.used_offset = refl_ub.struct_info.size;
+        for (const BufferRange& range: compiler.get_active_buffer_ranges(ub_res.id)) {
+            if (range.index < refl_ub.struct_info.struct_items.size()) {
+                refl_ub.struct_info.struct_items[range.index].used = true;
+                refl_ub.used_offset = std::min(refl_ub.used_offset, (int)range.offset);
+                used_end = std::max(used_end, (int)(range.offset + range.range));
+            }
+        }
+        if (used_end > 0) {
+            refl_ub.used_size = used_end - refl_ub.used_offset;
+        } else {
+            refl_ub.used_offset = 0;
+        }
         refl.bindings.uniform_blocks.push_back(refl_ub);
     }
     // storage buffers
@@ -480,9 +508,73 @@ StageReflection Reflection::parse_snippet_reflection(const Compiler& compiler, c
             smp.type = tag->type;
         }
     }
+    // specialization constants (unnamed specialization constants are
+    // created for the workgroup size and are ignored here)
+    for (const SpecializationConstant& spec_const: compiler.get_specialization_constants()) {
+        SpecConstant refl_sc;
+        refl_sc.name = compiler.get_name(spec_const.id);
+        if (refl_sc.name.empty()) {
+            continue;
+        }
+        refl_sc.stage = refl.stage;
+        refl_sc.constant_id = (int)spec_const.constant_id;
+        const SPIRConstant& value = compiler.get_constant(spec_const.id);
+        const SPIRType& type = compiler.get_type(value.constant_type);
+        if ((type.vecsize == 1) && (type.columns == 1)) {
+            switch (type.basetype) {
+                case SPIRType::Boolean:
+                    refl_sc.type = Type::Bool;
+                    refl_sc.default_value = (value.scalar() != 0) ? "true" : "false";
+                    break;
+                case SPIRType::Int:
+                    refl_sc.type = Type::Int;
+                    refl_sc.default_value = fmt::format("{}", value.scalar_i32());
+                    break;
+                case SPIRType::UInt:
+                    refl_sc.type = Type::UInt;
+                    refl_sc.default_value = fmt::format("{}", value.scalar());
+                    break;
+                case SPIRType::Float:
+                    refl_sc.type = Type::Float;
+                    refl_sc.default_value = fmt::format("{}", value.scalar_f32());
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (refl_sc.type == Type::Invalid) {
+            out_error = inp.error(0, fmt::format("specialization constant '{}' must be a bool, int, uint or float", refl_sc.name));
+            return refl;
+        }
+        refl.spec_constants.push_back(refl_sc);
+    }
     return refl;
 }
 
+std::vector<SpecConstant> Reflection::merge_spec_constants(const std::vector<StageReflection>& in_stages, ErrMsg& out_error) {
+    std::vector<SpecConstant> out_spec_constants;
+    out_error = ErrMsg();
+    for (const StageReflection& stage: in_stages) {
+        for (const SpecConstant& sc: stage.spec_constants) {
+            bool exists = false;
+            for (const SpecConstant& other_sc: out_spec_constants) {
+                if ((other_sc.name == sc.name) || (other_sc.constant_id == sc.constant_id)) {
+                    // the same specialization constant in another stage, make sure it's identical
+                    if (!sc.equals(other_sc)) {
+                        out_error = ErrMsg::error(fmt::format("conflicting specialization constant definitions found for '{}' (constant_id={})", sc.name, sc.constant_id));
+                        return std::vector<SpecConstant>();
+                    }
+                    exists = true;
+                }
+            }
+            if (!exists) {
+                out_spec_constants.push_back(sc);
+            }
+        }
+    }
+    return out_spec_constants;
+}
+
 Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, bool to_prog_bindings, ErrMsg& out_error) {
     Bindings out_bindings;
     out_error = ErrMsg();
@@ -497,6 +589,12 @@ Bindings Reflection::merge_bindings(const std::vector<Bindings>& in_bindings, bo
                     out_error = ErrMsg::error(fmt::format("conflicting uniform block definitions found for '{}'", ub.name));
                     return Bindings();
                 }
+                // ...and merge the used members
+                for (UniformBlock& out_ub: out_bindings.uniform_blocks) {
+                    if (out_ub.name == ub.name) {
+                        out_ub.merge_used(ub);
+                    }
+                }
             } else {
                 out_bindings.uniform_blocks.push_back(ub);
             }
@@ -30,6 +30,8 @@ struct Reflection {
 private:
     // create a set of unique resource bindings from shader snippet input bindings
     static Bindings merge_bindings(const std::vector<Bindings>& in_bindings, bool to_prog_bindings, ErrMsg& out_error);
+    // create a set of unique specialization constants across shader stages
+    static std::vector<SpecConstant> merge_spec_constants(const std::vector<StageReflection>& in_stages, ErrMsg& out_error);
     // create a set of unique storage buffer structs from merged bindings (result of merge_bindings())
     static std::vector<Type> merge_storagebuffer_structs(const Bindings& merged_bindings, ErrMsg& out_error);
     // parse a struct
@@ -3,13 +3,21 @@
 */
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
 #include "spirv.h"
+#include "perflint.h"
+#include "varyings.h"
 #include "fmt/format.h"
 #include "pystring.h"
 #include "glslang/Public/ShaderLang.h"
 #include "glslang/Public/ResourceLimits.h"
 #include "glslang/Include/Types.h"
 #include "SPIRV/GlslangToSpv.h"
+#include "spirv.hpp"
 #include "spirv-tools/libspirv.hpp"
 #include "spirv-tools/optimizer.hpp"
 #include "util.h"
@@ -29,38 +37,38 @@ void Spirv::finalize_spirv_tools() {
 // defined at end of file
 extern const TBuiltInResource DefaultTBuiltInResource;
 
-struct MergedSource {
-    std::string src;
-    int linenr_offset = 0;
-};
+// the '#version' statement must be the first source string, the SOKOL_*
+// and user defines are passed separately as preamble
+static const char* version_source = "#version 450\n";
 
-/* merge shader snippet source into a single string */
-static MergedSource merge_source(const Input& inp, const Snippet& snippet, Slang::Enum slang, const std::vector<std::string>& defines) {
-    MergedSource res;
-    res.linenr_offset += 1;
-    res.src = "#version 450\n";
+/* build the glslang preamble with defines, this is shared by all snippets */
+static std::string build_preamble(Slang::Enum slang, const std::vector<std::string>& defines) {
+    std::string res;
     if (Slang::is_glsl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_GLSL (1)\n";
+        res += "#define SOKOL_GLSL (1)\n";
     }
     if (Slang::is_hlsl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_HLSL (1)\n";
+        res += "#define SOKOL_HLSL (1)\n";
     }
     if (Slang::is_msl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_MSL (1)\n";
+        res += "#define SOKOL_MSL (1)\n";
     }
     if (Slang::is_wgsl(slang)) {
-        res.linenr_offset += 1;
-        res.src += "#define SOKOL_WGSL (1)\n";
+        res += "#define SOKOL_WGSL (1)\n";
     }
     for (const std::string& define : defines) {
-        res.linenr_offset += 1;
-        res.src += fmt::format("#define {} (1)\n", define);
+        res += fmt::format("#define {} (1)\n", define);
     }
-    for (int line_index : snippet.lines) {
-        res.src += fmt::format("{}\n", inp.lines[line_index].line);
+    return res;
+}
+
+/* reconstruct the source code a SPIRV blob was compiled from (only needed for debugging output) */
+static std::string blob_source(const Input& inp, const SpirvBlob& blob) {
+    std::string res = version_source;
+    res += blob.preamble;
+    for (int line_index : inp.snippets[blob.snippet_index].lines) {
+        res += inp.lines[line_index].line;
+        res += '\n';
     }
     return res;
 }
@@ -71,23 +79,9 @@ static MergedSource merge_source(const Input& inp, const Snippet& snippet, Slang
     bounded for-loops are converted to what looks like an unbounded loop
     ("for (;;) { }") to WebGL
 */
-static void spirv_optimize(Slang::Enum slang, std::vector<uint32_t>& spirv) {
-    if (slang == Slang::WGSL) {
-        return;
-    }
-    spv_target_env target_env;
-    target_env = SPV_ENV_UNIVERSAL_1_2;
-    spvtools::Optimizer optimizer(target_env);
-    optimizer.SetMessageConsumer(
-        [](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
-            // FIXME
-        });
-
+static void register_conservative_passes(spvtools::Optimizer& optimizer) {
+    optimizer.RegisterPass(spvtools::CreateFoldSpecConstantOpAndCompositePass());
     optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
-/*
-    optimizer.RegisterPass(spvtools::CreateMergeReturnPass());
-    optimizer.RegisterPass(spvtools::CreateInlineExhaustivePass());
-*/
     optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
     optimizer.RegisterPass(spvtools::CreateScalarReplacementPass());
     optimizer.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
@@ -112,32 +106,501 @@ static void spirv_optimize(Slang::Enum slang, std::vector<uint32_t>& spirv) {
     optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
     optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
     optimizer.RegisterPass(spvtools::CreateCFGCleanupPass());
+}
+
+/* like spvtools::Optimizer::RegisterSizePasses(), but preserving the shader
+    interface (vertex shader outputs must match fragment shader inputs) and
+    uniform block members (those must match the generated C structs)
+*/
+static void register_size_passes(spvtools::Optimizer& optimizer) {
+    optimizer.RegisterPass(spvtools::CreateFoldSpecConstantOpAndCompositePass());
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateMergeReturnPass());
+    optimizer.RegisterPass(spvtools::CreateInlineExhaustivePass());
+    optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
+    optimizer.RegisterPass(spvtools::CreatePrivateToLocalPass());
+    optimizer.RegisterPass(spvtools::CreateScalarReplacementPass(0));
+    optimizer.RegisterPass(spvtools::CreateLocalMultiStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateCCPPass());
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateScalarReplacementPass(0));
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateIfConversionPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateBlockMergePass());
+    optimizer.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateCopyPropagateArraysPass());
+    optimizer.RegisterPass(spvtools::CreateVectorDCEPass());
+    optimizer.RegisterPass(spvtools::CreateDeadInsertElimPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateBlockMergePass());
+    optimizer.RegisterPass(spvtools::CreateLocalMultiStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateCFGCleanupPass());
+}
+
+/* like spvtools::Optimizer::RegisterPerformancePasses(), but preserving the
+    shader interface and with full unrolling of loops with constant trip count
+*/
+static void register_performance_passes(spvtools::Optimizer& optimizer) {
+    optimizer.RegisterPass(spvtools::CreateFoldSpecConstantOpAndCompositePass());
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateMergeReturnPass());
+    optimizer.RegisterPass(spvtools::CreateInlineExhaustivePass());
+    optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreatePrivateToLocalPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateScalarReplacementPass());
+    optimizer.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateLocalMultiStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateCCPPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateLoopUnrollPass(true));
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
+    optimizer.RegisterPass(spvtools::CreateCombineAccessChainsPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateScalarReplacementPass());
+    optimizer.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateSSARewritePass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateVectorDCEPass());
+    optimizer.RegisterPass(spvtools::CreateDeadInsertElimPass());
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateIfConversionPass());
+    optimizer.RegisterPass(spvtools::CreateCopyPropagateArraysPass());
+    optimizer.RegisterPass(spvtools::CreateReduceLoadSizePass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateBlockMergePass());
+    optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
+    optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+    optimizer.RegisterPass(spvtools::CreateBlockMergePass());
+    optimizer.RegisterPass(spvtools::CreateSimplificationPass());
+    optimizer.RegisterPass(spvtools::CreateCFGCleanupPass());
+}
 
+// true if the target shader language is robust against the control flow
+// generated by inlining, block merging and LocalMultiStoreElim
+static bool supports_full_optimization(Slang::Enum slang) {
+    switch (slang) {
+        case Slang::HLSL5:
+        case Slang::METAL_MACOS:
+        case Slang::METAL_IOS:
+        case Slang::METAL_SIM:
+        case Slang::SPIRV_VK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* setting up an optimizer with its pass list isn't free, so this is only
+    done once per shader language and optimization level (and thread), and
+    the optimizer is reused for all SPIRV blobs
+*/
+static spvtools::Optimizer& get_optimizer(Slang::Enum slang, OptLevel::Enum opt_level) {
+    thread_local std::unique_ptr<spvtools::Optimizer> optimizers[Slang::Num][OptLevel::NUM];
+    std::unique_ptr<spvtools::Optimizer>& optimizer = optimizers[slang][opt_level];
+    if (!optimizer) {
+        spv_target_env target_env;
+        target_env = SPV_ENV_UNIVERSAL_1_2;
+        optimizer = std::make_unique<spvtools::Optimizer>(target_env);
+        optimizer->SetMessageConsumer(
+            [](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
+                // FIXME
+            });
+        if (supports_full_optimization(slang) && (opt_level == OptLevel::Os)) {
+            register_size_passes(*optimizer);
+        } else if (supports_full_optimization(slang) && (opt_level == OptLevel::O2)) {
+            register_performance_passes(*optimizer);
+        } else {
+            register_conservative_passes(*optimizer);
+        }
+    }
+    return *optimizer;
+}
+
+static void spirv_optimize(Slang::Enum slang, OptLevel::Enum opt_level, std::vector<uint32_t>& spirv) {
+    if ((opt_level == OptLevel::O0) || (slang == Slang::WGSL)) {
+        return;
+    }
     spvtools::OptimizerOptions spvOptOptions;
     spvOptOptions.set_run_validator(false); // The validator may run as a separate step later on
-    optimizer.Run(spirv.data(), spirv.size(), &spirv, spvOptOptions);
+    get_optimizer(slang, opt_level).Run(spirv.data(), spirv.size(), &spirv, spvOptOptions);
+}
+
+/* Varyings::optimize() rewrites the varyings of a shader into private variables,
+    this removes the code which only computed removed vertex shader outputs,
+    the passes run independently from the optimization level since
+    spirv_optimize() doesn't run any passes at -O0 and for WGSL
+*/
+static void spirv_cleanup_varyings(std::vector<uint32_t>& spirv) {
+    thread_local std::unique_ptr<spvtools::Optimizer> optimizer;
+    if (!optimizer) {
+        optimizer = std::make_unique<spvtools::Optimizer>(SPV_ENV_UNIVERSAL_1_2);
+        optimizer->SetMessageConsumer(
+            [](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
+                // FIXME
+            });
+        optimizer->RegisterPass(spvtools::CreatePrivateToLocalPass());
+        optimizer->RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+        optimizer->RegisterPass(spvtools::CreateDeadVariableEliminationPass());
+    }
+    spvtools::OptimizerOptions spvOptOptions;
+    spvOptOptions.set_run_validator(false);
+    optimizer->Run(spirv.data(), spirv.size(), &spirv, spvOptOptions);
+}
+
+/* after freeze_spec_constants(), spec constant ops and composites which depend on
+    the replaced constants are folded into regular constants, this also runs
+    independently from the optimization level, so that SPIRV-Cross and Tint
+    never see spec constant ops with frozen inputs
+*/
+static void spirv_fold_spec_constants(std::vector<uint32_t>& spirv) {
+    thread_local std::unique_ptr<spvtools::Optimizer> optimizer;
+    if (!optimizer) {
+        optimizer = std::make_unique<spvtools::Optimizer>(SPV_ENV_UNIVERSAL_1_2);
+        optimizer->SetMessageConsumer(
+            [](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
+                // FIXME
+            });
+        optimizer->RegisterPass(spvtools::CreateFoldSpecConstantOpAndCompositePass());
+    }
+    spvtools::OptimizerOptions spvOptOptions;
+    spvOptOptions.set_run_validator(false);
+    optimizer->Run(spirv.data(), spirv.size(), &spirv, spvOptOptions);
+}
+
+// size and alignment of a SPIRV type in workgroup memory (estimated with std430 rules)
+struct SpirvTypeLayout {
+    int size = 0;
+    int align = 4;
+};
+
+static int roundup(int val, int round_to) {
+    return ((val + round_to - 1) / round_to) * round_to;
+}
+
+static SpirvTypeLayout type_layout(const std::vector<uint32_t>& spirv, size_t pos, uint32_t op, const std::unordered_map<uint32_t, SpirvTypeLayout>& types, const std::unordered_map<uint32_t, uint32_t>& constants) {
+    const uint32_t num_words = spirv[pos] >> 16;
+    const auto type = [&types](uint32_t id) {
+        auto it = types.find(id);
+        return (it != types.end()) ? it->second : SpirvTypeLayout();
+    };
+    SpirvTypeLayout res;
+    switch (op) {
+        case spv::OpTypeBool:
+            res.size = 4; res.align = 4;
+            break;
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+            res.size = (int)spirv[pos + 2] / 8; res.align = res.size;
+            break;
+        case spv::OpTypeVector:
+            {
+                const SpirvTypeLayout comp = type(spirv[pos + 2]);
+                const int count = (int)spirv[pos + 3];
+                res.size = comp.size * count;
+                res.align = comp.size * ((count == 2) ? 2 : 4);
+            }
+            break;
+        case spv::OpTypeMatrix:
+            {
+                const SpirvTypeLayout col = type(spirv[pos + 2]);
+                res.size = roundup(col.size, col.align) * (int)spirv[pos + 3];
+                res.align = col.align;
+            }
+            break;
+        case spv::OpTypeArray:
+            {
+                const SpirvTypeLayout elm = type(spirv[pos + 2]);
+                auto it = constants.find(spirv[pos + 3]);
+                const int len = (it != constants.end()) ? (int)it->second : 1;
+                res.size = roundup(elm.size, elm.align) * len;
+                res.align = elm.align;
+            }
+            break;
+        case spv::OpTypeStruct:
+            {
+                int offset = 0;
+                for (uint32_t i = 2; i < num_words; i++) {
+                    const SpirvTypeLayout member = type(spirv[pos + i]);
+                    offset = roundup(offset, member.align) + member.size;
+                    if (member.align > res.align) {
+                        res.align = member.align;
+                    }
+                }
+                res.size = roundup(offset, res.align);
+            }
+            break;
+        default:
+            break;
+    }
+    return res;
+}
+
+// walk the instructions of a SPIRV blob and count them by instruction class,
+// for compute shaders also gather the workgroup size and shared memory size
+SpirvStats Spirv::compute_stats(const std::vector<uint32_t>& spirv) {
+    SpirvStats stats;
+    const size_t header_size = 5;
+    bool in_function = false;
+    std::unordered_map<uint32_t, SpirvTypeLayout> types;
+    std::unordered_map<uint32_t, uint32_t> pointee_types;
+    std::unordered_map<uint32_t, uint32_t> constants;
+    size_t pos = header_size;
+    while (pos < spirv.size()) {
+        const uint32_t op = spirv[pos] & 0xFFFF;
+        const uint32_t num_words = spirv[pos] >> 16;
+        if ((num_words == 0) || ((pos + num_words) > spirv.size())) {
+            // malformed instruction stream, stop here
+            break;
+        }
+        if ((op >= spv::OpTypeBool) && (op <= spv::OpTypeStruct)) {
+            types[spirv[pos + 1]] = type_layout(spirv, pos, op, types, constants);
+        } else if (op == spv::OpTypePointer) {
+            pointee_types[spirv[pos + 1]] = spirv[pos + 3];
+        } else if (((op == spv::OpConstant) || (op == spv::OpSpecConstant)) && (num_words >= 4)) {
+            constants[spirv[pos + 2]] = spirv[pos + 3];
+        } else if ((op == spv::OpExecutionMode) && (spirv[pos + 2] == spv::ExecutionModeLocalSize) && (num_words >= 6)) {
+            for (int i = 0; i < 3; i++) {
+                stats.workgroup_size[i] = (int)spirv[pos + 3 + i];
+            }
+        } else if ((op == spv::OpVariable) && !in_function && (num_words >= 4) && (spirv[pos + 3] == spv::StorageClassWorkgroup)) {
+            auto it = types.find(pointee_types[spirv[pos + 1]]);
+            if (it != types.end()) {
+                stats.shared_memory_size = roundup(stats.shared_memory_size, it->second.align) + it->second.size;
+            }
+        } else if (op == spv::OpFunction) {
+            in_function = true;
+        } else if (op == spv::OpFunctionEnd) {
+            in_function = false;
+        } else if (in_function) {
+            stats.num_instructions++;
+            if ((op == spv::OpExtInst) || ((op >= spv::OpConvertFToU) && (op <= spv::OpBitCount)) || ((op >= spv::OpDPdx) && (op <= spv::OpFwidthCoarse))) {
+                stats.num_alu++;
+            } else if (((op >= spv::OpImageSampleImplicitLod) && (op <= spv::OpImageWrite)) ||
+                       ((op >= spv::OpImageSparseSampleImplicitLod) && (op <= spv::OpImageSparseDrefGather)) ||
+                       (op == spv::OpImageSparseRead))
+            {
+                stats.num_samples++;
+            } else if ((op == spv::OpBranchConditional) || (op == spv::OpSwitch)) {
+                stats.num_branches++;
+            } else if (op == spv::OpLoopMerge) {
+                stats.num_loops++;
+            } else if ((op == spv::OpControlBarrier) || (op == spv::OpMemoryBarrier)) {
+                stats.num_barriers++;
+            } else if ((op == spv::OpVariable) && (num_words >= 4) && (spirv[pos + 3] == spv::StorageClassFunction)) {
+                stats.num_locals++;
+            }
+        }
+        pos += num_words;
+    }
+    return stats;
+}
+
+// the SPIRV-Tools target environment matching the version in the SPIRV header
+static spv_target_env spirv_target_env(const std::vector<uint32_t>& spirv) {
+    const uint32_t minor_version = (spirv.size() > 1) ? ((spirv[1] >> 8) & 0xFF) : 0;
+    switch (minor_version) {
+        case 0: return SPV_ENV_UNIVERSAL_1_0;
+        case 1: return SPV_ENV_UNIVERSAL_1_1;
+        case 2: return SPV_ENV_UNIVERSAL_1_2;
+        case 3: return SPV_ENV_UNIVERSAL_1_3;
+        case 4: return SPV_ENV_UNIVERSAL_1_4;
+        case 5: return SPV_ENV_UNIVERSAL_1_5;
+        default: return SPV_ENV_UNIVERSAL_1_6;
+    }
+}
+
+/* strip debug information (OpName, OpMemberName, OpSource...) and compact
+    the result ids of a SPIRV blob which is embedded in the generated output,
+    this must only happen after SPIRVCross has extracted the reflection
+    information, since that needs the debug names, returns false if
+    the SPIRV blob couldn't be processed
+*/
+bool Spirv::reduce_size(std::vector<uint32_t>& inout_spirv) {
+    const spv_target_env target_env = spirv_target_env(inout_spirv);
+    thread_local std::map<spv_target_env, std::unique_ptr<spvtools::Optimizer>> optimizers;
+    std::unique_ptr<spvtools::Optimizer>& optimizer = optimizers[target_env];
+    if (!optimizer) {
+        optimizer = std::make_unique<spvtools::Optimizer>(target_env);
+        optimizer->SetMessageConsumer(
+            [](spv_message_level_t level, const char *source, const spv_position_t &position, const char *message) {
+                // FIXME
+            });
+        optimizer->RegisterPass(spvtools::CreateStripDebugInfoPass());
+        optimizer->RegisterPass(spvtools::CreateStripNonSemanticInfoPass());
+        optimizer->RegisterPass(spvtools::CreateCompactIdsPass());
+    }
+    spvtools::OptimizerOptions spvOptOptions;
+    spvOptOptions.set_run_validator(false);
+    std::vector<uint32_t> reduced_spirv;
+    if (!optimizer->Run(inout_spirv.data(), inout_spirv.size(), &reduced_spirv, spvOptOptions)) {
+        return false;
+    }
+    inout_spirv = std::move(reduced_spirv);
+    return true;
+}
+
+// replace the specialization constants which have a value set on the command line
+// with regular constants, this allows the optimizer to fold them (e.g. loop counts
+// or feature toggles), the names of all replaced constants are added to inout_names,
+// out_frozen is set if any constant in this SPIRV blob was replaced
+static bool freeze_spec_constants(const Input& inp, int snippet_index, const std::map<std::string, std::string>& spec_constants, std::vector<uint32_t>& inout_spirv, std::set<std::string>& inout_names, bool& out_frozen, std::vector<ErrMsg>& out_errors) {
+    out_frozen = false;
+    if (spec_constants.empty() || (inout_spirv.size() < 5)) {
+        return true;
+    }
+    std::unordered_map<uint32_t, std::string> names;
+    std::unordered_map<uint32_t, size_t> spec_id_decorations;     // constant id => position of SpecId decoration
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> types;    // type id => (opcode, signedness)
+    for (size_t pos = 5; pos < inout_spirv.size();) {
+        const uint32_t op = inout_spirv[pos] & 0xFFFF;
+        const uint32_t len = inout_spirv[pos] >> 16;
+        if ((len == 0) || ((pos + len) > inout_spirv.size())) {
+            break;
+        }
+        if ((op == spv::OpName) && (len > 2)) {
+            names[inout_spirv[pos + 1]] = (const char*) &inout_spirv[pos + 2];
+        } else if ((op == spv::OpDecorate) && (len == 4) && (inout_spirv[pos + 2] == spv::DecorationSpecId)) {
+            spec_id_decorations[inout_spirv[pos + 1]] = pos;
+        } else if ((op == spv::OpTypeBool) || (op == spv::OpTypeFloat)) {
+            types[inout_spirv[pos + 1]] = { op, 0 };
+        } else if ((op == spv::OpTypeInt) && (len == 4) && (inout_spirv[pos + 2] == 32)) {
+            types[inout_spirv[pos + 1]] = { op, inout_spirv[pos + 3] };
+        }
+        pos += len;
+    }
+    std::vector<size_t> removed_decorations;
+    bool valid = true;
+    for (size_t pos = 5; pos < inout_spirv.size();) {
+        const uint32_t op = inout_spirv[pos] & 0xFFFF;
+        const uint32_t len = inout_spirv[pos] >> 16;
+        if ((len == 0) || ((pos + len) > inout_spirv.size())) {
+            break;
+        }
+        if ((op == spv::OpSpecConstantTrue) || (op == spv::OpSpecConstantFalse) || (op == spv::OpSpecConstant)) {
+            const uint32_t type_id = inout_spirv[pos + 1];
+            const uint32_t id = inout_spirv[pos + 2];
+            const auto name_it = names.find(id);
+            const auto dec_it = spec_id_decorations.find(id);
+            if ((name_it != names.end()) && (dec_it != spec_id_decorations.end()) && (spec_constants.count(name_it->second) > 0)) {
+                const std::string& name = name_it->second;
+                const std::string& str = spec_constants.at(name);
+                bool ok = false;
+                try {
+                    size_t num_parsed = 0;
+                    if (op != spv::OpSpecConstant) {
+                        if ((str == "true") || (str == "1")) {
+                            inout_spirv[pos] = (len << 16) | spv::OpConstantTrue;
+                            ok = true;
+                        } else if ((str == "false") || (str == "0")) {
+                            inout_spirv[pos] = (len << 16) | spv::OpConstantFalse;
+                            ok = true;
+                        }
+                    } else if ((len == 4) && (types.count(type_id) > 0)) {
+                        const auto& type = types.at(type_id);
+                        if (type.first == spv::OpTypeFloat) {
+                            const float val = std::stof(str, &num_parsed);
+                            memcpy(&inout_spirv[pos + 3], &val, sizeof(val));
+                        } else if (type.second != 0) {
+                            inout_spirv[pos + 3] = (uint32_t) std::stoi(str, &num_parsed, 0);
+                        } else if (str.find('-') == std::string::npos) {
+                            inout_spirv[pos + 3] = (uint32_t) std::stoul(str, &num_parsed, 0);
+                        }
+                        if ((num_parsed > 0) && (num_parsed == str.length())) {
+                            inout_spirv[pos] = (len << 16) | spv::OpConstant;
+                            ok = true;
+                        }
+                    }
+                } catch (const std::exception&) {
+                    ok = false;
+                }
+                if (ok) {
+                    removed_decorations.push_back(dec_it->second);
+                    inout_names.insert(name);
+                } else {
+                    const Snippet& snippet = inp.snippets[snippet_index];
+                    const int line_index = util::first_snippet_line_index_skipping_include_blocks(inp, snippet);
+                    out_errors.push_back(inp.error(line_index, fmt::format("invalid value '{}' for specialization constant '{}'", str, name)));
+                    valid = false;
+                }
+            }
+        }
+        pos += len;
+    }
+    // remove the SpecId decorations of the replaced constants
+    out_frozen = !removed_decorations.empty();
+    if (!removed_decorations.empty()) {
+        std::sort(removed_decorations.begin(), removed_decorations.end());
+        std::vector<uint32_t> spirv;
+        spirv.reserve(inout_spirv.size());
+        size_t next = 0;
+        for (size_t pos = 0; pos < inout_spirv.size(); pos++) {
+            if ((next < removed_decorations.size()) && (pos == removed_decorations[next])) {
+                pos += 3;
+                next++;
+            } else {
+                spirv.push_back(inout_spirv[pos]);
+            }
+        }
+        inout_spirv = std::move(spirv);
+    }
+    return valid;
 }
 
 // compile a shader to SPIRV
-static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const MergedSource& source, int snippet_index, Spirv& out_spirv) {
-    const char* sources[1] = { source.src.c_str() };
-    const int sourcesLen[1] = { (int) source.src.length() };
-    const char* sourcesNames[1] = { inp.base_path.c_str() };
-    const int linenr_offset = source.linenr_offset;
+static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, OptLevel::Enum opt_level, bool perf_lint, const std::string& preamble, const std::map<std::string, std::string>& spec_constants, std::set<std::string>& inout_frozen_spec_constants, int snippet_index, Spirv& out_spirv) {
+    // pass each snippet line as a separate string pointing into the input
+    // lines, the string number in glslang errors is then the snippet line
+    // number (NOTE: lines are followed by a '\n' in storage, see SourceFile)
+    const Snippet& snippet = inp.snippets[snippet_index];
+    std::vector<const char*> sources;
+    std::vector<int> sourcesLen;
+    sources.reserve(snippet.lines.size() + 1);
+    sourcesLen.reserve(snippet.lines.size() + 1);
+    sources.push_back(version_source);
+    sourcesLen.push_back((int) strlen(version_source));
+    for (int line_index : snippet.lines) {
+        const std::string_view line = inp.lines[line_index].line;
+        sources.push_back(line.data());
+        sourcesLen.push_back((int) line.length() + 1);
+    }
+    const bool line_per_string = true;
 
     SpirvBlob spirv_blob = SpirvBlob(snippet_index);
+    spirv_blob.preamble = preamble;
 
     // compile GLSL vertex- or fragment-shader
     glslang::TShader shader(stage);
-    // FIXME: add custom defines here: compiler.addProcess(...)
-    shader.setStringsWithLengthsAndNames(sources, sourcesLen, sourcesNames, 1);
+    shader.setPreamble(preamble.c_str());
+    shader.setStringsWithLengths(sources.data(), sourcesLen.data(), (int) sources.size());
     shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
     shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
     shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_0);
     shader.setAutoMapLocations(true);
     bool parse_success = shader.parse(GetDefaultResources(), 100, false, EShMsgDefault);
-    util::infolog_to_errors(shader.getInfoLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
-    util::infolog_to_errors(shader.getInfoDebugLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
+    util::infolog_to_errors(shader.getInfoLog(), inp, snippet_index, line_per_string, out_spirv.errors);
+    util::infolog_to_errors(shader.getInfoDebugLog(), inp, snippet_index, line_per_string, out_spirv.errors);
     if (!parse_success) {
         return false;
     }
@@ -146,14 +609,14 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
     glslang::TProgram program;
     program.addShader(&shader);
     bool link_success = program.link(EShMsgDefault);
-    util::infolog_to_errors(program.getInfoLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
-    util::infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
+    util::infolog_to_errors(program.getInfoLog(), inp, snippet_index, line_per_string, out_spirv.errors);
+    util::infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, line_per_string, out_spirv.errors);
     if (!link_success) {
         return false;
     }
     bool map_success = program.mapIO();
-    util::infolog_to_errors(program.getInfoLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
-    util::infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, linenr_offset, out_spirv.errors);
+    util::infolog_to_errors(program.getInfoLog(), inp, snippet_index, line_per_string, out_spirv.errors);
+    util::infolog_to_errors(program.getInfoDebugLog(), inp, snippet_index, line_per_string, out_spirv.errors);
     if (!map_success) {
         return false;
     }
@@ -205,6 +668,9 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
     // translate intermediate representation to SPIRV
     const glslang::TIntermediate* im = program.getIntermediate(stage);
     assert(im);
+    if (perf_lint) {
+        PerfLint::lint(inp, snippet_index, stage == EShLangFragment, im, out_spirv.errors);
+    }
     spv::SpvBuildLogger spv_logger;
     glslang::SpvOptions spv_options;
     // disable the optimizer passes, we'll run our own after the translation
@@ -216,7 +682,6 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
     spv_options.validate = false;
     spv_options.emitNonSemanticShaderDebugInfo = false;
     spv_options.emitNonSemanticShaderDebugSource = false;
-    spirv_blob.source = source.src;
     glslang::GlslangToSpv(*im, spirv_blob.bytecode, &spv_logger, &spv_options);
     std::string spirv_log = spv_logger.getAllMessages();
     if (!spirv_log.empty()) {
@@ -224,8 +689,18 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
         // haven't seen a case yet where this generates log messages
         fmt::print(stderr, "{}", spirv_log);
     }
+    // replace specialization constants with values from the command line
+    bool frozen = false;
+    if (!freeze_spec_constants(inp, snippet_index, spec_constants, spirv_blob.bytecode, inout_frozen_spec_constants, frozen, out_spirv.errors)) {
+        return false;
+    }
+    if (frozen) {
+        spirv_fold_spec_constants(spirv_blob.bytecode);
+    }
     // run optimizer passes
-    spirv_optimize(slang, spirv_blob.bytecode);
+    spirv_optimize(slang, opt_level, spirv_blob.bytecode);
+    // gather static instruction statistics of the final bytecode
+    spirv_blob.stats = Spirv::compute_stats(spirv_blob.bytecode);
 
     // and done
     out_spirv.blobs.push_back(spirv_blob);
@@ -233,27 +708,28 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
 }
 
 // compile all shader-snippets into SPIRV bytecode
-Spirv Spirv::compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines) {
+Spirv Spirv::compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines, const std::map<std::string, std::string>& spec_constants, OptLevel::Enum opt_level, bool perf_lint, bool pack_varyings) {
     Spirv out_spirv;
+    std::set<std::string> frozen_spec_constants;
 
     // compile shader-snippets
+    const std::string preamble = build_preamble(slang, defines);
     int snippet_index = 0;
     for (const Snippet& snippet: inp.snippets) {
-        const MergedSource src = merge_source(inp, snippet, slang, defines);
         // NOTE: if compilation fails, out_spirv contains error list
         switch (snippet.type) {
             case Snippet::VS:
-                if (!compile(inp, EShLangVertex, slang, src, snippet_index, out_spirv)) {
+                if (!compile(inp, EShLangVertex, slang, opt_level, perf_lint, preamble, spec_constants, frozen_spec_constants, snippet_index, out_spirv)) {
                     return out_spirv;
                 }
                 break;
             case Snippet::FS:
-                if (!compile(inp, EShLangFragment, slang, src, snippet_index, out_spirv)) {
+                if (!compile(inp, EShLangFragment, slang, opt_level, perf_lint, preamble, spec_constants, frozen_spec_constants, snippet_index, out_spirv)) {
                     return out_spirv;
                 }
                 break;
             case Snippet::CS:
-                if (!compile(inp, EShLangCompute, slang, src, snippet_index, out_spirv)) {
+                if (!compile(inp, EShLangCompute, slang, opt_level, perf_lint, preamble, spec_constants, frozen_spec_constants, snippet_index, out_spirv)) {
                     return out_spirv;
                 }
                 break;
@@ -263,11 +739,71 @@ Spirv Spirv::compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, co
         snippet_index++;
     }
     // when arriving here, no compile errors occurred
+    for (const auto& item: spec_constants) {
+        if (frozen_spec_constants.count(item.first) == 0) {
+            out_spirv.errors.push_back(inp.error(0, fmt::format("specialization constant '{}' not found (set with --spec)", item.first)));
+            return out_spirv;
+        }
+    }
+    // optionally remove and pack varyings across shader stages, remove the
+    // dead code from the modified blobs and run them through the optimizer again
+    if (pack_varyings) {
+        for (int blob_index: Varyings::optimize(inp, out_spirv.blobs)) {
+            SpirvBlob& blob = out_spirv.blobs[blob_index];
+            spirv_cleanup_varyings(blob.bytecode);
+            spirv_optimize(slang, opt_level, blob.bytecode);
+            blob.stats = Spirv::compute_stats(blob.bytecode);
+        }
+    }
     // spirv.bytecodes array contains the SPIRV-bytecode
     // for each shader snippet
     return out_spirv;
 }
 
+// check the estimated cost of each blob against the per-stage budgets (0 means no budget)
+void Spirv::check_cost_budgets(const Input& inp, const int (&max_cost)[ShaderStage::Num]) {
+    for (const SpirvBlob& blob: blobs) {
+        const Snippet& snippet = inp.snippets[blob.snippet_index];
+        const ShaderStage::Enum stage = ShaderStage::from_snippet_type(snippet.type);
+        const int budget = max_cost[stage];
+        if ((budget > 0) && (blob.stats.cost() > budget)) {
+            const int line_index = util::first_snippet_line_index_skipping_include_blocks(inp, snippet);
+            errors.push_back(inp.error(line_index,
+                fmt::format("estimated cost {} of {} shader '{}' exceeds budget {} (alu: {}, samples: {}, branches: {}, loops: {}, barriers: {})",
+                    blob.stats.cost(), ShaderStage::to_str(stage), snippet.name, budget,
+                    blob.stats.num_alu, blob.stats.num_samples, blob.stats.num_branches, blob.stats.num_loops, blob.stats.num_barriers)));
+        }
+    }
+}
+
+// estimate the occupancy of compute shaders, and warn if target limits are exceeded or the occupancy is low
+void Spirv::check_compute_limits(const Input& inp, Slang::Enum slang, const ComputeLimits& limits, bool warn_occupancy) {
+    const ComputeLimits slang_limits = limits.for_slang(slang);
+    for (SpirvBlob& blob: blobs) {
+        if (!blob.stats.is_compute()) {
+            continue;
+        }
+        blob.stats.estimate_occupancy(slang_limits);
+        const Snippet& snippet = inp.snippets[blob.snippet_index];
+        const int line_index = util::first_snippet_line_index_skipping_include_blocks(inp, snippet);
+        if (blob.stats.shared_memory_size > slang_limits.max_shared_memory) {
+            errors.push_back(inp.warning(line_index,
+                fmt::format("compute shader '{}' uses {} bytes of shared memory, which exceeds the {} limit of {} bytes",
+                    snippet.name, blob.stats.shared_memory_size, Slang::to_str(slang), slang_limits.max_shared_memory)));
+        }
+        if (blob.stats.num_invocations() > slang_limits.max_invocations) {
+            errors.push_back(inp.warning(line_index,
+                fmt::format("compute shader '{}' workgroup size {} exceeds the {} limit of {} invocations",
+                    snippet.name, blob.stats.num_invocations(), Slang::to_str(slang), slang_limits.max_invocations)));
+        }
+        if (warn_occupancy && (blob.stats.occupancy < LowOccupancy)) {
+            errors.push_back(inp.warning(line_index,
+                fmt::format("compute shader '{}' has an estimated occupancy of {}% ({} workgroups of {} invocations and {} bytes shared memory per compute unit)",
+                    snippet.name, blob.stats.occupancy, blob.stats.workgroups_per_cu, blob.stats.num_invocations(), blob.stats.shared_memory_size)));
+        }
+    }
+}
+
 bool Spirv::write_to_file(const Args& args, const Input& inp, Slang::Enum slang) {
     std::string base_dir;
     std::string base_filename;
@@ -288,9 +824,10 @@ bool Spirv::write_to_file(const Args& args, const Input& inp, Slang::Enum slang)
         }
         {
             const std::string path = fmt::format("{}{}.glsl", base_path, snippet.name);
+            const std::string source = blob_source(inp, blob);
             FILE* fp = fopen(path.c_str(), "w");
             if (fp) {
-                fwrite(blob.source.c_str(), 1, blob.source.length(), fp);
+                fwrite(source.c_str(), 1, source.length(), fp);
                 fclose(fp);
             } else {
                 fmt::print("Failed to open '{}' for writing!\n", path);
@@ -305,11 +842,21 @@ bool Spirv::extract_glsl_spv(const Input& inp, std::vector<uint8_t>& vs, std::ve
     for (const SpirvBlob& blob: blobs) {
         const Snippet& snippet = inp.snippets[blob.snippet_index];
         if (snippet.name == "vs") {
-            vs.resize(blob.bytecode.size() * sizeof(uint32_t));
-            memcpy(vs.data(), blob.bytecode.data(), vs.size());
+            std::vector<uint32_t> spirv = blob.bytecode;
+            if (!reduce_size(spirv)) {
+                errors.push_back(inp.error(util::first_snippet_line_index_skipping_include_blocks(inp, snippet), fmt::format("failed to strip SPIRV of shader '{}'", snippet.name)));
+                return false;
+            }
+            vs.resize(spirv.size() * sizeof(uint32_t));
+            memcpy(vs.data(), spirv.data(), vs.size());
         } else if (snippet.name == "fs") {
-            fs.resize(blob.bytecode.size() * sizeof(uint32_t));
-            memcpy(fs.data(), blob.bytecode.data(), fs.size());
+            std::vector<uint32_t> spirv = blob.bytecode;
+            if (!reduce_size(spirv)) {
+                errors.push_back(inp.error(util::first_snippet_line_index_skipping_include_blocks(inp, snippet), fmt::format("failed to strip SPIRV of shader '{}'", snippet.name)));
+                return false;
+            }
+            fs.resize(spirv.size() * sizeof(uint32_t));
+            memcpy(fs.data(), spirv.data(), fs.size());
         }
     }
     return true;
@@ -330,9 +877,11 @@ void Spirv::dump_debug(const Input& inp, ErrMsg::Format err_fmt) const {
         fmt::print(stderr, "  snippet: {}\n", inp.snippets[blob.snippet_index].name);
         fmt::print(stderr, "  bindings:\n");
         blob.bindings.dump_debug();
+        fmt::print(stderr, "  stats:\n");
+        blob.stats.dump_debug("    ");
         fmt::print(stderr, "  source:\n", inp.snippets[blob.snippet_index].name);
         std::vector<std::string> src_lines;
-        pystring::splitlines(blob.source, src_lines);
+        pystring::splitlines(blob_source(inp, blob), src_lines);
         for (const std::string& src_line: src_lines) {
             fmt::print(stderr, "    {}\n", src_line);
         }
@@ -1,22 +1,32 @@
 #pragma once
+#include <map>
 #include <vector>
 #include <string>
 #include "args.h"
 #include "input.h"
 #include "types/errmsg.h"
 #include "types/spirv_blob.h"
+#include "types/shader_stage.h"
 #include "types/slang.h"
+#include "types/opt_level.h"
+#include "types/compute_limits.h"
 
 namespace shdc {
 
 // glslang SPIRV output of all shader source snippets for one shading language
 struct Spirv {
+    static const int LowOccupancy = 50;     // warn below this estimated compute shader occupancy in percent
+
     std::vector<ErrMsg> errors;
     std::vector<SpirvBlob> blobs;
 
     static void initialize_spirv_tools();
     static void finalize_spirv_tools();
-    static Spirv compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines);
+    static bool reduce_size(std::vector<uint32_t>& inout_spirv);
+    static SpirvStats compute_stats(const std::vector<uint32_t>& spirv);
+    static Spirv compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines, const std::map<std::string, std::string>& spec_constants, OptLevel::Enum opt_level, bool perf_lint, bool pack_varyings);
+    void check_cost_budgets(const Input& inp, const int (&max_cost)[ShaderStage::Num]);
+    void check_compute_limits(const Input& inp, Slang::Enum slang, const ComputeLimits& limits, bool warn_occupancy);
     bool write_to_file(const Args& args, const Input& inp, Slang::Enum slang);
     bool extract_glsl_spv(const Input& inp, std::vector<uint8_t>& vs, std::vector<uint8_t>& fs);
     void dump_debug(const Input& inp, ErrMsg::Format err_fmt) const;
@@ -91,109 +91,68 @@ static void fix_bind_slots(Compiler& compiler, const BindSlotMap& bindslot_map,
     }
 }
 
+// patch the descriptor set and binding decoration of a single resource directly in
+// the SPIRV bytecode, returns false if the resource doesn't have those decorations
+static bool patch_bind_slot(const Compiler& compiler, const Resource& res, uint32_t desc_set, int binding, std::vector<uint32_t>& inout_bytecode) {
+    assert(binding != -1);
+    uint32_t set_offset = 0;
+    uint32_t binding_offset = 0;
+    if (!compiler.get_binary_offset_for_decoration(res.id, spv::DecorationDescriptorSet, set_offset)) {
+        return false;
+    }
+    if (!compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, binding_offset)) {
+        return false;
+    }
+    inout_bytecode[set_offset] = desc_set;
+    inout_bytecode[binding_offset] = (uint32_t)binding;
+    return true;
+}
+
 // This directly patches the descriptor set and bindslot decorators in the input SPIRV
 // via SPIRVCross helper functions. This patched SPIRV is then used as input to Tint
-// for the SPIRV-to-WGSL translation
-static void wgsl_patch_bind_slots(Compiler& compiler, const BindSlotMap& bindslot_map, std::vector<uint32_t>& inout_bytecode) {
+// for the SPIRV-to-WGSL translation, or directly as SPIRV_VK output bytecode.
+// Returns false if a resource is missing its decorations.
+static bool patch_bind_slots(const Compiler& compiler, const BindSlotMap& bindslot_map, Slang::Enum slang, std::vector<uint32_t>& inout_bytecode) {
     ShaderResources shader_resources = compiler.get_shader_resources();
-    const Slang::Enum slang = Slang::WGSL;
     const uint32_t ub_bindgroup = 0;
     const uint32_t view_smp_bindgroup = 1;
+    bool res_ok = true;
 
     // uniform buffers
-    {
-        for (const Resource& res: shader_resources.uniform_buffers) {
-            assert(!res.name.empty());
-            uint32_t out_offset = 0;
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationDescriptorSet, out_offset)) {
-                inout_bytecode[out_offset] = ub_bindgroup;
-            } else {
-                // FIXME handle error
-            }
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                const int binding = bindslot_map.find_uniformblock_slang_slot(res.name, slang); assert(binding != -1);
-                inout_bytecode[out_offset] = (uint32_t)binding;
-            } else {
-                // FIXME: handle error
-            }
-        }
+    for (const Resource& res: shader_resources.uniform_buffers) {
+        assert(!res.name.empty());
+        const int binding = bindslot_map.find_uniformblock_slang_slot(res.name, slang);
+        res_ok &= patch_bind_slot(compiler, res, ub_bindgroup, binding, inout_bytecode);
     }
 
     // separate textures
-    {
-        for (const Resource& res: shader_resources.separate_images) {
-            assert(!res.name.empty());
-            uint32_t out_offset = 0;
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationDescriptorSet, out_offset)) {
-                inout_bytecode[out_offset] = view_smp_bindgroup;
-            } else {
-                // FIXME: handle error
-            }
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                const int binding = bindslot_map.find_view_slang_slot(res.name, slang); assert(binding != -1);
-                inout_bytecode[out_offset] = (uint32_t)binding;
-            } else {
-                // FIXME: handle error
-            }
-        }
+    for (const Resource& res: shader_resources.separate_images) {
+        assert(!res.name.empty());
+        const int binding = bindslot_map.find_view_slang_slot(res.name, slang);
+        res_ok &= patch_bind_slot(compiler, res, view_smp_bindgroup, binding, inout_bytecode);
     }
 
     // storage buffers
-    {
-        for (const Resource& res: shader_resources.storage_buffers) {
-            assert(!res.name.empty());
-            uint32_t out_offset = 0;
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationDescriptorSet, out_offset)) {
-                inout_bytecode[out_offset] = view_smp_bindgroup;
-            } else {
-                // FIXME: handle error
-            }
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                const int binding = bindslot_map.find_view_slang_slot(res.name, slang); assert(binding != -1);
-                inout_bytecode[out_offset] = (uint32_t)binding;
-            } else {
-                // FIXME: handle error
-            }
-        }
+    for (const Resource& res: shader_resources.storage_buffers) {
+        assert(!res.name.empty());
+        const int binding = bindslot_map.find_view_slang_slot(res.name, slang);
+        res_ok &= patch_bind_slot(compiler, res, view_smp_bindgroup, binding, inout_bytecode);
     }
 
     // storage images
-    {
-        for (const Resource& res: shader_resources.storage_images) {
-            assert(!res.name.empty());
-            uint32_t out_offset = 0;
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationDescriptorSet, out_offset)) {
-                inout_bytecode[out_offset] = view_smp_bindgroup;
-            } else {
-                // FIXME: handle error
-            }
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                const int binding = bindslot_map.find_view_slang_slot(res.name, slang); assert(binding != -1);
-                inout_bytecode[out_offset] = (uint32_t)binding;
-            } else {
-                // FIXME: handle error
-            }
-        }
+    for (const Resource& res: shader_resources.storage_images) {
+        assert(!res.name.empty());
+        const int binding = bindslot_map.find_view_slang_slot(res.name, slang);
+        res_ok &= patch_bind_slot(compiler, res, view_smp_bindgroup, binding, inout_bytecode);
     }
 
     // separate samplers
-    {
-        for (const Resource& res: shader_resources.separate_samplers) {
-            assert(!res.name.empty());
-            uint32_t out_offset = 0;
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationDescriptorSet, out_offset)) {
-                inout_bytecode[out_offset] = view_smp_bindgroup;
-            } else {
-                // FIXME: handle error
-            }
-            if (compiler.get_binary_offset_for_decoration(res.id, spv::DecorationBinding, out_offset)) {
-                const int binding = bindslot_map.find_sampler_slang_slot(res.name, slang); assert(binding != -1);
-                inout_bytecode[out_offset] = (uint32_t)binding;
-            } else {
-                // FIXME: handle error
-            }
-        }
+    for (const Resource& res: shader_resources.separate_samplers) {
+        assert(!res.name.empty());
+        const int binding = bindslot_map.find_sampler_slang_slot(res.name, slang);
+        res_ok &= patch_bind_slot(compiler, res, view_smp_bindgroup, binding, inout_bytecode);
     }
+    return res_ok;
 }
 
 static ErrMsg validate_resource_restrictions(const Input& inp, const SpirvBlob& blob) {
@@ -402,10 +361,18 @@ static SpirvcrossSource to_glsl(const Input& inp, const SpirvBlob& blob, Slang::
         flatten_uniform_blocks(compiler);
         to_combined_image_samplers(compiler);
     }
-    fix_bind_slots(compiler, blob.bindings, slang);
-    std::string src = compiler.compile();
     SpirvcrossSource res;
     res.snippet_index = blob.snippet_index;
+    if (slang_is_spirv) {
+        // the SPIRV output bytecode is the input SPIRV with patched bind slots,
+        // if this isn't possible the GLSL output is compiled back to SPIRV instead
+        res.spirv = blob.bytecode;
+        if (!patch_bind_slots(compiler, blob.bindings, slang, res.spirv)) {
+            res.spirv.clear();
+        }
+    }
+    fix_bind_slots(compiler, blob.bindings, slang);
+    std::string src = compiler.compile();
     if (!src.empty()) {
         res.source_code = std::move(src);
         res.stage_refl = parse_reflection(inp, blob, snippet, res.error);
@@ -480,9 +447,12 @@ static SpirvcrossSource to_wgsl(const Input& inp, const SpirvBlob& blob, Slang::
     std::vector<uint32_t> patched_bytecode = blob.bytecode;
     CompilerGLSL compiler_temp(blob.bytecode);
     fix_bind_slots(compiler_temp, blob.bindings, slang);
-    wgsl_patch_bind_slots(compiler_temp, blob.bindings, patched_bytecode);
     SpirvcrossSource res;
     res.snippet_index = blob.snippet_index;
+    if (!patch_bind_slots(compiler_temp, blob.bindings, slang, patched_bytecode)) {
+        res.error = inp.error(util::first_snippet_line_index_skipping_include_blocks(inp, snippet), "failed to patch bind slots in SPIRV bytecode for WGSL");
+        return res;
+    }
     tint::spirv::reader::Options spirv_options;
     spirv_options.allow_non_uniform_derivatives = true; // FIXME? => this allow texture sample calls inside dynamic if blocks
     spirv_options.allowed_features.features = { tint::wgsl::LanguageFeature::kReadonlyAndReadwriteStorageTextures };
@@ -510,7 +480,7 @@ struct SnippetRefls {
     const StageReflection fs_refl;
 };
 
-Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::Enum slang) {
+Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::Enum slang, const Cache& cache) {
     Spirvcross spv_cross;
     try {
         for (const auto& blob: spirv.blobs) {
@@ -522,17 +492,25 @@ Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::En
             if (spv_cross.error.valid()) {
                 return spv_cross;
             }
-            if (Slang::is_glsl(slang) || Slang::is_spirv(slang)) {
-                src = to_glsl(inp, blob, slang, opt_mask, snippet);
-            } else if (Slang::is_hlsl(slang)) {
-                src = to_hlsl(inp, blob, slang, opt_mask, snippet);
-            } else if (Slang::is_msl(slang)) {
-                src = to_msl(inp, blob, slang, opt_mask, snippet);
-            } else if (Slang::is_wgsl(slang)) {
-                src = to_wgsl(inp, blob, slang, opt_mask, snippet);
+            if (cache.load_source(slang, blob.snippet_index, src)) {
+                // cache hit, only the reflection info needs to be rebuilt
+                src.stage_refl = parse_reflection(inp, blob, snippet, src.error);
+                src.valid = !src.error.valid();
+            } else {
+                if (Slang::is_glsl(slang) || Slang::is_spirv(slang)) {
+                    src = to_glsl(inp, blob, slang, opt_mask, snippet);
+                } else if (Slang::is_hlsl(slang)) {
+                    src = to_hlsl(inp, blob, slang, opt_mask, snippet);
+                } else if (Slang::is_msl(slang)) {
+                    src = to_msl(inp, blob, slang, opt_mask, snippet);
+                } else if (Slang::is_wgsl(slang)) {
+                    src = to_wgsl(inp, blob, slang, opt_mask, snippet);
+                }
+                cache.store_source(slang, src);
             }
             if (src.valid) {
                 assert(src.snippet_index == blob.snippet_index);
+                src.stats = blob.stats;
                 spv_cross.sources.push_back(std::move(src));
             } else {
                 const int line_index = util::first_snippet_line_index_skipping_include_blocks(inp, snippet);
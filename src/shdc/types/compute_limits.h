@@ -0,0 +1,51 @@
+#pragma once
+#include "slang.h"
+
+namespace shdc {
+
+// compute shader resource limits used for the workgroup occupancy estimate
+struct ComputeLimits {
+    // per-workgroup limits, 0 means: use the default of the target shader language
+    int max_shared_memory = 0;      // max workgroup shared memory in bytes
+    int max_invocations = 0;        // max local_size_x * local_size_y * local_size_z
+    // a generic compute unit model (a NVIDIA SM or AMD CU)
+    int cu_shared_memory = 65536;   // shared memory per compute unit in bytes
+    int cu_max_invocations = 2048;  // max resident invocations per compute unit
+    int cu_max_workgroups = 32;     // max resident workgroups per compute unit
+    static const int SimdWidth = 32;    // workgroups are allocated in multiples of this
+
+    // return limits with the per-workgroup defaults of a target shader language filled in
+    ComputeLimits for_slang(Slang::Enum slang) const;
+};
+
+inline ComputeLimits ComputeLimits::for_slang(Slang::Enum slang) const {
+    // the minimum guaranteed limits of the respective 3D APIs
+    int shared_memory = 32768;
+    int invocations = 1024;
+    switch (slang) {
+        case Slang::GLSL310ES:
+            shared_memory = 16384; invocations = 128;
+            break;
+        case Slang::HLSL4:
+            shared_memory = 16384; invocations = 768;
+            break;
+        case Slang::WGSL:
+            shared_memory = 16384; invocations = 256;
+            break;
+        case Slang::SPIRV_VK:
+            shared_memory = 16384; invocations = 128;
+            break;
+        default:
+            break;
+    }
+    ComputeLimits res = *this;
+    if (res.max_shared_memory == 0) {
+        res.max_shared_memory = shared_memory;
+    }
+    if (res.max_invocations == 0) {
+        res.max_invocations = invocations;
+    }
+    return res;
+}
+
+} // namespace shdc
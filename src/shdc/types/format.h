@@ -16,6 +16,7 @@ struct Format	{
         SOKOL_JAI,
         SOKOL_C2,
         SOKOL_C3,
+        SOKOL_CPP,
         BARE,
         BARE_YAML,
         NUM,
@@ -38,6 +39,7 @@ inline const char* Format::to_str(Enum f) {
         case SOKOL_JAI:     return "sokol_jai";
         case SOKOL_C2:      return "sokol_c2";
         case SOKOL_C3:      return "sokol_c3";
+        case SOKOL_CPP:     return "sokol_cpp";
         case BARE:          return "bare";
         case BARE_YAML:     return "bare_yaml";
         default:            return "<invalid>";
@@ -65,6 +67,8 @@ inline Format::Enum Format::from_str(const std::string& str) {
         return SOKOL_C2;
     } else if (str == "sokol_c3") {
         return SOKOL_C3;
+    } else if (str == "sokol_cpp") {
+        return SOKOL_CPP;
     } else if (str == "bare") {
         return BARE;
     } else if (str == "bare_yaml") {
@@ -1,22 +1,22 @@
 #pragma once
-#include <string>
+#include <string_view>
 
 namespace shdc {
 
 // mapping each line to included filename and line index
 struct Line {
-    std::string line;       // line content
+    std::string_view line;  // line content, points into a SourceFile owned by Input
     int filename = 0;       // index into Input filenames
     int snippet = -1;       // snippet index to which this line belongs (-1 => none)
     int index = 0;          // line index == line nr - 1
 
     Line();
-    Line(const std::string& ln, int fn, int ix);
+    Line(std::string_view ln, int fn, int ix);
 };
 
 inline Line::Line() { };
 
-inline Line::Line(const std::string& ln, int fn, int ix):
+inline Line::Line(std::string_view ln, int fn, int ix):
     line(ln),
     filename(fn),
     index(ix)
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+
+namespace shdc {
+
+// the SPIRV optimization level
+struct OptLevel {
+    enum Enum {
+        O0 = 0,     // no optimization passes
+        Os,         // optimize for size
+        O1,         // conservative optimization passes (default)
+        O2,         // optimize for performance where the target shader language allows
+        NUM,
+        INVALID,
+    };
+
+    static const char* to_str(Enum o);
+    static Enum from_str(const std::string& str);
+};
+
+inline const char* OptLevel::to_str(Enum o) {
+    switch (o) {
+        case O0:    return "0";
+        case Os:    return "s";
+        case O1:    return "1";
+        case O2:    return "2";
+        default:    return "<invalid>";
+    }
+}
+
+inline OptLevel::Enum OptLevel::from_str(const std::string& str) {
+    if (str == "0") {
+        return O0;
+    } else if (str == "s") {
+        return Os;
+    } else if (str == "1") {
+        return O1;
+    } else if (str == "2") {
+        return O2;
+    } else {
+        return INVALID;
+    }
+}
+
+} // namespace shdc
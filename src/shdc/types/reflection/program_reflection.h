@@ -8,6 +8,7 @@ struct ProgramReflection {
     std::string name;
     std::array<StageReflection, ShaderStage::Num> stages;
     Bindings bindings;  // merged stage bindings
+    std::vector<SpecConstant> spec_constants;   // merged stage specialization constants
 
     const StageReflection& stage(ShaderStage::Enum s) const;
     bool has_vs() const;
@@ -69,6 +70,10 @@ inline void ProgramReflection::dump_debug(const std::string& indent) const {
     fmt::print(stderr, "{}name: {}\n", indent2, name);
     fmt::print(stderr, "{}stages:\n", indent2);
     bindings.dump_debug(indent2);
+    fmt::print(stderr, "{}spec_constants:\n", indent2);
+    for (const auto& spec_constant: spec_constants) {
+        spec_constant.dump_debug(indent2);
+    }
     if (has_vs()) {
         vs().dump_debug(indent2);
     }
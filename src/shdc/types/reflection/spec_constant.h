@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include "fmt/format.h"
+#include "../shader_stage.h"
+#include "type.h"
+
+namespace shdc::refl {
+
+// a specialization constant: layout(constant_id=N) const [type] [name] = [default_value];
+struct SpecConstant {
+    ShaderStage::Enum stage = ShaderStage::Invalid;
+    int constant_id = -1;
+    std::string name;
+    Type::Enum type = Type::Invalid;    // Bool, Int, UInt or Float
+    std::string default_value;          // the default value as literal
+
+    bool equals(const SpecConstant& other) const;
+    void dump_debug(const std::string& indent) const;
+};
+
+// NOTE: ignores the stage
+inline bool SpecConstant::equals(const SpecConstant& other) const {
+    return (constant_id == other.constant_id)
+        && (name == other.name)
+        && (type == other.type)
+        && (default_value == other.default_value);
+}
+
+inline void SpecConstant::dump_debug(const std::string& indent) const {
+    const std::string indent2 = indent + "  ";
+    fmt::print(stderr, "{}-\n", indent);
+    fmt::print(stderr, "{}stage: {}\n", indent2, ShaderStage::to_str(stage));
+    fmt::print(stderr, "{}constant_id: {}\n", indent2, constant_id);
+    fmt::print(stderr, "{}name: {}\n", indent2, name);
+    fmt::print(stderr, "{}type: {}\n", indent2, Type::type_to_str(type));
+    fmt::print(stderr, "{}default_value: {}\n", indent2, default_value);
+}
+
+} // namespace
@@ -1,10 +1,12 @@
 #pragma once
 #include <string>
 #include <array>
+#include <vector>
 #include "fmt/format.h"
 #include "../shader_stage.h"
 #include "stage_attr.h"
 #include "bindings.h"
+#include "spec_constant.h"
 
 namespace shdc::refl {
 
@@ -16,6 +18,7 @@ struct StageReflection {
     std::array<StageAttr, StageAttr::Num> inputs;       // index == attribute slot
     std::array<StageAttr, StageAttr::Num> outputs;      // index == attribute slot
     Bindings bindings;
+    std::vector<SpecConstant> spec_constants;
     int cs_workgroup_size[3];  // layout(local_size_x=x, local_size_y=y, local_size_z=z)
 
     size_t num_inputs() const;
@@ -74,6 +77,10 @@ inline void StageReflection::dump_debug(const std::string& indent) const {
     }
     fmt::print(stderr, "{}bindings:\n", indent2);
     bindings.dump_debug(indent2);
+    fmt::print(stderr, "{}spec_constants:\n", indent2);
+    for (const auto& spec_constant: spec_constants) {
+        spec_constant.dump_debug(indent2);
+    }
 }
 
 } // namespace
@@ -49,6 +49,7 @@ struct Type {
     int matrix_stride = 0;  // only set when columns > 1
     int array_count = 0;    // this can be zero for unbounded arrays
     int array_stride = 0;
+    bool used = true;       // only for uniform block members: referenced by the shader code
     std::vector<Type> struct_items;
 
     bool equals(const Type& other) const;
@@ -62,6 +63,7 @@ struct Type {
     static std::string valid_glsl_types_as_str();
 };
 
+// NOTE: ignores the used flag
 inline bool Type::equals(const Type& other) const {
     if (struct_typename != other.struct_typename) {
         return false;
@@ -272,6 +274,7 @@ inline void Type::dump_debug(const std::string& indent) const {
     fmt::print(stderr, "{}matrix_stride: {}\n", indent2, matrix_stride);
     fmt::print(stderr, "{}array_count: {}\n", indent2, array_count);
     fmt::print(stderr, "{}array_stride: {}\n", indent2, array_stride);
+    fmt::print(stderr, "{}used: {}\n", indent2, used);
     if (type == Type::Struct) {
         fmt::print(stderr, "{}struct items:\n", indent2);
         for (const auto& struct_item: struct_items) {
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <vector>
 #include "fmt/format.h"
@@ -18,19 +19,42 @@ struct UniformBlock {
     std::string inst_name;
     bool flattened = false;
     Type struct_info;
+    // the minimal byte range covering all members referenced by the shader code
+    int used_offset = 0;
+    int used_size = 0;
 
     bool equals(const UniformBlock& other) const;
+    void merge_used(const UniformBlock& other);
     void dump_debug(const std::string& indent) const;
 };
 
 inline bool UniformBlock::equals(const UniformBlock& other) const {
     return (stage == other.stage)
-        // NOTE: ignore inst_name
+        // NOTE: ignore inst_name and used members
         && (name == other.name)
         && (flattened == other.flattened)
         && struct_info.equals(other.struct_info);
 }
 
+// merge the used members and byte range of an identical uniform block
+inline void UniformBlock::merge_used(const UniformBlock& other) {
+    for (size_t i = 0; i < struct_info.struct_items.size(); i++) {
+        if (other.struct_info.struct_items[i].used) {
+            struct_info.struct_items[i].used = true;
+        }
+    }
+    if (other.used_size > 0) {
+        if (used_size == 0) {
+            used_offset = other.used_offset;
+            used_size = other.used_size;
+        } else {
+            const int end = std::max(used_offset + used_size, other.used_offset + other.used_size);
+            used_offset = std::min(used_offset, other.used_offset);
+            used_size = end - used_offset;
+        }
+    }
+}
+
 inline void UniformBlock::dump_debug(const std::string& indent) const {
     const std::string indent2 = indent + "  ";
     fmt::print(stderr, "{}-\n", indent);
@@ -42,6 +66,8 @@ inline void UniformBlock::dump_debug(const std::string& indent) const {
     fmt::print(stderr, "{}spirv_set0_binding_n: {}\n", indent2, spirv_set0_binding_n);
     fmt::print(stderr, "{}inst_name: {}\n", indent2, inst_name);
     fmt::print(stderr, "{}flattened: {}\n", indent2, flattened);
+    fmt::print(stderr, "{}used_offset: {}\n", indent2, used_offset);
+    fmt::print(stderr, "{}used_size: {}\n", indent2, used_size);
     fmt::print(stderr, "{}struct:\n", indent2);
     struct_info.dump_debug(indent2);
 }
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace shdc {
+
+// a preprocessed source file (comments removed, '#pragma sokol' normalized),
+// owned by the Input object since Line objects reference its content
+struct SourceFile {
+    std::string path;                   // resolved path
+    std::vector<std::string> lines;     // file content split into lines, each terminated with '\n'
+    std::vector<std::string> includes;  // per line: @include filename, or empty
+};
+
+} // namespace shdc
@@ -2,15 +2,17 @@
 #include <string>
 #include <vector>
 #include "bind_slot_map.h"
+#include "spirv_stats.h"
 
 namespace shdc {
 
 // a SPIRV-bytecode blob with "back-link" to Input.snippets and some limited reflection info
 struct SpirvBlob {
     int snippet_index = -1;         // index into Input.snippets
-    std::string source;             // source code this blob was compiled from
+    std::string preamble;           // defines passed to glslang in front of the snippet source
     std::vector<uint32_t> bytecode; // the resulting SPIRV blob
     BindSlotMap bindings;           // extracted bindings
+    SpirvStats stats;               // static instruction statistics of the optimized bytecode
 
     SpirvBlob(int snippet_index);
 };
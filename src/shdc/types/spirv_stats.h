@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include "fmt/format.h"
+#include "compute_limits.h"
+
+namespace shdc {
+
+// static instruction statistics of an optimized SPIRV blob
+struct SpirvStats {
+    // per-instruction-class weights for the estimated cost
+    static const int AluCost = 1;
+    static const int SampleCost = 8;
+    static const int BranchCost = 2;
+    static const int LoopCost = 16;
+    static const int BarrierCost = 8;
+
+    int num_instructions = 0;   // all instructions inside function bodies
+    int num_alu = 0;            // arithmetic, logic, conversion, derivative and extended-instruction-set ops
+    int num_samples = 0;        // texture sample, fetch, gather and storage image read/write ops
+    int num_branches = 0;       // conditional branches and switches
+    int num_loops = 0;          // loop merge instructions
+    int num_barriers = 0;       // control and memory barriers
+    int num_locals = 0;         // function-local variables
+    // compute shaders only
+    int workgroup_size[3] = { 0, 0, 0 };
+    int shared_memory_size = 0; // estimated size of all workgroup shared variables in bytes
+    int workgroups_per_cu = 0;  // estimated resident workgroups per compute unit (see estimate_occupancy())
+    int occupancy = 0;          // estimated percentage of resident invocations per compute unit
+
+    bool is_compute() const;
+    int num_invocations() const;
+    void estimate_occupancy(const ComputeLimits& limits);
+
+    int cost() const;
+    void dump_debug(const std::string& indent) const;
+};
+
+inline int SpirvStats::cost() const {
+    return num_alu * AluCost
+         + num_samples * SampleCost
+         + num_branches * BranchCost
+         + num_loops * LoopCost
+         + num_barriers * BarrierCost;
+}
+
+inline bool SpirvStats::is_compute() const {
+    return workgroup_size[0] > 0;
+}
+
+inline int SpirvStats::num_invocations() const {
+    return workgroup_size[0] * workgroup_size[1] * workgroup_size[2];
+}
+
+inline void SpirvStats::estimate_occupancy(const ComputeLimits& limits) {
+    workgroups_per_cu = 0;
+    occupancy = 0;
+    if (!is_compute()) {
+        return;
+    }
+    // invocations are allocated in whole SIMD units
+    const int invocations = ((num_invocations() + ComputeLimits::SimdWidth - 1) / ComputeLimits::SimdWidth) * ComputeLimits::SimdWidth;
+    int groups = limits.cu_max_workgroups;
+    if ((limits.cu_max_invocations / invocations) < groups) {
+        groups = limits.cu_max_invocations / invocations;
+    }
+    if ((shared_memory_size > 0) && ((limits.cu_shared_memory / shared_memory_size) < groups)) {
+        groups = limits.cu_shared_memory / shared_memory_size;
+    }
+    workgroups_per_cu = groups;
+    occupancy = (groups * num_invocations() * 100) / limits.cu_max_invocations;
+    if (occupancy > 100) {
+        occupancy = 100;
+    }
+}
+
+inline void SpirvStats::dump_debug(const std::string& indent) const {
+    fmt::print(stderr, "{}instructions: {}\n", indent, num_instructions);
+    fmt::print(stderr, "{}alu: {}\n", indent, num_alu);
+    fmt::print(stderr, "{}samples: {}\n", indent, num_samples);
+    fmt::print(stderr, "{}branches: {}\n", indent, num_branches);
+    fmt::print(stderr, "{}loops: {}\n", indent, num_loops);
+    fmt::print(stderr, "{}barriers: {}\n", indent, num_barriers);
+    fmt::print(stderr, "{}locals: {}\n", indent, num_locals);
+    fmt::print(stderr, "{}cost: {}\n", indent, cost());
+    if (is_compute()) {
+        fmt::print(stderr, "{}workgroup_size: {} {} {}\n", indent, workgroup_size[0], workgroup_size[1], workgroup_size[2]);
+        fmt::print(stderr, "{}shared_memory: {}\n", indent, shared_memory_size);
+        fmt::print(stderr, "{}workgroups_per_cu: {}\n", indent, workgroups_per_cu);
+        fmt::print(stderr, "{}occupancy: {}%\n", indent, occupancy);
+    }
+}
+
+} // namespace shdc
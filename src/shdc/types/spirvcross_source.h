@@ -1,5 +1,8 @@
 #pragma once
+#include <vector>
+#include <stdint.h>
 #include "errmsg.h"
+#include "spirv_stats.h"
 #include "reflection/stage_reflection.h"
 
 namespace shdc {
@@ -9,7 +12,9 @@ struct SpirvcrossSource {
     bool valid = false;
     int snippet_index = -1;
     std::string source_code;
+    std::vector<uint32_t> spirv;    // SPIRV_VK only: input SPIRV with patched bind slots (empty if not possible)
     ErrMsg error;
+    SpirvStats stats;               // static instruction statistics of the input SPIRV
     refl::StageReflection stage_refl;
 };
 
@@ -1,11 +1,33 @@
 #include "util.h"
 #include "pystring.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 namespace shdc::util {
 
-ErrMsg write_dep_file(const Args& args, const Input& inp) {
+ErrMsg write_dep_file(const Args& args, const Input& inp, const std::vector<std::string>& blob_file_paths) {
     std::string content;
-    content.append(fmt::format("{}: {}", args.output, inp.filenames[0]));
+    content.append(args.output);
+    if (args.split_output) {
+        content.append(fmt::format(" {}", split_output_path(args.output, "common")));
+        for (const auto& item: inp.programs) {
+            content.append(fmt::format(" {}", split_output_path(args.output, item.first)));
+        }
+    }
+    if (args.split_backends) {
+        for (int i = 0; i < Slang::Num; i++) {
+            Slang::Enum slang = Slang::from_index(i);
+            if (args.slang & Slang::bit(slang)) {
+                content.append(fmt::format(" {}", backend_impl_path(args.output, slang)));
+            }
+        }
+    }
+    // --embed-files: the binary files and the assembler stub of the sokol C formats
+    for (const std::string& path: blob_file_paths) {
+        content.append(fmt::format(" {}", path));
+    }
+    content.append(fmt::format(": {}", inp.filenames[0]));
     for (size_t i = 1; i < inp.filenames.size(); i++) {
         const std::string& fn = inp.filenames[i];
         content.append(fmt::format(" \\\n  {}", fn));
@@ -20,6 +42,23 @@ ErrMsg write_dep_file(const Args& args, const Input& inp) {
     return ErrMsg();
 }
 
+// output path of a --split-output part, derived from the regular output path,
+// e.g. 'shaders/shd.glsl.h' => 'shaders/shd.glsl_[part_name].h'
+std::string split_output_path(const std::string& output, const std::string& part_name) {
+    std::string root;
+    std::string ext;
+    pystring::os::path::splitext(root, ext, output);
+    return fmt::format("{}_{}{}", root, part_name, ext);
+}
+
+// output path of a --split-backends C file, e.g. 'shaders/shd.glsl.h' => 'shaders/shd.glsl_hlsl5.c'
+std::string backend_impl_path(const std::string& output, Slang::Enum slang) {
+    std::string root;
+    std::string ext;
+    pystring::os::path::splitext(root, ext, output);
+    return fmt::format("{}_{}.c", root, Slang::to_str(slang));
+}
+
 // this returns the first line index of a snippet which actually belong to the snippet,
 // skipping any included blocks - used for error messages which should be positioned
 // at the start of a snippet (if the snippet started with an @include_block that first
@@ -35,11 +74,41 @@ int first_snippet_line_index_skipping_include_blocks(const Input& inp, const Sni
     return snippet.lines[0];
 }
 
+// call func(index) for each index in [0, num_items) on a bounded number of
+// worker threads, the order in which items are processed is undefined
+void parallel_for(int num_items, const std::function<void(int)>& func) {
+    const int num_threads = std::min(num_items, std::max(1, (int)std::thread::hardware_concurrency()));
+    if (num_threads <= 1) {
+        for (int i = 0; i < num_items; i++) {
+            func(i);
+        }
+        return;
+    }
+    std::atomic<int> next_index(0);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&]() {
+            int i;
+            while ((i = next_index++) < num_items) {
+                func(i);
+            }
+        });
+    }
+    for (std::thread& thread: threads) {
+        thread.join();
+    }
+}
+
 // convert a glslang info-log string to ErrMsg's and append to out_errors
-void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, int linenr_offset, std::vector<ErrMsg>& out_errors) {
+void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, bool line_per_string, std::vector<ErrMsg>& out_errors) {
     /*
-        format for errors is "[ERROR|WARNING]: [pos=0?]:[line]: message"
+        format for errors is "[ERROR|WARNING]: [string]:[line]: message"
         And a last line we need to ignore: "ERROR: N compilation errors. ..."
+
+        If line_per_string is true, the source has been passed to glslang
+        as one string per snippet line after a leading '#version' string,
+        so that the string number identifies the snippet line.
     */
     const Snippet& snippet = inp.snippets[snippet_index];
 
@@ -64,9 +133,14 @@ void infolog_to_errors(const std::string& log, const Input& inp, int snippet_ind
             std::string msg;
             if (tokens.size() >= 4) {
                 // extract line index and message
-                int snippet_line_index = atoi(tokens[2].c_str());
-                // correct for 1-based and additional #defines that had been injected in front of actual snippet source
-                snippet_line_index -= (linenr_offset + 1);
+                int snippet_line_index;
+                if (line_per_string) {
+                    // correct for the '#version' string in front of the actual snippet source
+                    snippet_line_index = atoi(tokens[1].c_str()) - 1;
+                } else {
+                    // correct for 1-based line numbers
+                    snippet_line_index = atoi(tokens[2].c_str()) - 1;
+                }
                 if (snippet_line_index < 0) {
                     snippet_line_index = 0;
                 }
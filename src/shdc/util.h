@@ -1,12 +1,16 @@
 #pragma once
+#include <functional>
 #include "input.h"
 #include "args.h"
 #include "types/errmsg.h"
 
 namespace shdc::util {
 
-ErrMsg write_dep_file(const Args& args, const Input& inp);
+ErrMsg write_dep_file(const Args& args, const Input& inp, const std::vector<std::string>& blob_file_paths);
+std::string split_output_path(const std::string& output, const std::string& part_name);
+std::string backend_impl_path(const std::string& output, Slang::Enum slang);
 int first_snippet_line_index_skipping_include_blocks(const Input& inp, const Snippet& snippet);
-void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, int linenr_offset, std::vector<ErrMsg>& out_errors);
+void parallel_for(int num_items, const std::function<void(int)>& func);
+void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, bool line_per_string, std::vector<ErrMsg>& out_errors);
 
 } // namespace shdc::util
@@ -0,0 +1,750 @@
+/*
+    Cross-stage varying optimization on the SPIRV of vertex-/fragment-shader
+    pairs: removes vertex shader outputs which are never read in any of the
+    fragment shaders linked with the vertex shader, and packs the remaining
+    float varyings into fewer locations.
+
+    Varyings are rewritten into private variables, the vertex shader copies
+    them into the packed outputs before returning from the entry function,
+    and the fragment shader copies the packed inputs into them at the start
+    of the entry function. The cleanup passes which run afterwards (see
+    spirv.cc) remove the code which only fed removed outputs.
+*/
+#include <map>
+#include <set>
+#include <algorithm>
+#include "varyings.h"
+#include "fmt/format.h"
+#include "spirv.hpp"
+
+namespace shdc {
+
+typedef std::vector<uint32_t> Inst;
+
+static uint32_t opcode(const Inst& inst) {
+    return inst[0] & 0xFFFF;
+}
+
+static Inst make_inst(uint32_t op, const std::vector<uint32_t>& operands) {
+    Inst inst;
+    inst.push_back((uint32_t)((operands.size() + 1) << 16) | op);
+    inst.insert(inst.end(), operands.begin(), operands.end());
+    return inst;
+}
+
+static bool is_interp_decoration(uint32_t dec) {
+    return (dec == spv::DecorationNoPerspective) || (dec == spv::DecorationFlat) || (dec == spv::DecorationCentroid) || (dec == spv::DecorationSample);
+}
+
+// number of words of a SPIRV literal string starting at a word offset
+static size_t string_words(const Inst& inst, size_t offset) {
+    for (size_t i = offset; i < inst.size(); i++) {
+        if ((inst[i] & 0xFF000000) == 0) {
+            return i - offset + 1;
+        }
+    }
+    return inst.size() - offset;
+}
+
+// a SPIRV module split into instructions
+struct Module {
+    std::vector<uint32_t> header;
+    std::vector<Inst> insts;
+
+    bool parse(const std::vector<uint32_t>& words);
+    std::vector<uint32_t> words() const;
+    uint32_t new_id();
+    int globals_end() const;
+    int annotations_begin() const;
+    int names_end() const;
+    const Inst* type_def(uint32_t id) const;
+    int num_locations(uint32_t type_id) const;
+    uint32_t pointer_type(uint32_t storage_class, uint32_t type);
+    uint32_t vector_type(uint32_t comp_type, uint32_t num_components);
+    uint32_t entry_function() const;
+    void remove_from_interface(uint32_t id);
+    void add_to_interface(uint32_t id);
+};
+
+bool Module::parse(const std::vector<uint32_t>& words) {
+    const size_t header_size = 5;
+    if (words.size() < header_size) {
+        return false;
+    }
+    header.assign(words.begin(), words.begin() + header_size);
+    size_t pos = header_size;
+    while (pos < words.size()) {
+        const uint32_t num_words = words[pos] >> 16;
+        if ((num_words == 0) || ((pos + num_words) > words.size())) {
+            return false;
+        }
+        insts.push_back(Inst(words.begin() + pos, words.begin() + pos + num_words));
+        pos += num_words;
+    }
+    return true;
+}
+
+std::vector<uint32_t> Module::words() const {
+    std::vector<uint32_t> res = header;
+    for (const Inst& inst: insts) {
+        res.insert(res.end(), inst.begin(), inst.end());
+    }
+    return res;
+}
+
+uint32_t Module::new_id() {
+    return header[3]++;
+}
+
+// index of the first function, new global instructions are inserted here
+int Module::globals_end() const {
+    for (int i = 0; i < (int)insts.size(); i++) {
+        if (opcode(insts[i]) == spv::OpFunction) {
+            return i;
+        }
+    }
+    return (int)insts.size();
+}
+
+int Module::annotations_begin() const {
+    for (int i = 0; i < (int)insts.size(); i++) {
+        if (opcode(insts[i]) == spv::OpDecorate) {
+            return i;
+        }
+    }
+    return globals_end();
+}
+
+int Module::names_end() const {
+    int res = -1;
+    for (int i = 0; i < (int)insts.size(); i++) {
+        const uint32_t op = opcode(insts[i]);
+        if ((op == spv::OpName) || (op == spv::OpMemberName)) {
+            res = i + 1;
+        }
+    }
+    return (res == -1) ? annotations_begin() : res;
+}
+
+const Inst* Module::type_def(uint32_t id) const {
+    for (const Inst& inst: insts) {
+        const uint32_t op = opcode(inst);
+        if (op == spv::OpFunction) {
+            break;
+        }
+        if ((inst.size() >= 2) && ((op >= spv::OpTypeInt) && (op <= spv::OpTypePointer)) && (inst[1] == id)) {
+            return &inst;
+        }
+    }
+    return nullptr;
+}
+
+// number of locations used by a varying of a type, 0 if unknown
+int Module::num_locations(uint32_t type_id) const {
+    const Inst* type = type_def(type_id);
+    if (!type) {
+        return 0;
+    }
+    switch (opcode(*type)) {
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+            return 1;
+        case spv::OpTypeVector: {
+            // 64-bit 3- and 4-component vectors use 2 locations
+            const Inst* comp_type = type_def((*type)[2]);
+            const bool is_64bit = comp_type && ((*comp_type)[2] == 64);
+            return (is_64bit && ((*type)[3] > 2)) ? 2 : 1;
+        }
+        case spv::OpTypeMatrix:
+            return (int)(*type)[3] * num_locations((*type)[2]);
+        case spv::OpTypeArray:
+            for (const Inst& inst: insts) {
+                if ((opcode(inst) == spv::OpConstant) && (inst[2] == (*type)[3])) {
+                    return (int)inst[3] * num_locations((*type)[2]);
+                }
+            }
+            return 0;
+        case spv::OpTypeStruct: {
+            int res = 0;
+            for (size_t i = 2; i < type->size(); i++) {
+                const int n = num_locations((*type)[i]);
+                if (n == 0) {
+                    return 0;
+                }
+                res += n;
+            }
+            return res;
+        }
+        default:
+            return 0;
+    }
+}
+
+uint32_t Module::pointer_type(uint32_t storage_class, uint32_t type) {
+    for (const Inst& inst: insts) {
+        if ((opcode(inst) == spv::OpTypePointer) && (inst[2] == storage_class) && (inst[3] == type)) {
+            return inst[1];
+        }
+    }
+    const uint32_t id = new_id();
+    insts.insert(insts.begin() + globals_end(), make_inst(spv::OpTypePointer, { id, storage_class, type }));
+    return id;
+}
+
+uint32_t Module::vector_type(uint32_t comp_type, uint32_t num_components) {
+    for (const Inst& inst: insts) {
+        if ((opcode(inst) == spv::OpTypeVector) && (inst[2] == comp_type) && (inst[3] == num_components)) {
+            return inst[1];
+        }
+    }
+    const uint32_t id = new_id();
+    insts.insert(insts.begin() + globals_end(), make_inst(spv::OpTypeVector, { id, comp_type, num_components }));
+    return id;
+}
+
+uint32_t Module::entry_function() const {
+    for (const Inst& inst: insts) {
+        if (opcode(inst) == spv::OpEntryPoint) {
+            return inst[2];
+        }
+    }
+    return 0;
+}
+
+// OpEntryPoint: execution model, function id, name string, interface ids
+void Module::remove_from_interface(uint32_t id) {
+    for (Inst& inst: insts) {
+        if (opcode(inst) == spv::OpEntryPoint) {
+            const size_t first = 3 + string_words(inst, 3);
+            Inst res(inst.begin(), inst.begin() + first);
+            for (size_t i = first; i < inst.size(); i++) {
+                if (inst[i] != id) {
+                    res.push_back(inst[i]);
+                }
+            }
+            res[0] = (uint32_t)(res.size() << 16) | spv::OpEntryPoint;
+            inst = res;
+        }
+    }
+}
+
+void Module::add_to_interface(uint32_t id) {
+    for (Inst& inst: insts) {
+        if (opcode(inst) == spv::OpEntryPoint) {
+            inst.push_back(id);
+            inst[0] = (uint32_t)(inst.size() << 16) | spv::OpEntryPoint;
+        }
+    }
+}
+
+// a vertex shader output or fragment shader input with a location
+struct Varying {
+    uint32_t var_id = 0;
+    uint32_t type_id = 0;           // the variable's value type
+    uint32_t float_type_id = 0;     // the component type of float scalars and vectors
+    int num_components = 0;         // 1..4 for float scalars and vectors, 0 otherwise (not packable)
+    int num_locations = 0;          // number of locations used (matrices and arrays use several), 0 if unknown
+    uint32_t interp = 0;            // bitmask of interpolation decorations
+    bool has_component = false;     // already has a Component decoration
+    bool read = false;              // loaded from or accessed anywhere
+    bool rewritable = true;         // only used by load, store and access chain instructions
+};
+
+static std::map<int, Varying> gather_varyings(const Module& m, uint32_t storage_class) {
+    std::map<int, Varying> res;
+    std::map<uint32_t, int> locations;
+    std::map<uint32_t, uint32_t> interps;
+    std::set<uint32_t> components;
+    for (const Inst& inst: m.insts) {
+        if ((opcode(inst) == spv::OpDecorate) && (inst.size() >= 3)) {
+            if ((inst[2] == spv::DecorationLocation) && (inst.size() >= 4)) {
+                locations[inst[1]] = (int)inst[3];
+            } else if (inst[2] == spv::DecorationComponent) {
+                components.insert(inst[1]);
+            } else if (is_interp_decoration(inst[2])) {
+                interps[inst[1]] |= (1 << inst[2]);
+            }
+        }
+    }
+    for (const Inst& inst: m.insts) {
+        const uint32_t op = opcode(inst);
+        if (op == spv::OpFunction) {
+            break;
+        }
+        if ((op != spv::OpVariable) || (inst[3] != storage_class) || (locations.count(inst[2]) == 0)) {
+            continue;
+        }
+        Varying v;
+        v.var_id = inst[2];
+        const Inst* ptr_type = m.type_def(inst[1]);
+        if (ptr_type && (opcode(*ptr_type) == spv::OpTypePointer)) {
+            v.type_id = (*ptr_type)[3];
+            v.num_locations = m.num_locations(v.type_id);
+            const Inst* type = m.type_def(v.type_id);
+            if (type && (opcode(*type) == spv::OpTypeFloat) && ((*type)[2] == 32)) {
+                v.float_type_id = v.type_id;
+                v.num_components = 1;
+            } else if (type && (opcode(*type) == spv::OpTypeVector)) {
+                const Inst* comp_type = m.type_def((*type)[2]);
+                if (comp_type && (opcode(*comp_type) == spv::OpTypeFloat) && ((*comp_type)[2] == 32)) {
+                    v.float_type_id = (*type)[2];
+                    v.num_components = (int)(*type)[3];
+                }
+            }
+        }
+        v.interp = interps[v.var_id];
+        v.has_component = components.count(v.var_id) > 0;
+        res[locations[v.var_id]] = v;
+    }
+    // find all uses of the variables and pointers derived from them
+    std::map<uint32_t, int> tracked;
+    for (const auto& item: res) {
+        tracked[item.second.var_id] = item.first;
+    }
+    bool in_function = false;
+    for (const Inst& inst: m.insts) {
+        const uint32_t op = opcode(inst);
+        if (op == spv::OpFunction) {
+            in_function = true;
+        }
+        if (!in_function) {
+            continue;
+        }
+        size_t first_other = 1;
+        if ((op == spv::OpLoad) && (tracked.count(inst[3]) > 0)) {
+            res[tracked[inst[3]]].read = true;
+            first_other = 4;
+        } else if ((op == spv::OpStore) && (tracked.count(inst[1]) > 0)) {
+            first_other = 2;
+        } else if (((op == spv::OpAccessChain) || (op == spv::OpInBoundsAccessChain)) && (tracked.count(inst[3]) > 0)) {
+            const int loc = tracked[inst[3]];
+            res[loc].read = true;
+            tracked[inst[2]] = loc;
+            first_other = 4;
+        }
+        for (size_t i = first_other; i < inst.size(); i++) {
+            if (tracked.count(inst[i]) > 0) {
+                Varying& v = res[tracked[inst[i]]];
+                v.read = true;
+                v.rewritable = false;
+            }
+        }
+    }
+    return res;
+}
+
+// turn an interface variable into a private variable, this removes the variable
+// from the shader interface, but keeps all code which accesses the variable valid
+static void make_private(Module& m, const Varying& v, uint32_t storage_class) {
+    // collect the pointer types of access chains rooted at the variable
+    std::set<uint32_t> tracked = { v.var_id };
+    std::set<uint32_t> chain_types;
+    bool in_function = false;
+    for (const Inst& inst: m.insts) {
+        const uint32_t op = opcode(inst);
+        in_function |= (op == spv::OpFunction);
+        if (in_function && ((op == spv::OpAccessChain) || (op == spv::OpInBoundsAccessChain)) && (tracked.count(inst[3]) > 0)) {
+            tracked.insert(inst[2]);
+            chain_types.insert(inst[1]);
+        }
+    }
+    std::map<uint32_t, uint32_t> private_types;
+    for (uint32_t type: chain_types) {
+        const Inst* ptr_type = m.type_def(type);
+        if (ptr_type && (opcode(*ptr_type) == spv::OpTypePointer)) {
+            const uint32_t pointee = (*ptr_type)[3];
+            private_types[type] = m.pointer_type(spv::StorageClassPrivate, pointee);
+        }
+    }
+    const uint32_t var_type = m.pointer_type(spv::StorageClassPrivate, v.type_id);
+
+    // move the variable declaration behind all (new) types
+    for (size_t i = 0; i < m.insts.size(); i++) {
+        const Inst& inst = m.insts[i];
+        if ((opcode(inst) == spv::OpVariable) && (inst[2] == v.var_id) && (inst[3] == storage_class)) {
+            m.insts.erase(m.insts.begin() + i);
+            break;
+        }
+    }
+    m.insts.insert(m.insts.begin() + m.globals_end(), make_inst(spv::OpVariable, { var_type, v.var_id, spv::StorageClassPrivate }));
+
+    // private variables can't have interface decorations
+    m.insts.erase(std::remove_if(m.insts.begin(), m.insts.end(), [&v](const Inst& inst) {
+        return (opcode(inst) == spv::OpDecorate) && (inst[1] == v.var_id) &&
+            ((inst[2] == spv::DecorationLocation) || (inst[2] == spv::DecorationComponent) || is_interp_decoration(inst[2]));
+    }), m.insts.end());
+    m.remove_from_interface(v.var_id);
+
+    // patch the result types of access chains
+    in_function = false;
+    for (Inst& inst: m.insts) {
+        const uint32_t op = opcode(inst);
+        in_function |= (op == spv::OpFunction);
+        if (in_function && ((op == spv::OpAccessChain) || (op == spv::OpInBoundsAccessChain)) && (tracked.count(inst[2]) > 0)) {
+            if (private_types.count(inst[1]) > 0) {
+                inst[1] = private_types[inst[1]];
+            }
+        }
+    }
+}
+
+static void set_location(Module& m, uint32_t var_id, int location) {
+    for (Inst& inst: m.insts) {
+        if ((opcode(inst) == spv::OpDecorate) && (inst[1] == var_id) && (inst[2] == spv::DecorationLocation)) {
+            inst[3] = (uint32_t)location;
+        }
+    }
+}
+
+static Inst make_name(uint32_t id, const std::string& name) {
+    std::vector<uint32_t> operands = { id };
+    const size_t num_words = (name.length() / 4) + 1;
+    for (size_t w = 0; w < num_words; w++) {
+        uint32_t word = 0;
+        for (size_t b = 0; b < 4; b++) {
+            const size_t i = w * 4 + b;
+            if (i < name.length()) {
+                word |= ((uint32_t)(uint8_t)name[i]) << (b * 8);
+            }
+        }
+        operands.push_back(word);
+    }
+    return make_inst(spv::OpName, operands);
+}
+
+// a location after optimization, either a single varying or several packed varyings
+struct Slot {
+    std::vector<int> locations;     // original locations, in component order
+    std::vector<int> components;    // number of components of each varying
+    int num_components = 0;
+    int num_locations = 1;
+    uint32_t interp = 0;
+};
+
+// replace the varyings of a packed slot with a single vector variable, and copy
+// the original (now private) variables from or to the packed variable
+static void pack_slot(Module& m, const std::map<int, Varying>& vars, const Slot& slot, int location, uint32_t storage_class) {
+    const Varying* first = nullptr;
+    for (int loc: slot.locations) {
+        if (vars.count(loc) > 0) {
+            first = &vars.at(loc);
+            break;
+        }
+    }
+    if (!first) {
+        // a fragment shader which doesn't use any of the packed varyings
+        return;
+    }
+    const uint32_t vec_type = m.vector_type(first->float_type_id, (uint32_t)slot.num_components);
+    const uint32_t ptr_type = m.pointer_type(storage_class, vec_type);
+    for (int loc: slot.locations) {
+        if (vars.count(loc) > 0) {
+            make_private(m, vars.at(loc), storage_class);
+        }
+    }
+    const uint32_t packed_id = m.new_id();
+    m.insts.insert(m.insts.begin() + m.globals_end(), make_inst(spv::OpVariable, { ptr_type, packed_id, storage_class }));
+    m.insts.insert(m.insts.begin() + m.annotations_begin(), make_inst(spv::OpDecorate, { packed_id, spv::DecorationLocation, (uint32_t)location }));
+    for (uint32_t dec = 0; dec < 32; dec++) {
+        if (slot.interp & (1 << dec)) {
+            m.insts.insert(m.insts.begin() + m.annotations_begin(), make_inst(spv::OpDecorate, { packed_id, dec }));
+        }
+    }
+    // the same name in both shader stages, GLSL links varyings by name
+    m.insts.insert(m.insts.begin() + m.names_end(), make_name(packed_id, fmt::format("packed_varying{}", location)));
+    m.add_to_interface(packed_id);
+
+    // find the entry function
+    const uint32_t entry_id = m.entry_function();
+    size_t func_begin = 0;
+    while ((func_begin < m.insts.size()) && !((opcode(m.insts[func_begin]) == spv::OpFunction) && (m.insts[func_begin][2] == entry_id))) {
+        func_begin++;
+    }
+    if (storage_class == spv::StorageClassOutput) {
+        // vertex shader: write the packed output before each return from the entry function
+        for (size_t i = func_begin; (i < m.insts.size()) && (opcode(m.insts[i]) != spv::OpFunctionEnd); i++) {
+            if (opcode(m.insts[i]) != spv::OpReturn) {
+                continue;
+            }
+            std::vector<Inst> code;
+            std::vector<uint32_t> construct = { vec_type, m.new_id() };
+            for (int loc: slot.locations) {
+                const Varying& v = vars.at(loc);
+                const uint32_t value_id = m.new_id();
+                code.push_back(make_inst(spv::OpLoad, { v.type_id, value_id, v.var_id }));
+                construct.push_back(value_id);
+            }
+            code.push_back(make_inst(spv::OpCompositeConstruct, construct));
+            code.push_back(make_inst(spv::OpStore, { packed_id, construct[1] }));
+            m.insts.insert(m.insts.begin() + i, code.begin(), code.end());
+            i += code.size();
+        }
+    } else {
+        // fragment shader: read the packed input at the start of the entry function,
+        // behind the function-local variable declarations of the first block
+        size_t i = func_begin;
+        while ((i < m.insts.size()) && (opcode(m.insts[i]) != spv::OpLabel)) {
+            i++;
+        }
+        i++;
+        while ((i < m.insts.size()) && (opcode(m.insts[i]) == spv::OpVariable)) {
+            i++;
+        }
+        std::vector<Inst> code;
+        const uint32_t packed_value_id = m.new_id();
+        code.push_back(make_inst(spv::OpLoad, { vec_type, packed_value_id, packed_id }));
+        uint32_t comp = 0;
+        for (size_t member = 0; member < slot.locations.size(); member++) {
+            const int loc = slot.locations[member];
+            if (vars.count(loc) == 0) {
+                // not all fragment shaders need to use all varyings
+                comp += (uint32_t)slot.components[member];
+                continue;
+            }
+            const Varying& v = vars.at(loc);
+            const uint32_t value_id = m.new_id();
+            if (v.num_components == 1) {
+                code.push_back(make_inst(spv::OpCompositeExtract, { v.type_id, value_id, packed_value_id, comp }));
+            } else {
+                std::vector<uint32_t> shuffle = { v.type_id, value_id, packed_value_id, packed_value_id };
+                for (int c = 0; c < v.num_components; c++) {
+                    shuffle.push_back(comp + (uint32_t)c);
+                }
+                code.push_back(make_inst(spv::OpVectorShuffle, shuffle));
+            }
+            code.push_back(make_inst(spv::OpStore, { v.var_id, value_id }));
+            comp += (uint32_t)v.num_components;
+        }
+        m.insts.insert(m.insts.begin() + i, code.begin(), code.end());
+    }
+}
+
+// optimize the varyings of a group of vertex- and fragment-shaders which are linked with each other
+static bool optimize_group(std::vector<Module*>& vs_modules, std::vector<Module*>& fs_modules) {
+    std::vector<std::map<int, Varying>> vs_vars;
+    std::vector<std::map<int, Varying>> fs_vars;
+    for (Module* m: vs_modules) {
+        vs_vars.push_back(gather_varyings(*m, spv::StorageClassOutput));
+    }
+    for (Module* m: fs_modules) {
+        fs_vars.push_back(gather_varyings(*m, spv::StorageClassInput));
+    }
+
+    // all fragment shader inputs must be provided by all vertex shaders, and all
+    // varyings must be of the same type, otherwise leave the error reporting to
+    // the linking validation
+    std::set<int> locations;
+    std::set<int> live;
+    for (const auto& vars: vs_vars) {
+        for (const auto& item: vars) {
+            locations.insert(item.first);
+        }
+    }
+    for (const auto& vars: fs_vars) {
+        for (const auto& item: vars) {
+            if (locations.count(item.first) == 0) {
+                return false;
+            }
+            if (item.second.read) {
+                live.insert(item.first);
+            }
+        }
+    }
+    std::map<int, const Varying*> first_var;
+    for (const auto* group: { &vs_vars, &fs_vars }) {
+        for (const auto& vars: *group) {
+            for (const auto& item: vars) {
+                const Varying& v = item.second;
+                if (v.has_component || !v.rewritable || (v.num_locations == 0)) {
+                    return false;
+                }
+                if (first_var.count(item.first) == 0) {
+                    first_var[item.first] = &v;
+                } else if ((first_var[item.first]->num_components != v.num_components) || (first_var[item.first]->num_locations != v.num_locations)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // all vertex shaders must write all live varyings
+    for (const auto& vars: vs_vars) {
+        for (int loc: live) {
+            if (vars.count(loc) == 0) {
+                return false;
+            }
+        }
+    }
+
+    // interpolation decorations are taken from the fragment shaders, and must match
+    std::map<int, uint32_t> interp;
+    std::set<int> unpackable;
+    for (const auto& vars: fs_vars) {
+        for (const auto& item: vars) {
+            if ((interp.count(item.first) > 0) && (interp[item.first] != item.second.interp)) {
+                unpackable.insert(item.first);
+            }
+            interp[item.first] = item.second.interp;
+        }
+    }
+
+    // pack scalar, vec2 and vec3 float varyings with the same interpolation
+    // (first-fit, biggest first)
+    std::vector<int> candidates;
+    std::vector<Slot> slots;
+    for (int loc: live) {
+        const int n = first_var[loc]->num_components;
+        if ((n >= 1) && (n <= 3) && (unpackable.count(loc) == 0)) {
+            candidates.push_back(loc);
+        } else {
+            Slot slot;
+            slot.locations.push_back(loc);
+            slot.components.push_back(n);
+            slot.num_components = n;
+            slot.num_locations = first_var[loc]->num_locations;
+            slots.push_back(slot);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&first_var](int a, int b) {
+        return first_var[a]->num_components > first_var[b]->num_components;
+    });
+    std::vector<Slot> bins;
+    for (int loc: candidates) {
+        const int n = first_var[loc]->num_components;
+        bool placed = false;
+        for (Slot& bin: bins) {
+            if ((bin.interp == interp[loc]) && ((bin.num_components + n) <= 4)) {
+                bin.locations.push_back(loc);
+                bin.components.push_back(n);
+                bin.num_components += n;
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) {
+            Slot bin;
+            bin.locations.push_back(loc);
+            bin.components.push_back(n);
+            bin.num_components = n;
+            bin.interp = interp[loc];
+            bins.push_back(bin);
+        }
+    }
+    slots.insert(slots.end(), bins.begin(), bins.end());
+    std::sort(slots.begin(), slots.end(), [](const Slot& a, const Slot& b) {
+        return *std::min_element(a.locations.begin(), a.locations.end()) < *std::min_element(b.locations.begin(), b.locations.end());
+    });
+
+    // assign the new locations, matrices and arrays use several consecutive locations
+    std::vector<int> slot_locations;
+    bool changed = live.size() != locations.size();
+    int next_loc = 0;
+    for (const Slot& slot: slots) {
+        if ((slot.locations.size() > 1) || (slot.locations[0] != next_loc)) {
+            changed = true;
+        }
+        slot_locations.push_back(next_loc);
+        next_loc += slot.num_locations;
+    }
+    if (!changed) {
+        return false;
+    }
+
+    // apply to all vertex- and fragment-shaders
+    for (int stage = 0; stage < 2; stage++) {
+        std::vector<Module*>& modules = (stage == 0) ? vs_modules : fs_modules;
+        const std::vector<std::map<int, Varying>>& all_vars = (stage == 0) ? vs_vars : fs_vars;
+        const uint32_t storage_class = (stage == 0) ? spv::StorageClassOutput : spv::StorageClassInput;
+        for (size_t i = 0; i < modules.size(); i++) {
+            Module& m = *modules[i];
+            const std::map<int, Varying>& vars = all_vars[i];
+            for (const auto& item: vars) {
+                if (live.count(item.first) == 0) {
+                    make_private(m, item.second, storage_class);
+                }
+            }
+            for (int slot_index = 0; slot_index < (int)slots.size(); slot_index++) {
+                const Slot& slot = slots[slot_index];
+                if (slot.locations.size() == 1) {
+                    if (vars.count(slot.locations[0]) > 0) {
+                        set_location(m, vars.at(slot.locations[0]).var_id, slot_locations[slot_index]);
+                    }
+                } else {
+                    pack_slot(m, vars, slot, slot_locations[slot_index], storage_class);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static int find_root(std::map<int, int>& parents, int index) {
+    while (parents[index] != index) {
+        index = parents[index];
+    }
+    return index;
+}
+
+std::vector<int> Varyings::optimize(const Input& inp, std::vector<SpirvBlob>& inout_blobs) {
+    std::vector<int> modified;
+
+    // group all vertex- and fragment-shaders which are linked with each other
+    // through @program definitions (a vertex shader may be used with several
+    // fragment shaders and the other way around)
+    std::map<int, int> blob_by_snippet;
+    for (int i = 0; i < (int)inout_blobs.size(); i++) {
+        blob_by_snippet[inout_blobs[i].snippet_index] = i;
+    }
+    std::map<int, int> parents;
+    for (const auto& item: inp.programs) {
+        const Program& prog = item.second;
+        if (!prog.has_vs_fs()) {
+            continue;
+        }
+        const int vs_index = inp.snippet_map.at(prog.vs_name);
+        const int fs_index = inp.snippet_map.at(prog.fs_name);
+        if ((blob_by_snippet.count(vs_index) == 0) || (blob_by_snippet.count(fs_index) == 0)) {
+            // a compilation error occurred
+            return modified;
+        }
+        if (parents.count(vs_index) == 0) {
+            parents[vs_index] = vs_index;
+        }
+        if (parents.count(fs_index) == 0) {
+            parents[fs_index] = fs_index;
+        }
+        parents[find_root(parents, fs_index)] = find_root(parents, vs_index);
+    }
+    std::map<int, std::vector<int>> groups;
+    for (const auto& item: parents) {
+        groups[find_root(parents, item.first)].push_back(item.first);
+    }
+
+    for (const auto& group: groups) {
+        std::vector<int> blob_indices;
+        std::vector<Module> modules(group.second.size());
+        std::vector<Module*> vs_modules;
+        std::vector<Module*> fs_modules;
+        bool valid = true;
+        for (size_t i = 0; i < group.second.size(); i++) {
+            const int snippet_index = group.second[i];
+            const int blob_index = blob_by_snippet[snippet_index];
+            blob_indices.push_back(blob_index);
+            valid &= modules[i].parse(inout_blobs[blob_index].bytecode);
+            if (inp.snippets[snippet_index].type == Snippet::VS) {
+                vs_modules.push_back(&modules[i]);
+            } else {
+                fs_modules.push_back(&modules[i]);
+            }
+        }
+        if (valid && optimize_group(vs_modules, fs_modules)) {
+            for (size_t i = 0; i < modules.size(); i++) {
+                inout_blobs[blob_indices[i]].bytecode = modules[i].words();
+                modified.push_back(blob_indices[i]);
+            }
+        }
+    }
+    return modified;
+}
+
+} // namespace shdc
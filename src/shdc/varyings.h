@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+#include "input.h"
+#include "types/spirv_blob.h"
+
+namespace shdc {
+
+// cross-stage optimization of the vertex shader outputs and fragment shader inputs
+// of all vertex-/fragment-shader pairs in the @program definitions
+struct Varyings {
+    // remove varyings which are never read by any fragment shader, and pack
+    // scalar, vec2 and vec3 float varyings into fewer locations, returns the
+    // indices of all modified blobs (which need to run through the optimizer again)
+    static std::vector<int> optimize(const Input& inp, std::vector<SpirvBlob>& inout_blobs);
+};
+
+} // namespace shdc
@@ -0,0 +1,52 @@
+// round-trip test for --minify: local variables which are shadowed by
+// for-loop variables, and comparisons which follow global var<...>
+// declarations in the WGSL output
+@vs vs
+layout(binding=0) uniform vs_params {
+    mat4 mvp;
+    vec4 weights[4];
+};
+
+in vec4 position;
+in vec2 texcoord0;
+
+out vec2 uv;
+out float weight;
+
+void main() {
+    int i = 3;
+    float acc = 0.0;
+    for (int i = 0; i < 4; i++) {
+        acc += weights[i].x;
+    }
+    for (int i = 0; i < 2; i++) acc += weights[i].y;
+    gl_Position = mvp * position;
+    uv = texcoord0;
+    weight = acc + weights[i].z;
+}
+@end
+
+@fs fs
+layout(binding=0) uniform texture2D tex;
+layout(binding=0) uniform sampler smp;
+
+in vec2 uv;
+in float weight;
+
+out vec4 frag_color;
+
+float scale = 2.0;
+
+void main() {
+    float a = weight * scale;
+    float b = uv.x;
+    bool c = a > b;
+    vec4 color = texture(sampler2D(tex, smp), uv);
+    for (int i = 0; i < 2; i++) {
+        color.rgb *= c ? 0.5 : 1.0;
+    }
+    frag_color = color;
+}
+@end
+
+@program minify vs fs
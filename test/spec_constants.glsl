@@ -0,0 +1,54 @@
+// compile with e.g. --spec=num_lights=2:use_fog=true to test frozen
+// specialization constants, also at --opt-level=0 and for wgsl
+@vs vs
+layout(binding=0) uniform vs_params {
+    mat4 mvp;
+};
+
+in vec4 position;
+in vec3 normal;
+
+out vec3 nrm;
+out float depth;
+
+void main() {
+    gl_Position = mvp * position;
+    nrm = normal;
+    depth = gl_Position.z;
+}
+@end
+
+@fs fs
+layout(constant_id=0) const int num_lights = 4;
+layout(constant_id=1) const bool use_fog = false;
+layout(constant_id=2) const float fog_density = 0.05;
+
+// spec constant ops which depend on the spec constants above
+const int max_light = num_lights - 1;
+const bool no_fog = !use_fog;
+
+layout(binding=1) uniform fs_params {
+    vec4 light_dir[8];
+    vec4 light_color[8];
+    vec4 fog_color;
+};
+
+in vec3 nrm;
+in float depth;
+
+out vec4 frag_color;
+
+void main() {
+    vec3 n = normalize(nrm);
+    vec3 color = vec3(0.0);
+    for (int i = 0; i <= max_light; i++) {
+        color += max(dot(n, light_dir[i].xyz), 0.0) * light_color[i].rgb;
+    }
+    if (!no_fog) {
+        color = mix(color, fog_color.rgb, 1.0 - exp(-fog_density * depth));
+    }
+    frag_color = vec4(color, 1.0);
+}
+@end
+
+@program spec_constants vs fs
@@ -0,0 +1,49 @@
+@vs vs
+layout(binding=0) uniform vs_params {
+    mat4 mvp;
+    mat4 model;
+};
+
+in vec4 position;
+in vec3 normal;
+in vec3 tangent;
+in vec2 texcoord0;
+
+out vec3 world_pos;
+out mat3 tbn;
+out vec2 uv;
+out float fog;
+out float unused;
+
+void main() {
+    gl_Position = mvp * position;
+    world_pos = (model * position).xyz;
+    vec3 n = normalize(mat3(model) * normal);
+    vec3 t = normalize(mat3(model) * tangent);
+    tbn = mat3(t, cross(n, t), n);
+    uv = texcoord0;
+    fog = clamp(gl_Position.z * 0.01, 0.0, 1.0);
+    unused = position.w;
+}
+@end
+
+@fs fs
+layout(binding=0) uniform texture2D normal_tex;
+layout(binding=0) uniform sampler smp;
+
+in vec3 world_pos;
+in mat3 tbn;
+in vec2 uv;
+in float fog;
+in float unused;
+
+out vec4 frag_color;
+
+void main() {
+    vec3 n = normalize(tbn * (texture(sampler2D(normal_tex, smp), uv).xyz * 2.0 - 1.0));
+    float l = max(dot(n, normalize(-world_pos)), 0.0);
+    frag_color = vec4(mix(vec3(l), vec3(0.5), fog), 1.0);
+}
+@end
+
+@program varyings_matrix vs fs